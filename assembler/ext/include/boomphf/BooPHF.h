@@ -273,6 +273,13 @@ class bitVector {
         return _bitArray[cell64];
     }
 
+    // prefetch everything needed to answer get / rank at pos
+    void prefetch(uint64_t pos) const {
+        __builtin_prefetch(_bitArray + (pos >> 6ULL));
+        if (!_ranks.empty())
+            __builtin_prefetch(_ranks.data() + pos / _nb_bits_per_rank_sample);
+    }
+
     //set bit pos to 1
     void set(uint64_t pos) {
         assert(pos<_size);
@@ -366,6 +373,10 @@ class level{
         return bitset.get(hashi);
     }
 
+    void prefetch(uint64_t hash_raw) const {
+        bitset.prefetch(fastrange64(hash_raw, hash_domain));
+    }
+
     uint64_t hash_domain;
     bitVector bitset;
 };
@@ -462,6 +473,18 @@ class mphf {
     }
 
 
+    // Batched lookups: compute the hash first, prefetch the first level
+    // (where most of the keys end up) and then pass the hash to lookup().
+    template<class elem_t>
+    hash_pair_t hash(const elem_t &elem) const {
+        return _hasher.hashpair128(elem);
+    }
+
+    void prefetch(const hash_pair_t &bbhash) const {
+        if (_built)
+            _levels[0].prefetch(bbhash[0]);
+    }
+
     template<class elem_t>
     uint64_t lookup(const elem_t &elem) const {
         if (!_built) return NOT_FOUND;
@@ -17,12 +17,15 @@ class cqf {
     /// The hash digest type.
     typedef uint64_t digest;
 
+    /// The remainder width of a freshly sized CQF.
+    static const unsigned DEFAULT_REMAINDER_BITS = 8;
+
     ~cqf() { qf_destroy(&qf_); }
 
     cqf(uint64_t maxn)
             : insertions_(0) {
         unsigned qbits = std::max(7u, unsigned(ceil(log2(double(maxn))))) + 1;
-        num_hash_bits_ = qbits + 8;
+        num_hash_bits_ = qbits + DEFAULT_REMAINDER_BITS;
         num_slots_ = (1ULL << qbits);
         qf_init(&qf_, num_slots_, num_hash_bits_, 0, 42);
         range_mask_ = qf_.metadata->range - 1;
@@ -47,7 +50,10 @@ class cqf {
         return res;
     }
 
+    // Every expansion moves a hash bit from the remainder to the quotient, so
+    // the false positive rate doubles
     void expand() {
+        assert(remainder_bits() > 2);
         // Create new QF having the same hash bits, but double the slots
         QF nqf;
         qf_init(&nqf, 2 * num_slots_, num_hash_bits_, 0, 239);
@@ -59,6 +65,17 @@ class cqf {
         num_slots_ = 2 * num_slots_;
     }
 
+    // Drops everything and starts over with the new geometry
+    void reset(uint64_t num_slots, unsigned hash_bits) {
+        qf_destroy(&qf_);
+        num_hash_bits_ = hash_bits;
+        num_slots_ = num_slots;
+        insertions_ = 0;
+        qf_init(&qf_, num_slots_, num_hash_bits_, 0, 239);
+        range_mask_ = qf_.metadata->range - 1;
+        assert((range_mask_ & qf_.metadata->range) == 0);
+    }
+
     void merge(cqf &other) {
         merge(&qf_, &other.qf_);
         other.clear();
@@ -75,6 +92,7 @@ class cqf {
 
     size_t insertions() const { return insertions_; }
     unsigned hash_bits() const { return num_hash_bits_; }
+    unsigned remainder_bits() const { return unsigned(qf_.metadata->key_remainder_bits); }
     uint64_t range_mask() const { return range_mask_; }
     uint64_t slots() const { return num_slots_; }
     uint64_t occupied_slots() const { return qf_.metadata->noccupied_slots; }
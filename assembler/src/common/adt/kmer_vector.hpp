@@ -44,7 +44,7 @@ public:
               vector_(realloc(), size_, el_sz_) {
     }
 
-    KMerVector(KMerVector &&that)
+    KMerVector(KMerVector &&that) noexcept
             : K_(that.K_), size_(that.size_), capacity_(that.capacity_), el_sz_(that.el_sz_),
               storage_(that.storage_),
               vector_(storage_, size_, el_sz_) {
@@ -113,6 +113,17 @@ public:
         vector_.set_size(size_);
     }
 
+    void swap(KMerVector &that) {
+        std::swap(size_, that.size_);
+        std::swap(capacity_, that.capacity_);
+        std::swap(storage_, that.storage_);
+
+        vector_.set_data(storage_);
+        vector_.set_size(size_);
+        that.vector_.set_data(that.storage_);
+        that.vector_.set_size(that.size_);
+    }
+
     void shrink(size_t sz) {
         size_ = sz;
         vector_.set_size(size_);
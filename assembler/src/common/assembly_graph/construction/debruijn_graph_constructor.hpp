@@ -264,6 +264,39 @@ private:
         return {s};
     }
 
+    void CleanCondensed(const std::vector<Sequence> &sequences) {
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < sequences.size(); ++i) {
+            CleanCondensed(sequences[i]);
+            CleanCondensed(!sequences[i]);
+        }
+    }
+
+public:
+    UnbranchingPathExtractor(Index &origin, size_t k)
+            : origin_(origin), kmer_size_(k) {}
+
+    // Counts the edges leaving the junctions. Every unbranching path but the
+    // perfect loops starts with such an edge and its conjugate starts with
+    // another one (the same one for self-conjugate paths), so this is exactly
+    // the number of the graph edges the paths give rise to.
+    size_t CountStartEdges(unsigned nchunks) const {
+        auto its = origin_.kmer_begin(nchunks);
+
+        size_t res = 0;
+#       pragma omp parallel for schedule(guided) reduction(+ : res)
+        for (size_t i = 0; i < its.size(); ++i) {
+            std::vector<DeEdge> start_edges;
+            start_edges.reserve(8);
+            for (auto &it = its[i]; it.good(); ++it) {
+                AddStartDeEdges(origin_.ConstructKWH(Kmer(kmer_size_, *it)), start_edges);
+                res += start_edges.size();
+            }
+        }
+        return res;
+    }
+
+    // Extracts the paths starting from the junctions of the chunk of the index
     void CalculateSequences(kmer_iterator &it,
                             std::vector<Sequence> &sequences) const {
         SequenceBuilder builder;
@@ -285,6 +318,8 @@ private:
         }
     }
 
+    // Isolates all k-mers of the condensed sequence, so they won't be visited
+    // once again while searching for the perfect loops
     void CleanCondensed(const Sequence &sequence) {
         Kmer kmer = sequence.start<Kmer>(kmer_size_);
         KeyWithHash kwh = origin_.ConstructKWH(kmer);
@@ -295,14 +330,6 @@ private:
         }
     }
 
-    void CleanCondensed(const std::vector<Sequence> &sequences) {
-#       pragma omp parallel for schedule(guided)
-        for (size_t i = 0; i < sequences.size(); ++i) {
-            CleanCondensed(sequences[i]);
-            CleanCondensed(!sequences[i]);
-        }
-    }
-
     // This methods collects all loops that were not extracted by finding
     // unbranching paths because there are no junctions on loops.
     const std::vector<Sequence> CollectLoops(unsigned nchunks) {
@@ -343,10 +370,6 @@ private:
         return result;
     }
 
-public:
-    UnbranchingPathExtractor(Index &origin, size_t k)
-            : origin_(origin), kmer_size_(k) {}
-
     //TODO very large vector is returned. But I hate to make all those artificial changes that can fix it.
     const std::vector<Sequence> ExtractUnbranchingPaths(unsigned nchunks) const {
         auto its = origin_.kmer_begin(nchunks);
@@ -396,6 +419,9 @@ private:
     typedef utils::DeBruijnExtensionIndex<> Index;
     size_t kmer_size_;
     Index &origin_;
+    // Vertices are created independently for the ranges of k-mer hashes
+    size_t nbuckets_;
+    size_t bucket_width_;
 
     class LinkRecord {
     private:
@@ -413,7 +439,6 @@ private:
         bool IsRC() const { return hash_and_mask_ & 2; }
         bool IsStart() const { return hash_and_mask_ & 1; }
         EdgeId GetEdge() const { return edge_; }
-        bool IsInvalid() { return hash_and_mask_ + 1 == 0 && edge_ == EdgeId(); }
 
         LinkRecord(size_t hash, EdgeId edge, bool is_start, bool is_rc)
                 : hash_and_mask_((hash << 2) | (BitBool(is_rc) << 1)| BitBool(is_start)), edge_(edge) { }
@@ -429,6 +454,13 @@ private:
         }
     };
 
+    // Link records of the chunk of edges grouped by the hash buckets, the
+    // records of bucket b are [offsets[b], offsets[b + 1])
+    struct LinkRecordChunk {
+        std::vector<LinkRecord> records;
+        std::vector<size_t> offsets;
+    };
+
     LinkRecord StartLink(const EdgeId &edge, const Sequence &sequence) const {
         Kmer kmer(kmer_size_, sequence);
         Kmer kmer_rc = !kmer;
@@ -447,21 +479,55 @@ private:
             return LinkRecord(origin_.ConstructKWH(kmer_rc).idx(), edge, false, true);
     }
 
-    void CollectLinkRecords(typename Graph::HelperT &helper, const Graph &graph,
-                            std::vector<LinkRecord> &records, const std::vector<Sequence> &sequences) const {
-        size_t size = sequences.size();
-        uint64_t min_id = graph.min_id();
-        records.resize(size * 2, LinkRecord(0, EdgeId(), false, false));
-#       pragma omp parallel for schedule(guided)
-        for (size_t i = 0; i < size; ++i) {
-            size_t j = i << 1;
-            EdgeId edge = helper.AddEdge(DeBruijnEdgeData(sequences[i]), min_id + j);
-            records[j] = StartLink(edge, sequences[i]);
-            if (graph.conjugate(edge) != edge)
-                records[j + 1] = EndLink(edge, sequences[i]);
-            else
-                records[j + 1] = LinkRecord();
+    // Buckets are the consecutive ranges of hashes, so the vertices are
+    // numbered in the order of their hashes regardless of the number of buckets
+    size_t Bucket(const LinkRecord &record) const {
+        return record.GetHash() / bucket_width_;
+    }
+
+    static bool IsSelfConjugate(const Sequence &sequence) {
+        for (size_t i = 0, j = sequence.size(); i < j; ++i) {
+            if (sequence[i] != complement(sequence[--j]))
+                return false;
+        }
+        return true;
+    }
+
+    // Self-conjugate edges take a single id, all others take two
+    static size_t EdgeIdCount(const std::vector<Sequence> &sequences) {
+        size_t res = 0;
+        for (const Sequence &sequence : sequences)
+            res += IsSelfConjugate(sequence) ? 1 : 2;
+        return res;
+    }
+
+    // Places the edges right after the first_id, the ids should be already acquired
+    void AddEdges(typename Graph::HelperT &helper, const Graph &graph,
+                  const std::vector<Sequence> &sequences, uint64_t first_id,
+                  LinkRecordChunk &chunk) const {
+        std::vector<LinkRecord> records;
+        records.reserve(2 * sequences.size());
+        uint64_t id = first_id;
+        for (const Sequence &sequence : sequences) {
+            EdgeId edge = helper.PlaceEdge(DeBruijnEdgeData(sequence), id);
+            records.push_back(StartLink(edge, sequence));
+            if (graph.conjugate(edge) != edge) {
+                records.push_back(EndLink(edge, sequence));
+                id += 2;
+            } else
+                id += 1;
         }
+
+        // Counting sort by the buckets
+        chunk.offsets.assign(nbuckets_ + 1, 0);
+        for (const auto &record : records)
+            chunk.offsets[Bucket(record) + 1] += 1;
+        std::partial_sum(chunk.offsets.begin(), chunk.offsets.end(), chunk.offsets.begin());
+
+        std::vector<size_t> pos(chunk.offsets.begin(), chunk.offsets.end() - 1);
+        chunk.records.resize(records.size());
+        for (const auto &record : records)
+            chunk.records[pos[Bucket(record)]++] = record;
     }
 
     void LinkEdge(typename Graph::HelperT &helper, const Graph &graph, const VertexId v,
@@ -476,44 +542,143 @@ private:
             helper.LinkIncomingEdge(v1, edge);
     }
 
+    void LinkVertices(typename Graph::HelperT &helper, Graph &graph,
+                      std::vector<LinkRecordChunk> &chunks) const {
+        INFO("Ordering link records");
+        // Every bucket is sorted on its own, vertex_offsets[b + 1] is the
+        // number of vertices in bucket b until the prefix sums are taken
+        std::vector<std::vector<LinkRecord>> buckets(nbuckets_);
+        std::vector<size_t> vertex_offsets(nbuckets_ + 1, 0);
+#       pragma omp parallel for schedule(guided)
+        for (size_t b = 0; b < nbuckets_; ++b) {
+            auto &bucket = buckets[b];
+            size_t size = 0;
+            for (const auto &chunk : chunks)
+                size += chunk.offsets[b + 1] - chunk.offsets[b];
+            bucket.reserve(size);
+            for (const auto &chunk : chunks)
+                bucket.insert(bucket.end(),
+                              chunk.records.begin() + chunk.offsets[b], chunk.records.begin() + chunk.offsets[b + 1]);
+            std::sort(bucket.begin(), bucket.end());
+
+            for (size_t i = 0; i < bucket.size(); ++i) {
+                if (i == 0 || bucket[i].GetHash() != bucket[i - 1].GetHash())
+                    vertex_offsets[b + 1] += 1;
+            }
+        }
+        chunks.clear();
+        chunks.shrink_to_fit();
+        INFO("Sorting done");
+
+        std::partial_sum(vertex_offsets.begin(), vertex_offsets.end(), vertex_offsets.begin());
+        size_t size = vertex_offsets.back();
+        INFO("Total " << size << " vertices to create");
+        graph.vreserve(size_t(2.01*size));
+        uint64_t min_id = graph.min_id();
+        helper.AcquireVertexIds(min_id, 2 * size);
+
+        INFO("Connecting the graph");
+#       pragma omp parallel for schedule(guided)
+        for (size_t b = 0; b < nbuckets_; ++b) {
+            const auto &bucket = buckets[b];
+            uint64_t id = min_id + 2 * vertex_offsets[b];
+            VertexId v;
+            for (size_t i = 0; i < bucket.size(); ++i) {
+                if (i == 0 || bucket[i].GetHash() != bucket[i - 1].GetHash()) {
+                    v = helper.PlaceVertex(DeBruijnVertexData(), id);
+                    id += 2;
+                }
+                LinkEdge(helper, graph, v, bucket[i].GetEdge(), bucket[i].IsStart(), bucket[i].IsRC());
+            }
+        }
+    }
+
 public:
     FastGraphFromSequencesConstructor(size_t k, Index &origin)
-            : kmer_size_(k), origin_(origin) {}
+            : kmer_size_(k), origin_(origin), nbuckets_(16 * omp_get_max_threads()),
+              bucket_width_(std::max<size_t>(1, (origin.size() + nbuckets_ - 1) / nbuckets_)) {}
 
     void ConstructGraph(Graph &graph, const std::vector<Sequence> &sequences) const {
         typename Graph::HelperT helper = graph.GetConstructionHelper();
 
-        std::vector<LinkRecord> records;
         INFO("Total " << 2*sequences.size() << " edges to create");
         graph.ereserve(size_t(2.01*sequences.size()));
+
         INFO("Collecting link records")
-        CollectLinkRecords(helper, graph, records, sequences);
-        INFO("Ordering link records")
-        parallel::sort(records.begin(), records.end());
-        INFO("Sorting done");
-        std::vector<size_t> vertex_pos;
-        for (size_t i = 0; i < records.size(); i++) {
-            if (i != 0 && records[i].GetHash() == records[i - 1].GetHash())
-                continue;
-            if (records[i].IsInvalid())
-                continue;
-            vertex_pos.push_back(i);
+        size_t nchunks = std::min(size_t(nbuckets_), sequences.size() / 1024 + 1);
+        std::vector<LinkRecordChunk> chunks(nchunks);
+        uint64_t next_id = graph.min_id();
+#       pragma omp parallel for schedule(dynamic) ordered
+        for (size_t i = 0; i < nchunks; ++i) {
+            std::vector<Sequence> chunk(sequences.begin() + i * sequences.size() / nchunks,
+                                        sequences.begin() + (i + 1) * sequences.size() / nchunks);
+            size_t ids = EdgeIdCount(chunk);
+            uint64_t first_id;
+#           pragma omp ordered
+            {
+                first_id = next_id;
+                next_id += ids;
+                helper.AcquireEdgeIds(first_id, ids);
+            }
+            AddEdges(helper, graph, chunk, first_id, chunks[i]);
         }
-        size_t size = vertex_pos.size();
-        INFO("Total " << size << " vertices to create");
-        graph.vreserve(size_t(2.01*size));
 
-        INFO("Connecting the graph");
-        uint64_t min_id = graph.min_id();
-#       pragma omp parallel for schedule(guided)
-        for (size_t i = 0; i < size; i++) {
-            size_t pos = vertex_pos[i];
+        LinkVertices(helper, graph, chunks);
+    }
+
+    /*
+     * Builds the graph right from the index. The unbranching paths are placed
+     * into the graph as soon as the chunk of the index they start from is
+     * processed, so all of them are never held in memory besides the graph.
+     */
+    void ConstructGraph(Graph &graph, bool keep_perfect_loops, unsigned nchunks) const {
+        typename Graph::HelperT helper = graph.GetConstructionHelper();
+        UnbranchingPathExtractor extractor(origin_, kmer_size_);
 
-            VertexId v = helper.CreateVertex(DeBruijnVertexData(), min_id + 2*i);
-            for (size_t j = pos; j < records.size() && records[j].GetHash() == records[pos].GetHash(); ++j) {
-                LinkEdge(helper, graph, v, records[j].GetEdge(), records[j].IsStart(), records[j].IsRC());
+        size_t start_edges = extractor.CountStartEdges(nchunks);
+        INFO("Total " << start_edges << " edges to create");
+        graph.ereserve(start_edges);
+
+        INFO("Extracting unbranching paths");
+        auto its = origin_.kmer_begin(nchunks);
+        std::vector<LinkRecordChunk> chunks(its.size());
+        uint64_t min_id = graph.min_id(), next_id = min_id;
+        size_t total = 0;
+#       pragma omp parallel for schedule(dynamic) ordered reduction(+ : total)
+        for (size_t i = 0; i < its.size(); ++i) {
+            std::vector<Sequence> sequences;
+            extractor.CalculateSequences(its[i], sequences);
+            total += sequences.size();
+
+            // Chunks take the ids in order, so the graph does not depend on the
+            // number of threads
+            size_t ids = EdgeIdCount(sequences);
+            uint64_t first_id;
+#           pragma omp ordered
+            {
+                first_id = next_id;
+                next_id += ids;
+                VERIFY(next_id <= min_id + start_edges);
+                helper.AcquireEdgeIds(first_id, ids);
             }
+            AddEdges(helper, graph, sequences, first_id, chunks[i]);
+        }
+        INFO("Extracting unbranching paths finished. " << total << " sequences extracted");
+
+        if (keep_perfect_loops) {
+#           pragma omp parallel for schedule(guided)
+            for (size_t i = 0; i < next_id - min_id; ++i)
+                extractor.CleanCondensed(graph.EdgeNucls(min_id + i));
+
+            std::vector<Sequence> loops = extractor.CollectLoops(nchunks);
+            size_t ids = EdgeIdCount(loops);
+            graph.ereserve(next_id - min_id + ids);
+            helper.AcquireEdgeIds(next_id, ids);
+            chunks.emplace_back();
+            AddEdges(helper, graph, loops, next_id, chunks.back());
         }
+
+        LinkVertices(helper, graph, chunks);
     }
 };
 
@@ -538,13 +703,8 @@ public:
     }
 
     void ConstructGraph(bool keep_perfect_loops) {
-        std::vector<Sequence> edge_sequences;
         unsigned nchunks = 16 * omp_get_max_threads();
-        if (keep_perfect_loops)
-            edge_sequences = UnbranchingPathExtractor(origin_, kmer_size_).ExtractUnbranchingPathsAndLoops(nchunks);
-        else
-            edge_sequences = UnbranchingPathExtractor(origin_, kmer_size_).ExtractUnbranchingPaths(nchunks);
-        FastGraphFromSequencesConstructor<Graph>(kmer_size_, origin_).ConstructGraph(graph_, edge_sequences);
+        FastGraphFromSequencesConstructor<Graph>(kmer_size_, origin_).ConstructGraph(graph_, keep_perfect_loops, nchunks);
     }
 
 private:
@@ -0,0 +1,137 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "action_handlers.hpp"
+
+#include "adt/iterator_range.hpp"
+#include "utils/logger/logger.hpp"
+#include "utils/verify.hpp"
+
+#include <numeric>
+#include <vector>
+
+namespace omnigraph {
+
+/**
+ * Compact read-only snapshot of the graph topology. Edge ends, lengths and
+ * coverages are kept in dense arrays indexed by edge id and the incident
+ * edges of the vertices are kept in CSR-like arrays indexed by vertex id,
+ * so the traversals (e.g. Dijkstra) do not touch the edge records with their
+ * nucleotide sequences at all.
+ *
+ * Any modification of the graph topology makes the snapshot outdated; it
+ * should be rebuilt with Rebuild() before the next use. Coverages are taken
+ * at the moment of the (re)building.
+ */
+template<class Graph>
+class CompactTopology : public GraphActionHandler<Graph> {
+    typedef GraphActionHandler<Graph> base;
+
+public:
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef typename std::vector<EdgeId>::const_iterator edge_const_iterator;
+
+    explicit CompactTopology(const Graph &g)
+            : base(g, "CompactTopology"), actual_(false) {
+        Rebuild();
+    }
+
+    void Rebuild() {
+        const Graph &g = this->g();
+        size_t max_eid = g.max_eid() + 1, max_vid = g.max_vid() + 1;
+
+        start_.assign(max_eid, VertexId());
+        end_.assign(max_eid, VertexId());
+        length_.assign(max_eid, 0);
+        coverage_.assign(max_eid, 0);
+        for (EdgeId e : g.edges()) {
+            size_t id = e.int_id();
+            start_[id] = g.EdgeStart(e);
+            end_[id] = g.EdgeEnd(e);
+            length_[id] = unsigned(g.length(e));
+            coverage_[id] = float(g.coverage(e));
+        }
+
+        FillEdgeLists(max_vid, out_offsets_, out_edges_, /*outgoing*/true);
+        FillEdgeLists(max_vid, in_offsets_, in_edges_, /*outgoing*/false);
+
+        actual_ = true;
+        DEBUG("Compact topology built for " << g.size() << " vertices");
+    }
+
+    bool actual() const { return actual_; }
+
+    VertexId EdgeStart(EdgeId e) const { return start_[e.int_id()]; }
+    VertexId EdgeEnd(EdgeId e) const { return end_[e.int_id()]; }
+    size_t length(EdgeId e) const { return length_[e.int_id()]; }
+    double coverage(EdgeId e) const { return coverage_[e.int_id()]; }
+
+    adt::iterator_range<edge_const_iterator> OutgoingEdges(VertexId v) const {
+        return EdgeList(v, out_offsets_, out_edges_);
+    }
+
+    adt::iterator_range<edge_const_iterator> IncomingEdges(VertexId v) const {
+        return EdgeList(v, in_offsets_, in_edges_);
+    }
+
+    size_t OutgoingEdgeCount(VertexId v) const {
+        return out_offsets_[v.int_id() + 1] - out_offsets_[v.int_id()];
+    }
+
+    size_t IncomingEdgeCount(VertexId v) const {
+        return in_offsets_[v.int_id() + 1] - in_offsets_[v.int_id()];
+    }
+
+    void HandleAdd(EdgeId) override { actual_ = false; }
+    void HandleDelete(EdgeId) override { actual_ = false; }
+    void HandleAdd(VertexId) override { actual_ = false; }
+    void HandleDelete(VertexId) override { actual_ = false; }
+
+private:
+    void FillEdgeLists(size_t max_vid,
+                       std::vector<size_t> &offsets, std::vector<EdgeId> &edges,
+                       bool outgoing) const {
+        const Graph &g = this->g();
+        offsets.assign(max_vid + 1, 0);
+        for (VertexId v : g)
+            offsets[v.int_id() + 1] = (outgoing ? g.OutgoingEdgeCount(v) : g.IncomingEdgeCount(v));
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        edges.resize(offsets.back());
+        for (VertexId v : g) {
+            auto pos = edges.begin() + offsets[v.int_id()];
+            for (EdgeId e : (outgoing ? g.OutgoingEdges(v) : g.IncomingEdges(v)))
+                *pos++ = e;
+        }
+    }
+
+    adt::iterator_range<edge_const_iterator> EdgeList(VertexId v,
+                                                      const std::vector<size_t> &offsets,
+                                                      const std::vector<EdgeId> &edges) const {
+        VERIFY_DEV(actual_);
+        auto begin = edges.begin();
+        return adt::make_range(begin + offsets[v.int_id()], begin + offsets[v.int_id() + 1]);
+    }
+
+    bool actual_;
+
+    std::vector<VertexId> start_;
+    std::vector<VertexId> end_;
+    std::vector<unsigned> length_;
+    std::vector<float> coverage_;
+
+    std::vector<size_t> out_offsets_;
+    std::vector<EdgeId> out_edges_;
+    std::vector<size_t> in_offsets_;
+    std::vector<EdgeId> in_edges_;
+
+    DECL_LOGGER("CompactTopology");
+};
+
+}
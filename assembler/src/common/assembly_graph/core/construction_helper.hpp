@@ -113,6 +113,41 @@ public:
         graph_.DestroyVertex(v);
     }
 
+    // Acquire the ids for the edges (vertices) to be placed there later via
+    // PlaceEdge (PlaceVertex). Placing does not lock anything, so many threads
+    // could fill their own ranges simultaneously.
+    void AcquireEdgeIds(EdgeId first, size_t count) {
+        graph_.estorage_.acquire(first.int_id(), count);
+    }
+
+    void AcquireVertexIds(VertexId first, size_t count) {
+        graph_.vstorage_.acquire(first.int_id(), count);
+    }
+
+    // The conjugate edge takes the next id, unless the edge is self-conjugate
+    EdgeId PlaceEdge(const EdgeData &data, EdgeId id) {
+        graph_.estorage_.place(id.int_id(), VertexId(), data);
+        EdgeId rc = id;
+        if (!graph_.master().isSelfConjugate(data)) {
+            rc = id.int_id() + 1;
+            graph_.estorage_.place(rc.int_id(), VertexId(), graph_.master().conjugate(data));
+        }
+        graph_.edge(id).set_conjugate(rc);
+        graph_.edge(rc).set_conjugate(id);
+        graph_.FireAddEdge(id);
+        return id;
+    }
+
+    // The conjugate vertex takes the next id
+    VertexId PlaceVertex(const VertexData &data, VertexId id) {
+        VertexId rc = id.int_id() + 1;
+        graph_.vstorage_.place(id.int_id(), data);
+        graph_.vstorage_.place(rc.int_id(), graph_.master().conjugate(data));
+        graph_.vertex(id).set_conjugate(rc);
+        graph_.vertex(rc).set_conjugate(id);
+        return id;
+    }
+
     VertexId CreateVertex(const VertexData &data, VertexId id = 0) {
         return graph_.CreateVertex(data, id);
     }
@@ -301,7 +301,22 @@ private:
             VERIFY(!id_distributor_.occupied(at));
 
             id_distributor_.acquire(at);
-            new(storage_ + at) T(std::forward<ArgTypes>(args)...);;
+            return place(at, std::forward<ArgTypes>(args)...);
+        }
+
+        // Acquires ids [at, at + count) in one go, the objects are then
+        // placed there via place(), possibly from several threads
+        void acquire(uint64_t at, size_t count) {
+            // One MUST call reserve before acquiring the ids
+            VERIFY(at + count <= storage_size_);
+            id_distributor_.acquire(at, count);
+        }
+
+        template<typename... ArgTypes>
+        uint64_t place(uint64_t at, ArgTypes &&... args) {
+            VERIFY(id_distributor_.occupied(at));
+
+            new(storage_ + at) T(std::forward<ArgTypes>(args)...);
             size_.fetch_add(1);
 
             // INFO("Emplace " << at);
@@ -1,5 +1,7 @@
 #include "id_distributor.hpp"
 
+#include "utils/verify.hpp"
+
 using namespace omnigraph;
 
 uint64_t ReclaimingIdDistributor::next_free(uint64_t n) const {
@@ -34,6 +36,17 @@ uint64_t ReclaimingIdDistributor::allocate(uint64_t offset) {
     return n + bias_;
 }
 
+void ReclaimingIdDistributor::acquire(uint64_t at, size_t count) {
+    VERIFY(at >= bias_ && at - bias_ + count <= free_map_.size());
+#pragma omp critical
+    {
+        for (uint64_t i = at - bias_; i < at - bias_ + count; ++i) {
+            VERIFY(free_map_[i]);
+            free_map_[i] = false;
+        }
+    }
+}
+
 size_t ReclaimingIdDistributor::free() const {
     size_t res = 0;
     for (bool flag : free_map_)
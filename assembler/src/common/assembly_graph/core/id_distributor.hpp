@@ -38,6 +38,9 @@ class ReclaimingIdDistributor {
 #pragma omp critical
         free_map_[at - bias_] = false;
     }
+    // Acquires the whole range [at, at + count) at once, so the ids could be
+    // handed out by the caller later on without any further locking
+    void acquire(uint64_t at, size_t count);
     void release(uint64_t at) {
         // FIXME: "lock" only single bit
 #pragma omp critical
@@ -53,6 +53,62 @@ public:
                                collect_traceback);
     }
 
+    //------------------------------
+    // bounded dijkstra over compact topology
+    //------------------------------
+    typedef ComposedDijkstraSettings<Graph,
+            CompactLengthCalculator<Graph>,
+            BoundProcessChecker<Graph>,
+            BoundPutChecker<Graph>,
+            CompactForwardNeighbourIteratorFactory<Graph> > CompactBoundedDijkstraSettings;
+
+    typedef Dijkstra<Graph, CompactBoundedDijkstraSettings> CompactBoundedDijkstra;
+
+    // The topology should be actual during the whole run
+    static CompactBoundedDijkstra CreateCompactBoundedDijkstra(const Graph &graph,
+                                                               const CompactTopology<Graph> &topology,
+                                                               size_t length_bound,
+                                                               size_t max_vertex_number = -1ul,
+                                                               bool collect_traceback = false) {
+        VERIFY(topology.actual());
+        return CompactBoundedDijkstra(graph,
+                                      CompactBoundedDijkstraSettings(
+                                          CompactLengthCalculator<Graph>(topology),
+                                          BoundProcessChecker<Graph>(length_bound),
+                                          BoundPutChecker<Graph>(length_bound),
+                                          CompactForwardNeighbourIteratorFactory<Graph>(topology)),
+                                      max_vertex_number,
+                                      collect_traceback);
+    }
+
+    //------------------------------
+    // bounded backward dijkstra over compact topology
+    //------------------------------
+    typedef ComposedDijkstraSettings<Graph,
+            CompactLengthCalculator<Graph>,
+            BoundProcessChecker<Graph>,
+            BoundPutChecker<Graph>,
+            CompactBackwardNeighbourIteratorFactory<Graph> > CompactBackwardBoundedDijkstraSettings;
+
+    typedef Dijkstra<Graph, CompactBackwardBoundedDijkstraSettings> CompactBackwardBoundedDijkstra;
+
+    static CompactBackwardBoundedDijkstra
+    CreateCompactBackwardBoundedDijkstra(const Graph &graph,
+                                         const CompactTopology<Graph> &topology,
+                                         size_t bound,
+                                         size_t max_vertex_number = size_t(-1),
+                                         bool collect_traceback = false) {
+        VERIFY(topology.actual());
+        return CompactBackwardBoundedDijkstra(graph,
+                                              CompactBackwardBoundedDijkstraSettings(
+                                                  CompactLengthCalculator<Graph>(topology),
+                                                  BoundProcessChecker<Graph>(bound),
+                                                  BoundPutChecker<Graph>(bound),
+                                                  CompactBackwardNeighbourIteratorFactory<Graph>(topology)),
+                                              max_vertex_number,
+                                              collect_traceback);
+    }
+
     //------------------------------
     // bounded backward dijkstra
     //------------------------------
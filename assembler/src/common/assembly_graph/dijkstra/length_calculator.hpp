@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include "assembly_graph/core/compact_topology.hpp"
+
 #include <set>
 #include <vector>
 
@@ -26,6 +28,19 @@ public:
     }
 };
 
+template<class Graph, typename distance_t = std::size_t>
+class CompactLengthCalculator {
+    typedef typename Graph::EdgeId EdgeId;
+
+    const CompactTopology<Graph> &topology_;
+public:
+    CompactLengthCalculator(const CompactTopology<Graph> &topology) : topology_(topology) { }
+
+    distance_t GetLength(EdgeId edge) const {
+        return distance_t(topology_.length(edge));
+    }
+};
+
 template<class Graph, typename distance_t = std::size_t>
 class ComponentLenCalculator {
     typedef typename Graph::VertexId VertexId;
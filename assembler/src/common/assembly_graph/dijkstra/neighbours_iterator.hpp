@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include "assembly_graph/core/compact_topology.hpp"
+
 #include <utility>
 
 namespace omnigraph {
@@ -109,6 +111,60 @@ public:
     }
 };
 
+template<class Graph>
+class CompactForwardNeighbourIterator {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef typename CompactTopology<Graph>::edge_const_iterator edge_const_iterator;
+
+    const CompactTopology<Graph> &topology_;
+    edge_const_iterator current_, end_;
+public:
+    CompactForwardNeighbourIterator(const CompactTopology<Graph> &topology, VertexId vertex)
+            : topology_(topology) {
+        auto out_edges = topology.OutgoingEdges(vertex);
+        current_ = out_edges.begin();
+        end_ = out_edges.end();
+    }
+
+    bool HasNext() const {
+        return current_ != end_;
+    }
+
+    vertex_neighbour<Graph> Next() {
+        vertex_neighbour<Graph> res(topology_.EdgeEnd(*current_), *current_);
+        ++current_;
+        return res;
+    }
+};
+
+template<class Graph>
+class CompactBackwardNeighbourIterator {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef typename CompactTopology<Graph>::edge_const_iterator edge_const_iterator;
+
+    const CompactTopology<Graph> &topology_;
+    edge_const_iterator current_, end_;
+public:
+    CompactBackwardNeighbourIterator(const CompactTopology<Graph> &topology, VertexId vertex)
+            : topology_(topology) {
+        auto in_edges = topology.IncomingEdges(vertex);
+        current_ = in_edges.begin();
+        end_ = in_edges.end();
+    }
+
+    bool HasNext() const {
+        return current_ != end_;
+    }
+
+    vertex_neighbour<Graph> Next() {
+        vertex_neighbour<Graph> res(topology_.EdgeStart(*current_), *current_);
+        ++current_;
+        return res;
+    }
+};
+
 template<class Graph>
 class ForwardNeighbourIteratorFactory {
     typedef typename Graph::VertexId VertexId;
@@ -148,4 +204,28 @@ public:
     }
 };
 
+template<class Graph>
+class CompactForwardNeighbourIteratorFactory {
+    typedef typename Graph::VertexId VertexId;
+    const CompactTopology<Graph> &topology_;
+public:
+    typedef CompactForwardNeighbourIterator<Graph> NeighbourIterator;
+    CompactForwardNeighbourIteratorFactory(const CompactTopology<Graph> &topology) : topology_(topology) { }
+    NeighbourIterator CreateIterator(VertexId vertex){
+        return NeighbourIterator(topology_, vertex);
+    }
+};
+
+template<class Graph>
+class CompactBackwardNeighbourIteratorFactory {
+    typedef typename Graph::VertexId VertexId;
+    const CompactTopology<Graph> &topology_;
+public:
+    typedef CompactBackwardNeighbourIterator<Graph> NeighbourIterator;
+    CompactBackwardNeighbourIteratorFactory(const CompactTopology<Graph> &topology) : topology_(topology) { }
+    NeighbourIterator CreateIterator(VertexId vertex){
+        return NeighbourIterator(topology_, vertex);
+    }
+};
+
 }
@@ -5,8 +5,11 @@
 //***************************************************************************
 
 #pragma once
+#include "assembly_graph/core/action_handlers.hpp"
 #include "assembly_graph/core/order_and_law.hpp"
 
+#include <parallel_hashmap/phmap.h>
+
 namespace omnigraph {
 
 template<class T>
@@ -67,4 +70,55 @@ public:
         return marker_.is_marked(helper_.ToManipulateFromPair(t));
     }
 };
+
+/**
+ * Marks the vertices (along with their conjugates) touched by the graph
+ * modifications since the last clear(): the ends of all the added and
+ * deleted edges and the deleted vertices. An element not touching the marked
+ * vertices has the same neighbourhood as before the modifications.
+ */
+template<class Graph>
+class ModifiedVerticesMarker : public GraphActionHandler<Graph> {
+    typedef GraphActionHandler<Graph> base;
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+
+    phmap::flat_hash_set<VertexId> marked_;
+
+    void Mark(VertexId v) {
+        marked_.insert(v);
+        marked_.insert(this->g().conjugate(v));
+    }
+
+public:
+    explicit ModifiedVerticesMarker(const Graph &g)
+            : base(g, "ModifiedVerticesMarker") {}
+
+    void HandleAdd(EdgeId e) override {
+        Mark(this->g().EdgeStart(e));
+        Mark(this->g().EdgeEnd(e));
+    }
+
+    void HandleDelete(EdgeId e) override {
+        Mark(this->g().EdgeStart(e));
+        Mark(this->g().EdgeEnd(e));
+    }
+
+    void HandleDelete(VertexId v) override {
+        Mark(v);
+    }
+
+    bool is_marked(VertexId v) const {
+        return marked_.count(v);
+    }
+
+    bool is_marked(EdgeId e) const {
+        return is_marked(this->g().EdgeStart(e)) || is_marked(this->g().EdgeEnd(e));
+    }
+
+    void clear() {
+        marked_.clear();
+    }
+};
+
 }
@@ -9,6 +9,7 @@
 
 #include "assembly_graph/core/graph_iterators.hpp"
 #include "assembly_graph/graph_support/graph_processing_algorithm.hpp"
+#include "assembly_graph/graph_support/marks_and_locks.hpp"
 
 #include "utils/parallel/openmp_wrapper.h"
 #include "utils/perf/timetracer.hpp"
@@ -326,6 +327,67 @@ protected:
 private:
     SmartSetIterator<Graph, ElementId, Priority> it_;
     const bool tracking_;
+    size_t batch_size_;
+
+    //returns false if the proceed condition turned false
+    bool FillBatch(std::vector<ElementId> &batch) {
+        for (; !it_.IsEnd() && batch.size() < batch_size_; ++it_) {
+            ElementId el = *it_;
+            if (!Proceed(el)) {
+                TRACE("Proceed condition turned false on element " << this->g().str(el));
+                it_.ReleaseCurrent();
+                return false;
+            }
+            batch.push_back(el);
+        }
+        return true;
+    }
+
+    size_t ProcessBatch(const std::vector<ElementId> &batch,
+                        ModifiedVerticesMarker<Graph> &modified) {
+        //not std::vector<bool> to allow concurrent writes
+        std::vector<char> passed(batch.size());
+        #pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < batch.size(); ++i)
+            passed[i] = Check(batch[i]);
+
+        size_t triggered = 0, rechecked = 0;
+        modified.clear();
+        for (size_t i = 0; i < batch.size(); ++i) {
+            ElementId el = batch[i];
+            if (!this->g().contains(el))
+                continue;
+
+            if (modified.is_marked(el)) {
+                //neighbourhood has changed since the check, fall back to serial processing
+                rechecked += 1;
+                if (Process(el))
+                    triggered++;
+            } else if (passed[i]) {
+                TRACE("Applying to element " << this->g().str(el));
+                Apply(el);
+                triggered++;
+            }
+        }
+        DEBUG("Batch of " << batch.size() << " elements processed, "
+              << rechecked << " processed serially, triggered " << triggered);
+        return triggered;
+    }
+
+    size_t ProcessInBatches() {
+        ModifiedVerticesMarker<Graph> modified(this->g());
+        std::vector<ElementId> batch;
+        batch.reserve(batch_size_);
+
+        size_t triggered = 0;
+        bool proceed = true;
+        while (proceed && !it_.IsEnd()) {
+            batch.clear();
+            proceed = FillBatch(batch);
+            triggered += ProcessBatch(batch, modified);
+        }
+        return triggered;
+    }
 
 protected:
     void ReturnForConsideration(ElementId el) {
@@ -336,6 +398,29 @@ protected:
     virtual bool Proceed(ElementId /*el*/) const { return true; }
     virtual void PrepareIteration(double /*iter_run_progress*/ = 1.) {}
 
+    /**
+     * Batched processing: the candidates are taken in batches of the given
+     * size and checked with Check() in parallel. Then the ones passing the
+     * check are applied in order with Apply(), while the ones touching the
+     * vertices modified earlier in the batch are processed with Process().
+     * Zero batch size means the usual serial processing.
+     * Algorithms enabling it must implement Check() and Apply().
+     */
+    void set_batch_size(size_t batch_size) {
+        batch_size_ = batch_size;
+    }
+
+    //should be thread-safe and should not depend on the elements beyond the neighbourhood
+    virtual bool Check(ElementId /*el*/) const {
+        VERIFY_MSG(false, "Batched processing is not supported");
+        return false;
+    }
+
+    //applies the processing to the element passing the check
+    virtual void Apply(ElementId /*el*/) {
+        VERIFY_MSG(false, "Batched processing is not supported");
+    }
+
 public:
 
     PersistentProcessingAlgorithm(Graph& g,
@@ -346,7 +431,8 @@ public:
             PersistentAlgorithmBase<Graph>(g),
             interest_el_finder_(interest_el_finder),
             it_(g, true, priority, canonical_only),
-            tracking_(track_changes) {
+            tracking_(track_changes),
+            batch_size_(0) {
         it_.Detach();
     }
 
@@ -374,16 +460,20 @@ public:
 
         size_t triggered = 0;
         TRACE("Start processing");
-        for (; !it_.IsEnd(); ++it_) {
-            ElementId el = *it_;
-            if (!Proceed(el)) {
-                TRACE("Proceed condition turned false on element " << this->g().str(el));
-                it_.ReleaseCurrent();
-                break;
+        if (batch_size_ > 0) {
+            triggered = ProcessInBatches();
+        } else {
+            for (; !it_.IsEnd(); ++it_) {
+                ElementId el = *it_;
+                if (!Proceed(el)) {
+                    TRACE("Proceed condition turned false on element " << this->g().str(el));
+                    it_.ReleaseCurrent();
+                    break;
+                }
+                TRACE("Processing edge " << this->g().str(el));
+                if (Process(el))
+                    triggered++;
             }
-            TRACE("Processing edge " << this->g().str(el));
-            if (Process(el))
-                triggered++;
         }
         TRACE("Finished processing. Triggered = " << triggered);
         if (!tracking_)
@@ -420,7 +510,17 @@ protected:
         return false;
     }
 
+    bool Check(EdgeId e) const override {
+        return remove_condition_(e);
+    }
+
+    void Apply(EdgeId e) override {
+        edge_remover_.DeleteEdge(e);
+    }
+
 public:
+    using base::set_batch_size;
+
     ParallelEdgeRemovingAlgorithm(Graph& g,
                                   func::TypedPredicate<EdgeId> remove_condition,
                                   size_t chunk_cnt,
@@ -113,11 +113,26 @@ public:
 };
 
 class UsedUniqueStorage {
+public:
+    typedef std::vector<std::pair<EdgeId, size_t>> InsertionLog;
+
+private:
     std::unordered_set<EdgeId> used_;
     std::unordered_map<size_t, std::unordered_set<EdgeId>> used_by_paths_; // for fast check 'whether the path contains the edge'
     const ScaffoldingUniqueEdgeStorage& unique_;
     const debruijn_graph::ConjugateDeBruijnGraph &g_;
 
+    // Overlay mode, see the corresponding constructor
+    const UsedUniqueStorage *base_ = nullptr;
+    std::vector<EdgeId> *base_reads_ = nullptr;
+    InsertionLog *log_ = nullptr;
+
+    const UsedUniqueStorage *Base(EdgeId e) const {
+        if (base_reads_)
+            base_reads_->push_back(e);
+        return base_;
+    }
+
 public:
     UsedUniqueStorage(const UsedUniqueStorage&) = delete;
     UsedUniqueStorage& operator=(const UsedUniqueStorage&) = delete;
@@ -130,6 +145,29 @@ public:
         , g_(g) 
     {}
 
+    // Overlay over the (read-only) base storage: edges are inserted into the
+    // overlay only, but are checked in both. Edges looked up in the base
+    // storage are appended to base_reads.
+    UsedUniqueStorage(const UsedUniqueStorage &base, std::vector<EdgeId> *base_reads)
+        : unique_(base.unique_)
+        , g_(base.g_)
+        , base_(&base)
+        , base_reads_(base_reads)
+    {}
+
+    // Drops all the edges of the overlay
+    void ResetOverlay(std::vector<EdgeId> *base_reads) {
+        VERIFY(base_);
+        used_.clear();
+        used_by_paths_.clear();
+        base_reads_ = base_reads;
+    }
+
+    // All the subsequent insertions are appended to the log (if not null)
+    void SetInsertionLog(InsertionLog *log) {
+        log_ = log;
+    }
+
     void insert(EdgeId e, size_t path_id) {
         if (!unique_.IsUnique(e))
             return;
@@ -138,15 +176,21 @@ public:
         used_.insert(g_.conjugate(e));
         used_by_paths_[path_id].insert(e);
         used_by_paths_[path_id].insert(g_.conjugate(e));
+        if (log_)
+            log_->emplace_back(e, path_id);
     }
 
     bool IsUsed(EdgeId e, size_t path_id) const {
         auto it = used_by_paths_.find(path_id);
-        return it != used_by_paths_.end() && it->second.find(e) != it->second.end();
+        if (it != used_by_paths_.end() && it->second.find(e) != it->second.end())
+            return true;
+        return base_ && Base(e)->IsUsed(e, path_id);
     }
 
     bool IsUsed(EdgeId e) const {
-        return used_.find(e) != used_.end();
+        if (used_.find(e) != used_.end())
+            return true;
+        return base_ && Base(e)->IsUsed(e);
     }
 
     bool IsUsedAndUnique(EdgeId e, size_t path_id) const {
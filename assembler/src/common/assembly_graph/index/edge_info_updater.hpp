@@ -20,18 +20,6 @@ template<typename Graph>
 class EdgeInfoUpdater {
     typedef typename Graph::EdgeId EdgeId;
 
-    template<class Index>
-    bool DeleteIfEqual(const typename Index::KeyWithHash& kwh, EdgeId e, Index &index) {
-        if (!index.contains(kwh))
-            return false;
-
-        if (index.get_value(kwh).edge() == e) {
-            index.get_raw_value_reference(kwh).clear();
-            return true;
-        }
-        return false;
-    }
-
     template<class Index>
     void UpdateKMers(const Sequence &nucls, EdgeId e, Index &index) {
         VERIFY(nucls.size() >= index.k());
@@ -49,10 +37,10 @@ class EdgeInfoUpdater {
     void DeleteKMers(const Sequence &nucls, EdgeId e, Index &index) {
         VERIFY(nucls.size() >= index.k());
         typename Index::KeyWithHash kwh = index.ConstructKWH(typename Index::KMer(index.k(), nucls));
-        DeleteIfEqual(kwh, e, index);
+        index.RemoveFromIndex(kwh, e);
         for (size_t i = index.k(), n = nucls.size(); i < n; ++i) {
             kwh <<= nucls[i];
-            DeleteIfEqual(kwh, e, index);
+            index.RemoveFromIndex(kwh, e);
         }
     }
 
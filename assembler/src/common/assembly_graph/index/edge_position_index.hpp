@@ -12,6 +12,10 @@
 #include "utils/ph_map/kmer_maps.hpp"
 
 #include <folly/SmallLocks.h>
+#include <parallel_hashmap/phmap.h>
+
+#include <atomic>
+#include <mutex>
 
 namespace debruijn_graph {
 
@@ -100,6 +104,11 @@ struct GraphInverter {
 };
 
 
+/**
+ * The static part of the index covers the k-mers of the graph it was built
+ * for. K-mers of the edges added afterwards, which collide with some other
+ * live k-mer in the MPHF, are kept in the overflow table.
+ */
 template<class Graph, class IdHolder = typename Graph::EdgeId, class StoringType = utils::DefaultStoring>
 class KmerFreeEdgeIndex : public utils::PerfectHashMap<RtSeq,
                                                        EdgeInfo<typename Graph::EdgeId, IdHolder>,
@@ -114,16 +123,72 @@ public:
     typedef typename base::KeyWithHash KeyWithHash;
     typedef EdgeInfo<typename Graph::EdgeId, IdHolder> KmerPos;
 
+private:
+    typedef phmap::flat_hash_map<KMer, KmerPos, typename KMer::hash> OverflowMap;
+
+    // Canonical k-mer -> its position in the canonical orientation
+    OverflowMap overflow_;
+    std::atomic<size_t> overflow_size_;
+    std::mutex overflow_lock_;
+
+    static bool is_canonical(const KeyWithHash &kwh) {
+        return !StoringType::IsInvertable() || kwh.is_minimal();
+    }
+
+    static KMer canonical(const KeyWithHash &kwh) {
+        return is_canonical(kwh) ? kwh.key() : !kwh.key();
+    }
+
+    bool points_to(const KmerPos &entry, const KMer &kmer) const {
+        return entry.valid() && graph_.EdgeNucls(entry.edge()).contains(kmer, entry.offset());
+    }
+
+    // Looks up the overflow table, should not run concurrently with PutInIndex
+    KmerPos get_overflow(const KeyWithHash &kwh) const {
+        auto it = overflow_.find(canonical(kwh));
+        if (it == overflow_.end())
+            return KmerPos();
+
+        return is_canonical(kwh) ? it->second : it->second.conjugate(graph_);
+    }
+
+    // Must be called under overflow_lock_. The k-mer occurring on several
+    // edges (or several times on the same edge) is ambiguous and removed.
+    void PutInOverflow(const KMer &kmer, const KmerPos &pos) {
+        auto res = overflow_.emplace(kmer, pos);
+        if (res.second)
+            overflow_size_ += 1;
+        else if (points_to(res.first->second, kmer))
+            res.first->second.remove();
+        else if (!res.first->second.removed())
+            res.first->second = pos;
+    }
+
+    // Must be called under overflow_lock_
+    void RemoveFromOverflow(const KMer &kmer) {
+        auto it = overflow_.find(kmer);
+        if (it != overflow_.end() && points_to(it->second, kmer))
+            it->second.remove();
+    }
+
 public:
     KmerFreeEdgeIndex(const Graph &graph)
-            : base(unsigned(graph.k() + 1)), graph_(graph) {}
+            : base(unsigned(graph.k() + 1)), graph_(graph), overflow_size_(0) {}
 
 
     using base::valid;
     using base::ConstructKWH;
 
     KmerPos get_value(const KeyWithHash &kwh) const {
-        return base::get_value(kwh, GraphInverter<Graph>(graph_));
+        // The k-mers unknown to the MPHF could be in the overflow table only
+        if (!valid(kwh))
+            return overflow_size_ ? get_overflow(kwh) : KmerPos();
+
+        KmerPos entry = base::get_value(kwh, GraphInverter<Graph>(graph_));
+        if (overflow_size_ == 0 || points_to(entry, kwh.key()))
+            return entry;
+
+        return get_overflow(kwh);
     }
 
     void put_value(const KeyWithHash &kwh, const KmerPos &pos) {
@@ -134,34 +199,151 @@ public:
      * Shows if kmer has some entry associated with it
      */
     bool contains(const KeyWithHash &kwh) const {
-        // Sanity check
-        if (!valid(kwh))
-            return false;
-
-        KmerPos entry = get_value(kwh);
-        if (!entry.valid())
-            return false;
+        if (valid(kwh) && points_to(base::get_value(kwh, GraphInverter<Graph>(graph_)), kwh.key()))
+            return true;
 
-        return graph_.EdgeNucls(entry.edge()).contains(kwh.key(), entry.offset());
+        return overflow_size_ && points_to(get_overflow(kwh), kwh.key());
     }
 
     void PutInIndex(KeyWithHash &kwh, typename Graph::EdgeId id, size_t offset) {
-        if (!valid(kwh))
+        KmerPos pos(id, (unsigned)offset);
+        if (!valid(kwh)) {
+            std::lock_guard<std::mutex> guard(overflow_lock_);
+            PutInOverflow(canonical(kwh), is_canonical(kwh) ? pos : pos.conjugate(graph_));
             return;
+        }
 
         KmerPos &entry = this->get_raw_value_reference(kwh);
-        if (entry.removed())
+        if (entry.removed() && !overflow_size_)
             return;
 
         entry.lock();
-        if (entry.clean()) {
+        if (entry.removed()) {
+            // The slot of the ambiguous k-mer is never reused. The k-mer could
+            // still be in the overflow table, if it got there while the slot
+            // was taken by some other k-mer.
+            if (overflow_size_) {
+                std::lock_guard<std::mutex> guard(overflow_lock_);
+                RemoveFromOverflow(canonical(kwh));
+            }
+        } else if (entry.clean() && !overflow_size_) {
             // Note that this releases the lock as well!
-            put_value(kwh, KmerPos(id, (unsigned)offset));
-        } else if (contains(kwh)) {
+            put_value(kwh, pos);
+        } else if (points_to(base::get_value(kwh, GraphInverter<Graph>(graph_)), kwh.key())) {
+            // The k-mer is already on some live edge
             entry.remove();
+        } else {
+            // Either the slot belongs to some other k-mer, or the k-mer could
+            // already be in the overflow table
+            std::lock_guard<std::mutex> guard(overflow_lock_);
+            KMer kmer = canonical(kwh);
+            if (entry.clean() && !overflow_.count(kmer))
+                put_value(kwh, pos);
+            else
+                PutInOverflow(kmer, is_canonical(kwh) ? pos : pos.conjugate(graph_));
         }
         entry.unlock();
     }
+
+    /**
+     * Removes the k-mer if it is associated with the edge e
+     */
+    bool RemoveFromIndex(const KeyWithHash &kwh, typename Graph::EdgeId e) {
+        if (valid(kwh)) {
+            KmerPos pos = base::get_value(kwh, GraphInverter<Graph>(graph_));
+            if (points_to(pos, kwh.key())) {
+                if (pos.edge() != e)
+                    return false;
+                this->get_raw_value_reference(kwh).clear();
+                return true;
+            }
+        }
+
+        if (!overflow_size_)
+            return false;
+
+        std::lock_guard<std::mutex> guard(overflow_lock_);
+        auto it = overflow_.find(canonical(kwh));
+        if (it == overflow_.end() || !it->second.valid())
+            return false;
+        if ((is_canonical(kwh) ? it->second : it->second.conjugate(graph_)).edge() != e)
+            return false;
+        overflow_.erase(it);
+        overflow_size_ -= 1;
+        return true;
+    }
+
+    /**
+     * Clears the entries of all the edges satisfying the predicate. The slots
+     * are scanned sequentially, so this is much cheaper than deleting the
+     * k-mers of the edges one by one.
+     */
+    template<class Predicate>
+    void RemoveIf(const Predicate &pred) {
+        auto values = this->value_begin();
+        size_t n = this->size();
+#       pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < n; ++i) {
+            KmerPos &entry = values[i];
+            if (entry.valid() && pred(entry.edge()))
+                entry.clear();
+        }
+
+        for (auto it = overflow_.begin(); it != overflow_.end(); ) {
+            if (it->second.valid() && pred(it->second.edge()))
+                overflow_.erase(it++);
+            else
+                ++it;
+        }
+        overflow_size_ = overflow_.size();
+    }
+
+    // Number of the slots occupied by the k-mers of the graph
+    size_t occupied() const {
+        auto values = this->value_cbegin();
+        size_t n = this->size(), res = 0;
+#       pragma omp parallel for schedule(static) reduction(+ : res)
+        for (size_t i = 0; i < n; ++i)
+            res += values[i].valid();
+        return res;
+    }
+
+    size_t overflow_size() const {
+        return overflow_size_;
+    }
+
+    void clear() {
+        base::clear();
+        overflow_.clear();
+        overflow_size_ = 0;
+    }
+
+    template<class Writer>
+    void BinWrite(Writer &writer) const {
+        base::BinWrite(writer);
+        io::binary::BinWrite(writer, overflow_.size());
+        for (const auto &entry : overflow_) {
+            entry.first.BinWrite(writer);
+            entry.second.BinWrite(writer);
+        }
+    }
+
+    template<class Reader>
+    void BinRead(Reader &reader) {
+        clear();
+        base::BinRead(reader);
+        size_t size;
+        io::binary::BinRead(reader, size);
+        overflow_.reserve(size);
+        for (size_t i = 0; i < size; ++i) {
+            KMer kmer(this->k());
+            KmerPos pos;
+            kmer.BinRead(reader);
+            pos.BinRead(reader);
+            overflow_.emplace(kmer, pos);
+        }
+        overflow_size_ = overflow_.size();
+    }
 };
 
 template<class Graph, class IdHolder = typename Graph::EdgeId, class StoringType = utils::DefaultStoring>
@@ -233,6 +415,13 @@ public:
       }
       entry.unlock();
   }
+
+  bool RemoveFromIndex(const KeyWithHash &kwh, IdType e) {
+      if (!contains(kwh) || this->get_value(kwh).edge() != e)
+          return false;
+      this->get_raw_value_reference(kwh).clear();
+      return true;
+  }
 };
 
 
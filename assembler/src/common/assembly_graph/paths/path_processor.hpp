@@ -196,6 +196,13 @@ public:
         TRACE("Dijkstra finished");
     }
 
+    // Reruns Dijkstra from the new start vertex, so that one processor (and
+    // the containers of its Dijkstra) can serve many start vertices in turn
+    void Reset(VertexId start) {
+        start_ = start;
+        dijkstra_.Run(start);
+    }
+
     // dfs from the end vertices
     // 3 two mistakes, 2 bad dijkstra, 1 some bad dfs, 0 = okay
     int Process(VertexId end, size_t min_len, size_t max_len,
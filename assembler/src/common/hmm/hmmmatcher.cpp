@@ -55,15 +55,17 @@ HMMMatcher::HMMMatcher(const HMM &hmmw,
 void HMMMatcher::match(const char *name, const char *seq, const char *desc) {
     ESL_SQ *dbsq = esl_sq_CreateFrom(name, seq, desc, NULL, NULL);
     esl_sq_Digitize(om_->abc, dbsq);
+    match(dbsq);
+    esl_sq_Destroy(dbsq);
+}
 
+void HMMMatcher::match(const ESL_SQ *dbsq) {
     p7_pli_NewSeq(pli_.get(), dbsq);
     p7_bg_SetLength(bg_.get(), int(dbsq->n));
     p7_oprofile_ReconfigLength(om_.get(), int(dbsq->n));
 
     p7_Pipeline(pli_.get(), om_.get(), bg_.get(), dbsq, nullptr, th_.get());
     p7_pipeline_Reuse(pli_.get());
-
-    esl_sq_Destroy(dbsq);
 }
 
 void HMMMatcher::summarize() {
@@ -129,6 +129,8 @@ class HMMMatcher {
     HMMMatcher(const HMM &hmmw,
                const hmmer_cfg &cfg);
     void match(const char *name, const char *seq, const char *desc = NULL);
+    // The sequence must be digitized in the alphabet of the HMM
+    void match(const ESL_SQ *dbsq);
 
     void summarize();
     P7_TOPHITS *top_hits() const;
@@ -18,6 +18,7 @@
 
 #include "threadpool/threadpool.hpp"
 
+#include <algorithm>
 #include <fstream>
 
 
@@ -62,7 +63,9 @@ bool ReadConverter::LoadLibIfExists(SequencingLibraryT& lib) {
 }
 
 void ReadConverter::ConvertToBinary(SequencingLibraryT& lib,
-                                    ThreadPool::ThreadPool *pool) {
+                                    ThreadPool::ThreadPool *pool,
+                                    unsigned nthreads,
+                                    BinaryReadChunk::Codec codec) {
     auto& data = lib.data();
     std::ofstream info;
     info.open(data.binary_reads_info.bin_reads_info_file, std::ios_base::out);
@@ -71,9 +74,14 @@ void ReadConverter::ConvertToBinary(SequencingLibraryT& lib,
 
     INFO("Converting reads to binary format for library #" << data.lib_index << " (takes a while)");
     INFO("Converting paired reads");
-    BinaryWriter paired_converter(data.binary_reads_info.paired_read_prefix);
+    BinaryWriter paired_converter(data.binary_reads_info.paired_read_prefix, codec);
 
     FileReadFlags flags{ PhredOffset, /* use name */ false, /* use quality */ false, /* validate */ false };
+    // Gzipped files are inflated ahead of parsing, BGZF ones by several threads.
+    // The pool reads both mates and flushes the chunks, the rest of the threads
+    // are shared by the two files inflated at once
+    unsigned busy = pool ? 3 : 1;
+    flags.inflate_threads = nthreads > busy ? std::min((nthreads - busy) / 2, 0xFFFFu) : 0;
     PairedStream paired_reader = paired_easy_reader(lib,
                                                     false, /* followed_by_rc */
                                                     0, /* insert_size */
@@ -84,13 +92,13 @@ void ReadConverter::ConvertToBinary(SequencingLibraryT& lib,
     read_stat.read_count *= 2;
 
     INFO("Converting single reads");
-    BinaryWriter single_converter(data.binary_reads_info.single_read_prefix);
+    BinaryWriter single_converter(data.binary_reads_info.single_read_prefix, codec);
     SingleStream single_reader = single_easy_reader(lib, false, false, true, flags, pool);
     read_stat.merge(single_converter.ToBinary(single_reader, pool));
 
     data.unmerged_read_length = read_stat.max_len;
     INFO("Converting merged reads");
-    BinaryWriter merged_converter(data.binary_reads_info.merged_read_prefix);
+    BinaryWriter merged_converter(data.binary_reads_info.merged_read_prefix, codec);
     SingleStream merged_reader = merged_easy_reader(lib, false, true, flags, pool);
     auto merged_stats = merged_converter.ToBinary(merged_reader, pool);
 
@@ -137,7 +145,7 @@ void ReadConverter::WriteBinaryInfo(const std::string &filename, LibraryData &da
     data.binary_reads_info.binary_converted = true;
 }
 
-void ConvertIfNeeded(DataSet<LibraryData> &data, unsigned nthreads) {
+void ConvertIfNeeded(DataSet<LibraryData> &data, unsigned nthreads, bool compress) {
     std::unique_ptr<ThreadPool::ThreadPool> pool;
 
     if (nthreads > 1)
@@ -145,7 +153,8 @@ void ConvertIfNeeded(DataSet<LibraryData> &data, unsigned nthreads) {
 
     for (auto &lib : data) {
         if (!ReadConverter::LoadLibIfExists(lib))
-            ReadConverter::ConvertToBinary(lib, pool.get());
+            ReadConverter::ConvertToBinary(lib, pool.get(), nthreads,
+                                           compress ? BinaryReadChunk::Codec::Deflate : BinaryReadChunk::Codec::Packed);
     }
 }
 
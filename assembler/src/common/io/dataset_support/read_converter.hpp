@@ -23,20 +23,25 @@ typedef debruijn_graph::config::LibraryData LibraryData;
 typedef SequencingLibrary<LibraryData> SequencingLibraryT;
 
 class ReadConverter {
-    static constexpr size_t BINARY_FORMAT_VERSION = 13;
+    static constexpr size_t BINARY_FORMAT_VERSION = 14;
 
     static bool CheckBinaryReadsExist(SequencingLibraryT& lib);
     static void WriteBinaryInfo(const std::string& filename, LibraryData& data);
 public:
     static bool LoadLibIfExists(SequencingLibraryT& lib);
+    // nthreads is the total number of threads the conversion may keep busy,
+    // the ones not taken by the pool tasks inflate the gzipped reads
     static void ConvertToBinary(SequencingLibraryT& lib,
-                                ThreadPool::ThreadPool *pool = nullptr);
+                                ThreadPool::ThreadPool *pool = nullptr,
+                                unsigned nthreads = 1,
+                                BinaryReadChunk::Codec codec = BinaryReadChunk::Codec::Packed);
 
     static void ConvertEdgeSequencesToBinary(const debruijn_graph::Graph &g, const std::string &contigs_output_dir,
                                              unsigned nthreads);
 };
 
-void ConvertIfNeeded(DataSet<LibraryData> &data, unsigned nthreads);
+// Binary reads are deflated, if compress is set
+void ConvertIfNeeded(DataSet<LibraryData> &data, unsigned nthreads, bool compress = false);
 
 BinaryPairedStreams paired_binary_readers(SequencingLibraryT &lib,
                                           bool followed_by_rc,
@@ -168,7 +168,7 @@ public:
     }
 
     void read(void *buf, size_t amount) {
-        if (BytesRead + amount < BlockOffset + BlockSize) {
+        if (BytesRead + amount <= BlockOffset + BlockSize) {
             // Easy case, no remap is necessary
             read_internal(buf, amount);
             return;
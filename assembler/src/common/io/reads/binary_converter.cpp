@@ -19,6 +19,20 @@
 
 namespace io {
 
+static void AddRead(BinaryReadChunk &chunk, const SingleReadSeq &read, bool rc) {
+    if (rc)
+        chunk.Add(!read.sequence(), read.GetRightOffset(), read.GetLeftOffset());
+    else
+        chunk.Add(read.sequence(), read.GetLeftOffset(), read.GetRightOffset());
+}
+
+static void AddRead(BinaryReadChunk &chunk, const SingleRead &read, bool rc) {
+    if (rc)
+        chunk.Add(read.sequence(true), read.GetRightOffset(), read.GetLeftOffset());
+    else
+        chunk.Add(read.sequence(), read.GetLeftOffset(), read.GetRightOffset());
+}
+
 template<class Read>
 class ReadBinaryWriter {
     bool rc_;
@@ -27,8 +41,8 @@ public:
     ReadBinaryWriter(bool rc = false)
             : rc_(rc) {}
 
-    bool Write(std::ostream& file, const Read& r) const {
-        return r.BinWrite(file, rc_);
+    void Write(BinaryReadChunk &chunk, const Read& r) const {
+        AddRead(chunk, r, rc_);
     }
 };
 
@@ -42,8 +56,9 @@ public:
         std::tie(rc1_, rc2_) = GetRCFlags(orientation);
     }
 
-    bool Write(std::ostream& file, const Read& r) const {
-        return r.BinWrite(file, rc1_, rc2_);
+    void Write(BinaryReadChunk &chunk, const Read& r) const {
+        AddRead(chunk, r.first(), rc1_);
+        AddRead(chunk, r.second(), rc2_);
     }
 };
 
@@ -57,8 +72,19 @@ ReadStreamStat BinaryWriter::ToBinary(const Writer &writer, io::ReadStream<Read>
     // Reserve space for stats
     ReadStreamStat read_stats;
     read_stats.write(*file_ds_);
+    uint64_t version = FORMAT_VERSION;
+    file_ds_->write(reinterpret_cast<const char*>(&version), sizeof(version));
+
+    BinaryReadChunk chunk;
+    size_t chunk_reads = 0;
+    auto write_chunk = [&] {
+        auto offset = (size_t)file_ds_->tellp();
+        offset_ds_->write(reinterpret_cast<const char*>(&offset), sizeof(offset));
+        chunk.Write(*file_ds_, codec_);
+        chunk.clear();
+        chunk_reads = 0;
+    };
 
-    size_t rest = 1;
     std::future<void> flush_task;
     auto flush_buffer = [&]() {
         // Wait for completion of the current flush task
@@ -70,12 +96,9 @@ ReadStreamStat BinaryWriter::ToBinary(const Writer &writer, io::ReadStream<Read>
 
         auto flush_job = [&] {
             for (const Read &read : flush_buf) {
-                if (!--rest) {
-                    auto offset = (size_t)file_ds_->tellp();
-                    offset_ds_->write(reinterpret_cast<const char*>(&offset), sizeof(offset));
-                    rest = CHUNK;
-                }
-                writer.Write(*file_ds_, read);
+                writer.Write(chunk, read);
+                if (++chunk_reads == CHUNK)
+                    write_chunk();
             }
             flush_buf.clear();
         };
@@ -103,6 +126,8 @@ ReadStreamStat BinaryWriter::ToBinary(const Writer &writer, io::ReadStream<Read>
     if (flush_task.valid())
         flush_task.wait();
     VERIFY(flush_buf.size() == 0);
+    if (chunk_reads)
+        write_chunk();
 
     // Rewrite the reserved space with actual stats
     file_ds_->seekp(0);
@@ -112,10 +137,11 @@ ReadStreamStat BinaryWriter::ToBinary(const Writer &writer, io::ReadStream<Read>
     return read_stats;
 }
 
-BinaryWriter::BinaryWriter(const std::string &file_name_prefix)
+BinaryWriter::BinaryWriter(const std::string &file_name_prefix, BinaryReadChunk::Codec codec)
             : file_name_prefix_(file_name_prefix),
               file_ds_(std::make_unique<std::ofstream>(file_name_prefix_ + ".seq", std::ios_base::binary)),
-              offset_ds_(std::make_unique<std::ofstream>(file_name_prefix_ + ".off", std::ios_base::binary))
+              offset_ds_(std::make_unique<std::ofstream>(file_name_prefix_ + ".off", std::ios_base::binary)),
+              codec_(codec)
 {}
 
 ReadStreamStat BinaryWriter::ToBinary(io::ReadStream<io::SingleReadSeq>& stream,
@@ -11,6 +11,7 @@
 #include "single_read.hpp"
 #include "paired_read.hpp"
 #include "orientation.hpp"
+#include "binary_read_chunk.hpp"
 
 #include "pipeline/library_fwd.hpp"
 
@@ -25,6 +26,7 @@ namespace io {
 class BinaryWriter {
     const std::string file_name_prefix_;
     std::unique_ptr<std::ofstream> file_ds_, offset_ds_;
+    BinaryReadChunk::Codec codec_;
 
     template<class Writer, class Read>
     ReadStreamStat ToBinary(const Writer &writer, io::ReadStream<Read> &stream,
@@ -34,8 +36,16 @@ public:
     typedef size_t CountType;
     static constexpr size_t CHUNK = 100;
     static constexpr size_t BUF_SIZE = 50000;
+    // Written after the stats, changes with the layout of the chunks
+    static constexpr uint64_t FORMAT_VERSION = 2;
 
-    BinaryWriter(const std::string &file_name_prefix);
+    /**
+     * @param codec Deflate to additionally compress every chunk of CHUNK
+     * reads with zlib, Packed to store them as is (2-bit nucleotides and
+     * varint lengths)
+     */
+    BinaryWriter(const std::string &file_name_prefix,
+                 BinaryReadChunk::Codec codec = BinaryReadChunk::Codec::Packed);
 
     ~BinaryWriter() = default;
 
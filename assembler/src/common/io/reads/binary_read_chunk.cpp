@@ -0,0 +1,201 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "binary_read_chunk.hpp"
+
+#include "utils/verify.hpp"
+
+#include <zlib.h>
+
+#include <cstring>
+
+namespace io {
+
+static const size_t NUCLS_PER_WORD = sizeof(seq_element_type) * 4;
+
+static size_t DataSize(size_t nucls) {
+    return (nucls + NUCLS_PER_WORD - 1) / NUCLS_PER_WORD;
+}
+
+static size_t PackedSize(size_t nucls) {
+    return (nucls + 3) / 4;
+}
+
+static void PutULEB128(std::vector<uint8_t> &buf, uint64_t value) {
+    do {
+        uint8_t byte = value & 0x7f;
+        value >>= 7;
+        if (value)
+            byte |= 0x80;
+        buf.push_back(byte);
+    } while (value);
+}
+
+static uint64_t GetULEB128(const uint8_t *&pos, const uint8_t *end) {
+    uint64_t value = 0;
+    for (unsigned shift = 0; ; shift += 7) {
+        VERIFY_MSG(pos != end && shift < 64, "Corrupted binary reads chunk");
+        uint8_t byte = *pos++;
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+}
+
+static uint64_t GetULEB128(MMappedReader &reader) {
+    uint64_t value = 0;
+    for (unsigned shift = 0; ; shift += 7) {
+        VERIFY_MSG(shift < 64, "Corrupted binary reads chunk");
+        uint8_t byte = *static_cast<const uint8_t*>(reader.skip(1));
+        value |= uint64_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+}
+
+void BinaryReadChunk::clear() {
+    records_.clear();
+    buffer_.clear();
+    nucls_ = nullptr;
+}
+
+void BinaryReadChunk::Add(const Sequence &seq, SequenceOffsetT left_offset, SequenceOffsetT right_offset) {
+    size_t size = seq.size();
+    records_.push_back({ size, left_offset, right_offset });
+
+    size_t pos = buffer_.size();
+    buffer_.resize(pos + PackedSize(size));
+    uint8_t *out = buffer_.data() + pos;
+    if (const seq_element_type *words = seq.raw_data()) {
+        // Words keep the first nucleotide in the lowest bits, so their bytes
+        // are taken from the lowest one regardless of the host byte order
+        for (size_t i = 0; i < PackedSize(size); ++i)
+            out[i] = uint8_t(words[i / sizeof(seq_element_type)] >> 8 * (i % sizeof(seq_element_type)));
+        if (size % 4)
+            out[size / 4] &= uint8_t((1u << 2 * (size % 4)) - 1);
+    } else {
+        for (size_t i = 0; i < size; ++i)
+            out[i / 4] = uint8_t(out[i / 4] | (seq[i] << 2 * (i % 4)));
+    }
+}
+
+void BinaryReadChunk::Write(std::ostream &os, Codec codec) const {
+    std::vector<uint8_t> meta;
+    size_t prev_size = 0;
+    for (const auto &record : records_) {
+        // Reads of the library usually have (almost) the same length
+        int64_t delta = int64_t(record.size) - int64_t(prev_size);
+        PutULEB128(meta, (uint64_t(delta) << 1) ^ uint64_t(delta >> 63));
+        PutULEB128(meta, record.left_offset);
+        PutULEB128(meta, record.right_offset);
+        prev_size = record.size;
+    }
+    size_t size = meta.size() + buffer_.size();
+
+    std::vector<uint8_t> compressed;
+    if (codec == Codec::Deflate) {
+        std::vector<uint8_t> payload(meta);
+        payload.insert(payload.end(), buffer_.begin(), buffer_.end());
+
+        uLongf compressed_size = compressBound(uLong(size));
+        compressed.resize(compressed_size);
+        if (compress2(compressed.data(), &compressed_size, payload.data(), uLong(size), Z_BEST_SPEED) == Z_OK &&
+            compressed_size < size) {
+            compressed.resize(compressed_size);
+        } else {
+            compressed.clear();
+            codec = Codec::Packed;
+        }
+    }
+
+    std::vector<uint8_t> header;
+    PutULEB128(header, records_.size());
+    PutULEB128(header, uint8_t(codec));
+    PutULEB128(header, size);
+    PutULEB128(header, codec == Codec::Packed ? size : compressed.size());
+
+    os.write(reinterpret_cast<const char*>(header.data()), header.size());
+    if (codec == Codec::Packed) {
+        os.write(reinterpret_cast<const char*>(meta.data()), meta.size());
+        os.write(reinterpret_cast<const char*>(buffer_.data()), buffer_.size());
+    } else
+        os.write(reinterpret_cast<const char*>(compressed.data()), compressed.size());
+}
+
+void BinaryReadChunk::Parse(MMappedReader &reader) {
+    clear();
+
+    size_t count = GetULEB128(reader);
+    Codec codec = Codec(GetULEB128(reader));
+    size_t size = GetULEB128(reader);
+    size_t stored_size = GetULEB128(reader);
+    const uint8_t *payload = static_cast<const uint8_t*>(reader.skip(stored_size));
+
+    if (codec == Codec::Deflate) {
+        buffer_.resize(size);
+        uLongf inflated = uLong(size);
+        VERIFY_MSG(uncompress(buffer_.data(), &inflated, payload, uLong(stored_size)) == Z_OK && inflated == size,
+                   "Corrupted binary reads chunk");
+        payload = buffer_.data();
+    } else
+        VERIFY_MSG(codec == Codec::Packed && size == stored_size, "Corrupted binary reads chunk");
+
+    const uint8_t *pos = payload, *end = payload + size;
+    records_.reserve(count);
+    size_t prev_size = 0, packed_size = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t zigzag = GetULEB128(pos, end);
+        Record record;
+        record.size = prev_size + size_t(int64_t(zigzag >> 1) ^ -int64_t(zigzag & 1));
+        record.left_offset = SequenceOffsetT(GetULEB128(pos, end));
+        record.right_offset = SequenceOffsetT(GetULEB128(pos, end));
+        records_.push_back(record);
+
+        prev_size = record.size;
+        packed_size += PackedSize(record.size);
+    }
+    VERIFY_MSG(size_t(end - pos) == packed_size, "Corrupted binary reads chunk");
+    nucls_ = pos;
+}
+
+void BinaryReadChunk::Extract(std::vector<SingleReadSeq> &reads) const {
+    // Sequence offsets are limited, very long reads are split between several buffers
+    const size_t MAX_BUFFER_WORDS = (1ull << 30) / NUCLS_PER_WORD;
+
+    const uint8_t *nucls = nucls_;
+    for (size_t begin = 0, end = 0; begin < records_.size(); begin = end) {
+        // Every sequence starts from the word boundary
+        size_t words = 0;
+        for (end = begin; end < records_.size(); ++end) {
+            size_t sz = DataSize(records_[end].size);
+            if (end > begin && words + sz > MAX_BUFFER_WORDS)
+                break;
+            words += sz;
+        }
+
+        Sequence buffer = Sequence::FromRawData(words * NUCLS_PER_WORD, [&](seq_element_type *data) {
+            for (size_t i = begin; i < end; ++i) {
+                size_t sz = DataSize(records_[i].size), packed = PackedSize(records_[i].size);
+                memset(data, 0, sz * sizeof(seq_element_type));
+                for (size_t j = 0; j < packed; ++j)
+                    data[j / sizeof(seq_element_type)] |=
+                            seq_element_type(nucls[j]) << 8 * (j % sizeof(seq_element_type));
+                data += sz;
+                nucls += packed;
+            }
+        });
+
+        size_t start = 0;
+        for (size_t i = begin; i < end; ++i) {
+            const auto &record = records_[i];
+            reads.emplace_back(buffer.Subseq(start, start + record.size),
+                               record.left_offset, record.right_offset);
+            start += DataSize(record.size) * NUCLS_PER_WORD;
+        }
+    }
+}
+
+}
@@ -0,0 +1,80 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "single_read.hpp"
+
+#include "io/kmers/mmapped_reader.hpp"
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+namespace io {
+
+/**
+ * A chunk of single reads as it is stored in the binary read files.
+ *
+ * All integers are ULEB128-encoded. The chunk starts with the number of
+ * reads, the codec, the size of the payload and the size of the stored
+ * (possibly compressed) payload, followed by the stored payload itself.
+ * The payload contains the length (as a zigzag-encoded difference with the
+ * previous one) and the offsets of every read, followed by the nucleotides
+ * of all reads packed 4 per byte, every read starting from a byte boundary.
+ * The first nucleotide of a byte takes its lowest bits, so the files do not
+ * depend on the host byte order.
+ */
+class BinaryReadChunk {
+public:
+    enum class Codec : uint8_t {
+        // The payload is stored as is
+        Packed = 0,
+        // The payload is deflated, if it makes it smaller
+        Deflate = 1
+    };
+
+    void clear();
+
+    size_t size() const {
+        return records_.size();
+    }
+
+    void Add(const Sequence &seq, SequenceOffsetT left_offset, SequenceOffsetT right_offset);
+
+    /**
+     * Writes the reads added so far.
+     */
+    void Write(std::ostream &os, Codec codec) const;
+
+    /**
+     * Reads the next chunk, the nucleotides are not copied unless the chunk
+     * is compressed.
+     */
+    void Parse(MMappedReader &reader);
+
+    /**
+     * Appends the reads of the chunk to reads. The nucleotides of all of them
+     * are copied into a single buffer, so the sequences share the storage
+     * instead of allocating their own.
+     */
+    void Extract(std::vector<SingleReadSeq> &reads) const;
+
+private:
+    struct Record {
+        size_t size;
+        SequenceOffsetT left_offset;
+        SequenceOffsetT right_offset;
+    };
+
+    std::vector<Record> records_;
+    // Nucleotides of the reads being written or the inflated payload
+    std::vector<uint8_t> buffer_;
+    // Nucleotides of the parsed reads
+    const uint8_t *nucls_ = nullptr;
+};
+
+}
@@ -13,15 +13,23 @@
 
 namespace io {
 
-bool BinaryFileSingleStream::ReadImpl(SingleReadSeq &read) {
-    return read.BinRead(stream_);
+void BinaryFileSingleStream::ReadChunkImpl(size_t n, std::vector<SingleReadSeq> &reads) {
+    chunk_.Parse(reader_);
+    VERIFY_MSG(chunk_.size() == n, "Unexpected number of reads in chunk " << chunk_.size() << ", expected " << n);
+    chunk_.Extract(reads);
 }
 
 BinaryFileSingleStream::BinaryFileSingleStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num)
         : BinaryFileStream(file_name_prefix, portion_count, portion_num) {}
 
-bool BinaryFilePairedStream::ReadImpl(PairedReadSeq& read) {
-    return read.BinRead(stream_, insert_size_);
+void BinaryFilePairedStream::ReadChunkImpl(size_t n, std::vector<PairedReadSeq> &reads) {
+    chunk_.Parse(reader_);
+    VERIFY_MSG(chunk_.size() == 2 * n, "Unexpected number of reads in chunk " << chunk_.size() << ", expected " << 2 * n);
+
+    singles_.clear();
+    chunk_.Extract(singles_);
+    for (size_t i = 0; i < n; ++i)
+        reads.emplace_back(singles_[2 * i], singles_[2 * i + 1], insert_size_);
 }
 
 BinaryFilePairedStream::BinaryFilePairedStream(const std::string &file_name_prefix, size_t insert_size,
@@ -11,31 +11,54 @@
 #include "single_read.hpp"
 #include "paired_read.hpp"
 #include "binary_converter.hpp"
+#include "binary_read_chunk.hpp"
 
 #include "utils/verify.hpp"
 #include "utils/logger/logger.hpp"
 #include "utils/filesystem/path_helper.hpp"
 #include "utils/filesystem/file_opener.hpp"
+#include "io/kmers/mmapped_reader.hpp"
 
 #include <fstream>
+#include <vector>
+
+#include <sys/mman.h>
 
 namespace io {
 
 template<typename SeqT>
 class BinaryFileStream {
 protected:
-    std::ifstream stream_;
+    MMappedReader reader_;
 
-    virtual bool ReadImpl(SeqT &read) = 0;
+    /**
+     * Reads the next chunk of n reads from reader_.
+     */
+    virtual void ReadChunkImpl(size_t n, std::vector<SeqT> &reads) = 0;
 
 private:
-    size_t offset_, count_, current_;
+    std::string file_name_;
+    bool is_open_;
+    size_t offset_, end_offset_, count_, current_;
+    std::vector<SeqT> buffer_;
+    size_t buffer_pos_;
 
     void Init() {
-        stream_.clear();
-        stream_.seekg(offset_);
-        VERIFY_MSG(stream_.good(), "Stream is not good(), offset_ " << offset_ << " count_ " << count_);
         current_ = 0;
+        buffer_.clear();
+        buffer_pos_ = 0;
+        if (count_ == 0) {
+            reader_ = MMappedReader();
+            return;
+        }
+
+        // The whole portion is mapped at once, the offset must be page-aligned
+        size_t map_offset = offset_ / getpagesize() * getpagesize();
+        reader_ = MMappedReader(file_name_, false, -1ULL, off_t(map_offset), end_offset_ - map_offset);
+        VERIFY_MSG(reader_.size() == end_offset_ - map_offset,
+                   "Cannot map " << file_name_ << ", offset_ " << offset_ << " count_ " << count_);
+        madvise(reader_.data(), reader_.size(), MADV_SEQUENTIAL);
+        reader_.skip(offset_ - map_offset);
     }
 
 public:
@@ -48,10 +71,16 @@ public:
     BinaryFileStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num) {
         DEBUG("Preparing binary stream #" << portion_num << "/" << portion_count);
         VERIFY(portion_num < portion_count);
-        const std::string fname = file_name_prefix + ".seq";
-        stream_.open(fname, std::ios_base::binary | std::ios_base::in);
+        file_name_ = file_name_prefix + ".seq";
+        std::ifstream stream(file_name_, std::ios_base::binary | std::ios_base::in);
+        is_open_ = stream.is_open();
         ReadStreamStat stat;
-        stat.read(stream_);
+        stat.read(stream);
+        uint64_t version = 0;
+        stream.read(reinterpret_cast<char *>(&version), sizeof(version));
+        CHECK_FATAL_ERROR(!is_open_ || version == BinaryWriter::FORMAT_VERSION,
+                          "Binary reads " << file_name_ << " were written by incompatible version, "
+                          "remove them to convert the reads again");
 
         const std::string offset_name = file_name_prefix + ".off";
         const size_t chunk_count = fs::filesize(offset_name) / sizeof(size_t);
@@ -85,10 +114,19 @@ public:
             count_ = std::min(stat.read_count - start_num,
                               (is_big_portion ? big_portion_size : small_portion_size) * BinaryWriter::CHUNK);
 
+            // The portion ends where the next one starts
+            const size_t next_chunk_num = chunk_num + (is_big_portion ? big_portion_size : small_portion_size);
+            if (next_chunk_num < chunk_count) {
+                offset_stream.seekg(next_chunk_num * sizeof(size_t));
+                offset_stream.read(reinterpret_cast<char *>(&end_offset_), sizeof(end_offset_));
+                VERIFY(offset_stream);
+            } else
+                end_offset_ = fs::filesize(file_name_);
+
             DEBUG("Reads " << start_num << "-" << start_num + count_ << "/" << stat.read_count << " from " << offset_);
         } else {  // current portion has size 0 (the case of chunk_count == 0 is also included here)
             // Setup safe offset value
-            offset_ = sizeof(ReadStreamStat);
+            offset_ = end_offset_ = sizeof(ReadStreamStat) + sizeof(uint64_t);
             count_ = 0;
             DEBUG("Empty BinaryFileStream constructed");
         }
@@ -103,14 +141,19 @@ public:
             : BinaryFileStream(file_name_prefix, 1, 0) {}
 
     BinaryFileStream<SeqT>& operator>>(SeqT &read) {
-        ReadImpl(read);
         VERIFY(current_ < count_);
+        if (buffer_pos_ == buffer_.size()) {
+            buffer_.clear();
+            buffer_pos_ = 0;
+            ReadChunkImpl(std::min(BinaryWriter::CHUNK, count_ - current_), buffer_);
+        }
+        read = std::move(buffer_[buffer_pos_++]);
         ++current_;
         return *this;
     }
 
     bool is_open() {
-        return stream_.is_open();
+        return is_open_;
     }
 
     bool eof() {
@@ -119,7 +162,9 @@ public:
 
     void close() {
         current_ = 0;
-        stream_.close();
+        buffer_.clear();
+        buffer_pos_ = 0;
+        reader_ = MMappedReader();
     }
 
     void reset() {
@@ -129,16 +174,19 @@ public:
 };
 
 class BinaryFileSingleStream : public BinaryFileStream<SingleReadSeq>  {
+    BinaryReadChunk chunk_;
 protected:
-    bool ReadImpl(SingleReadSeq &read) override;
+    void ReadChunkImpl(size_t n, std::vector<SingleReadSeq> &reads) override;
 public:
     BinaryFileSingleStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num);
 };
 
 class BinaryFilePairedStream: public BinaryFileStream<PairedReadSeq> {
     size_t insert_size_;
+    BinaryReadChunk chunk_;
+    std::vector<SingleReadSeq> singles_;
 protected:
-    bool ReadImpl(PairedReadSeq& read) override;
+    void ReadChunkImpl(size_t n, std::vector<PairedReadSeq> &reads) override;
 public:
     BinaryFilePairedStream(const std::string &file_name_prefix, size_t insert_size,
                            size_t portion_count, size_t portion_num);
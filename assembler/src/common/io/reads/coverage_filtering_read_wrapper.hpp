@@ -7,6 +7,7 @@
 #pragma once
 
 #include "filtering_reader_wrapper.hpp"
+#include "paired_read.hpp"
 
 #include "sequence/sequence.hpp"
 
@@ -15,6 +16,7 @@
 #include "utils/kmer_counting.hpp"
 
 #include <memory>
+#include <vector>
 
 namespace io {
 
@@ -97,13 +99,65 @@ public:
 
 };
 
+/**
+ * Filters out the reads with low median k-mer multiplicity. The decision is
+ * remembered for every read passed through, so the subsequent passes over
+ * the same stream (after reset()) do not hash and look up the k-mers again.
+ */
+template<class ReadType, class Hasher>
+class CoverageFilteringReaderWrapper : public DelegatingWrapper<ReadType> {
+    typedef DelegatingWrapper<ReadType> base;
+public:
+    CoverageFilteringReaderWrapper(typename base::ReadStreamT reader,
+                                   const CoverageFilter<ReadType, Hasher> &filter)
+            : base(std::move(reader)), filter_(filter), pos_(0), eof_(false) {
+        StepForward();
+    }
+
+    bool eof() {
+        return eof_;
+    }
+
+    CoverageFilteringReaderWrapper& operator>>(ReadType &read) {
+        read = std::move(next_read_);
+        StepForward();
+        return *this;
+    }
+
+    void reset() {
+        base::reset();
+        pos_ = 0;
+        eof_ = false;
+        StepForward();
+    }
+
+private:
+    CoverageFilter<ReadType, Hasher> filter_;
+    // Decisions for the first passed.size() reads of the underlying stream
+    std::vector<bool> passed_;
+    size_t pos_;
+    bool eof_;
+    ReadType next_read_;
+
+    void StepForward() {
+        while (!base::eof()) {
+            base::operator>>(next_read_);
+
+            if (pos_ == passed_.size())
+                passed_.push_back(filter_(next_read_));
+            if (passed_[pos_++])
+                return;
+        }
+        eof_ = true;
+    }
+};
+
 template<class ReadType, class Hasher>
 inline ReadStream<ReadType> CovFilteringWrap(ReadStream<ReadType> reader,
                                              unsigned k, const Hasher &hasher,
                                              const utils::CQFKmerFilter &cqf, unsigned thr) {
     CoverageFilter<ReadType, Hasher> filter(k, hasher, cqf, thr);
-    return io::FilteringWrap<ReadType>(std::move(reader),
-                                       [=](const ReadType &r) { return filter(r); });
+    return CoverageFilteringReaderWrapper<ReadType, Hasher>(std::move(reader), filter);
 }
 
 template<class ReadType, class Hasher>
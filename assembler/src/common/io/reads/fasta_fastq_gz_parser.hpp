@@ -8,6 +8,7 @@
 #pragma once
 
 #include "single_read.hpp"
+#include "inflating_reader.hpp"
 
 #include "utils/verify.hpp"
 #include "io/reads/parser.hpp"
@@ -16,18 +17,21 @@
 
 #include "kseq/kseq.h"
 
-#include <zlib.h>
+#include <memory>
 #include <string>
 
 namespace io {
 
 namespace fastafastqgz {
-// STEP 1: declare the type of file handler and the read() function
+inline int ReadInflated(InflatingReader *reader, void *buf, unsigned len) {
+    return reader->read(buf, len);
+}
+
 // Silence bogus gcc warnings
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wconversion"
 // STEP 1: declare the type of file handler and the read() function
-KSEQ_INIT(gzFile, gzread)
+KSEQ_INIT(InflatingReader*, ReadInflated)
 #pragma GCC diagnostic pop
 }
 
@@ -90,7 +94,7 @@ public:
         // STEP 5: destroy seq
         fastafastqgz::kseq_destroy(seq_);
         // STEP 6: close the file handler
-        gzclose(fp_);
+        fp_.reset();
         is_open_ = false;
         eof_ = true;
     }
@@ -99,7 +103,7 @@ private:
     /*
      * @variable File that is associated with gzipped data file.
      */
-    gzFile fp_;
+    std::unique_ptr<InflatingReader> fp_;
     /*
      * @variable Data element that stores last SingleRead got from
      * stream.
@@ -112,13 +116,14 @@ private:
     /* virtual */
     void open() {
         // STEP 2: open the file handler
-        fp_ = gzopen(filename_.c_str(), "r");
-        if (!fp_) {
+        fp_ = std::make_unique<InflatingReader>(filename_, unsigned(flags_.inflate_threads));
+        if (!fp_->is_open()) {
+            fp_.reset();
             is_open_ = false;
             return;
         }
         // STEP 3: initialize seq
-        seq_ = fastafastqgz::kseq_init(fp_);
+        seq_ = fastafastqgz::kseq_init(fp_.get());
         eof_ = false;
         is_open_ = true;
         ReadAhead();
@@ -26,15 +26,17 @@ struct FileReadFlags {
     bool use_name     : 1;
     bool use_quality  : 1;
     bool validate     : 1;
+    // Number of threads to inflate gzipped files in background, 0 for none
+    unsigned inflate_threads : 16;
 
     FileReadFlags()
-            : offset(PhredOffset), use_name(true), use_quality(true), validate(true) {}
+            : offset(PhredOffset), use_name(true), use_quality(true), validate(true), inflate_threads(0) {}
     FileReadFlags(OffsetType o)
-            : offset(o), use_name(true), use_quality(true) {}
+            : offset(o), use_name(true), use_quality(true), inflate_threads(0) {}
     FileReadFlags(OffsetType o, bool n, bool q)
-            : offset(o), use_name(n), use_quality(q) {}
+            : offset(o), use_name(n), use_quality(q), inflate_threads(0) {}
     FileReadFlags(OffsetType o, bool n, bool q, bool v)
-            : offset(o), use_name(n), use_quality(q), validate(v) {}
+            : offset(o), use_name(n), use_quality(q), validate(v), inflate_threads(0) {}
 
 };
 
@@ -0,0 +1,283 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "inflating_reader.hpp"
+
+#include "utils/logger/logger.hpp"
+#include "utils/verify.hpp"
+
+#include "threadpool/threadpool.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <future>
+
+namespace io {
+
+// Decompressed data is passed to the reader in buffers of this size
+static const size_t BUFFER_SIZE = 1 << 20;
+// How many buffers the inflating thread could be ahead of the reader
+static const size_t MAX_QUEUED_BUFFERS = 8;
+// BGZF blocks are at most 64 Kb, so this is ~4 Mb of decompressed data per batch
+static const size_t BGZF_BATCH_BLOCKS = 64;
+
+static const size_t GZIP_HEADER_SIZE = 12;
+static const size_t GZIP_TRAILER_SIZE = 8;
+static const unsigned char GZIP_FEXTRA = 4;
+
+static uint32_t LoadLE(const unsigned char *p, size_t bytes) {
+    uint32_t res = 0;
+    for (size_t i = bytes; i > 0; --i)
+        res = (res << 8) | p[i - 1];
+    return res;
+}
+
+InflatingReader::InflatingReader(const std::string &filename, unsigned nthreads)
+        : filename_(filename), nthreads_(nthreads), is_open_(false),
+          gz_(nullptr), file_(nullptr),
+          finished_(false), failed_(false), stopped_(false), pos_(0) {
+    if (nthreads_ == 0) {
+        gz_ = gzopen(filename_.c_str(), "r");
+        is_open_ = (gz_ != nullptr);
+        return;
+    }
+
+    file_ = fopen(filename_.c_str(), "rb");
+    if (!file_)
+        return;
+    is_open_ = true;
+
+    if (IsBGZF(file_)) {
+        DEBUG("Inflating BGZF file " << filename_ << " using " << nthreads_ << " threads");
+        if (nthreads_ > 1)
+            pool_ = std::make_unique<ThreadPool::ThreadPool>(nthreads_);
+        inflater_ = std::thread([this] { InflateBGZF(); });
+        return;
+    }
+
+    // Plain gzip (or uncompressed file), only one thread can inflate it
+    fclose(file_);
+    file_ = nullptr;
+    gz_ = gzopen(filename_.c_str(), "r");
+    if (!gz_) {
+        is_open_ = false;
+        return;
+    }
+    inflater_ = std::thread([this] { InflateGzip(); });
+}
+
+InflatingReader::~InflatingReader() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopped_ = true;
+    }
+    cv_.notify_all();
+
+    if (inflater_.joinable())
+        inflater_.join();
+    if (gz_)
+        gzclose(gz_);
+    if (file_)
+        fclose(file_);
+}
+
+int InflatingReader::read(void *buf, unsigned len) {
+    if (nthreads_ == 0)
+        return gzread(gz_, buf, len);
+
+    if (pos_ == current_.size()) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return !queue_.empty() || finished_; });
+        if (queue_.empty()) {
+            if (failed_)
+                FATAL_ERROR("Failed to decompress " << filename_ << ", the file is probably corrupted");
+            return 0;
+        }
+
+        current_ = std::move(queue_.front());
+        queue_.pop_front();
+        pos_ = 0;
+        lock.unlock();
+        cv_.notify_all();
+    }
+
+    size_t n = std::min(size_t(len), current_.size() - pos_);
+    memcpy(buf, current_.data() + pos_, n);
+    pos_ += n;
+    return int(n);
+}
+
+bool InflatingReader::Push(Buffer buffer) {
+    VERIFY(!buffer.empty());
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this] { return queue_.size() < MAX_QUEUED_BUFFERS || stopped_; });
+    if (stopped_)
+        return false;
+
+    queue_.push_back(std::move(buffer));
+    lock.unlock();
+    cv_.notify_all();
+    return true;
+}
+
+void InflatingReader::Finish(bool failed) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+        failed_ = failed;
+    }
+    cv_.notify_all();
+}
+
+void InflatingReader::InflateGzip() {
+    while (true) {
+        Buffer buffer(BUFFER_SIZE);
+        int read = gzread(gz_, buffer.data(), unsigned(buffer.size()));
+        if (read <= 0) {
+            Finish(read < 0);
+            return;
+        }
+
+        buffer.resize(size_t(read));
+        if (!Push(std::move(buffer)))
+            return;
+    }
+}
+
+// BGZF is a series of gzip members with "BC" extra subfield holding the
+// compressed size of the member
+bool InflatingReader::IsBGZF(FILE *file) {
+    unsigned char header[GZIP_HEADER_SIZE + 6];
+    size_t read = fread(header, 1, sizeof(header), file);
+    rewind(file);
+
+    return read == sizeof(header) &&
+           header[0] == 0x1f && header[1] == 0x8b && header[2] == Z_DEFLATED &&
+           (header[3] & GZIP_FEXTRA) &&
+           LoadLE(header + 10, 2) >= 6 &&
+           header[12] == 'B' && header[13] == 'C' && LoadLE(header + 14, 2) == 2;
+}
+
+bool InflatingReader::ReadBGZFBlock(BGZFBlock &block) {
+    unsigned char header[GZIP_HEADER_SIZE];
+    size_t read = fread(header, 1, sizeof(header), file_);
+    if (read == 0 && feof(file_)) {
+        block.data.clear();
+        return true;
+    }
+    if (read != sizeof(header) ||
+        header[0] != 0x1f || header[1] != 0x8b || header[2] != Z_DEFLATED ||
+        !(header[3] & GZIP_FEXTRA))
+        return false;
+
+    size_t extra_size = LoadLE(header + 10, 2);
+    Buffer extra(extra_size);
+    if (fread(extra.data(), 1, extra_size, file_) != extra_size)
+        return false;
+
+    size_t block_size = 0;
+    for (size_t pos = 0; pos + 4 <= extra_size; pos += 4 + LoadLE(extra.data() + pos + 2, 2)) {
+        if (extra[pos] == 'B' && extra[pos + 1] == 'C' && LoadLE(extra.data() + pos + 2, 2) == 2) {
+            block_size = LoadLE(extra.data() + pos + 4, 2) + 1;
+            break;
+        }
+    }
+
+    block.header_size = GZIP_HEADER_SIZE + extra_size;
+    if (block_size < block.header_size + GZIP_TRAILER_SIZE)
+        return false;
+
+    block.data.resize(block_size);
+    std::copy(header, header + GZIP_HEADER_SIZE, block.data.begin());
+    std::copy(extra.begin(), extra.end(), block.data.begin() + GZIP_HEADER_SIZE);
+    size_t rest = block_size - block.header_size;
+    if (fread(block.data.data() + block.header_size, 1, rest, file_) != rest)
+        return false;
+
+    block.inflated_size = LoadLE(block.data.data() + block_size - 4, 4);
+    return true;
+}
+
+bool InflatingReader::InflateBGZFBlock(const BGZFBlock &block, unsigned char *out) {
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, -MAX_WBITS) != Z_OK)
+        return false;
+
+    // Empty blocks (e.g. the EOF marker) have nowhere to inflate to, while
+    // zlib refuses a null output pointer even when there is nothing to write
+    unsigned char empty;
+    if (block.inflated_size == 0)
+        out = &empty;
+
+    zs.next_in = const_cast<unsigned char*>(block.data.data() + block.header_size);
+    zs.avail_in = unsigned(block.data.size() - block.header_size - GZIP_TRAILER_SIZE);
+    zs.next_out = out;
+    zs.avail_out = unsigned(block.inflated_size);
+    int res = inflate(&zs, Z_FINISH);
+    size_t inflated = zs.total_out;
+    inflateEnd(&zs);
+
+    uint32_t crc = LoadLE(block.data.data() + block.data.size() - GZIP_TRAILER_SIZE, 4);
+    return res == Z_STREAM_END && inflated == block.inflated_size &&
+           crc32(0L, out, unsigned(inflated)) == crc;
+}
+
+void InflatingReader::InflateBGZF() {
+    std::vector<BGZFBlock> blocks(BGZF_BATCH_BLOCKS);
+    std::vector<size_t> offsets(BGZF_BATCH_BLOCKS + 1);
+    while (true) {
+        // Read the raw blocks of the batch, the file is read by this thread only
+        size_t n = 0;
+        offsets[0] = 0;
+        for (; n < BGZF_BATCH_BLOCKS; ++n) {
+            if (!ReadBGZFBlock(blocks[n])) {
+                Finish(true);
+                return;
+            }
+            if (blocks[n].data.empty())
+                break;
+            offsets[n + 1] = offsets[n] + blocks[n].inflated_size;
+        }
+
+        if (n == 0) {
+            Finish(false);
+            return;
+        }
+
+        // Blocks are independent, so they are inflated right into their places
+        Buffer buffer(offsets[n]);
+        bool failed = false;
+        if (pool_) {
+            size_t parts = std::min(size_t(nthreads_), n);
+            std::vector<std::future<bool>> results;
+            for (size_t part = 0; part < parts; ++part) {
+                results.push_back(pool_->run([&, part] {
+                    bool ok = true;
+                    for (size_t i = part; i < n; i += parts)
+                        ok &= InflateBGZFBlock(blocks[i], buffer.data() + offsets[i]);
+                    return ok;
+                }));
+            }
+            for (auto &result : results)
+                failed |= !result.get();
+        } else {
+            for (size_t i = 0; i < n; ++i)
+                failed |= !InflateBGZFBlock(blocks[i], buffer.data() + offsets[i]);
+        }
+
+        if (failed) {
+            Finish(true);
+            return;
+        }
+
+        // The last (EOF marker) block is empty
+        if (!buffer.empty() && !Push(std::move(buffer)))
+            return;
+    }
+}
+
+}
@@ -0,0 +1,97 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <zlib.h>
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ThreadPool {
+class ThreadPool;
+}
+
+namespace io {
+
+/*
+ * Source of the decompressed contents of a (possibly gzipped) file.
+ *
+ * Without threads it is just gzread() in the calling thread. Otherwise the
+ * file is inflated by a dedicated thread ahead of the reader, so that
+ * decompression and parsing overlap. BGZF files (as written by bgzip) consist
+ * of independent blocks, which are inflated by up to nthreads threads at once.
+ */
+class InflatingReader {
+public:
+    /*
+     * @param filename The name of the file to be opened.
+     * @param nthreads Number of threads to inflate the file, 0 for no
+     * background inflation.
+     */
+    InflatingReader(const std::string &filename, unsigned nthreads = 0);
+
+    ~InflatingReader();
+
+    bool is_open() const {
+        return is_open_;
+    }
+
+    /*
+     * Reads up to len bytes into buf, as gzread() does.
+     *
+     * @return Number of bytes read, 0 at the end of file.
+     */
+    int read(void *buf, unsigned len);
+
+private:
+    typedef std::vector<unsigned char> Buffer;
+
+    struct BGZFBlock {
+        Buffer data;
+        size_t header_size;
+        size_t inflated_size;
+    };
+
+    static bool IsBGZF(FILE *file);
+    bool ReadBGZFBlock(BGZFBlock &block);
+    static bool InflateBGZFBlock(const BGZFBlock &block, unsigned char *out);
+
+    void InflateGzip();
+    void InflateBGZF();
+
+    // Returns false if the reader is being destroyed
+    bool Push(Buffer buffer);
+    void Finish(bool failed);
+
+    std::string filename_;
+    unsigned nthreads_;
+    bool is_open_;
+
+    gzFile gz_;
+    FILE *file_;
+    std::unique_ptr<ThreadPool::ThreadPool> pool_;
+
+    std::thread inflater_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Buffer> queue_;
+    bool finished_, failed_, stopped_;
+
+    Buffer current_;
+    size_t pos_;
+
+    InflatingReader(const InflatingReader &) = delete;
+    void operator=(const InflatingReader &) = delete;
+};
+
+}
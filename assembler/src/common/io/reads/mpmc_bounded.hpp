@@ -31,6 +31,8 @@ ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 */
 
+#pragma once
+
 #include <ciso646>
 
 #if __GNUC__ > 4 || (__GNUC__ >= 4 && __GNUC_MINOR__ >= 5) || _LIBCPP_VERSION
@@ -143,6 +145,17 @@ public:
         return true;
     }
 
+    bool wait_enqueue(T &&data) {
+        bool res = false;
+        do {
+            res = enqueue(std::move(data));
+            if (!res)
+                usleep(1);
+        } while (!res && !is_closed());
+
+        return res;
+    }
+
     bool wait_dequeue(T &data) {
         bool res = false;
         do {
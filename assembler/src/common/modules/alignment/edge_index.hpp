@@ -12,6 +12,13 @@
 #include "assembly_graph/core/action_handlers.hpp"
 #include "assembly_graph/index/edge_info_updater.hpp"
 #include "edge_index_refiller.hpp"
+#include "sequence/canonical_kmer_roller.hpp"
+
+#include <parallel_hashmap/phmap.h>
+#include <llvm/ADT/SmallVector.h>
+
+#include <algorithm>
+#include <mutex>
 
 
 namespace io { namespace binary {
@@ -24,6 +31,12 @@ namespace debruijn_graph {
 /**
  * EdgeIndex is a structure to store info about location of certain k-mers in graph. It delegates all
  * container procedures to inner_index_ and all handling procedures to updater_.
+ *
+ * Massive graph modifications (e.g. simplification) could be made with the
+ * updates deferred: the handlers only remember the added and deleted edges
+ * and Update() brings the index up to date afterwards, touching the k-mers of
+ * the added edges only. The index is rebuilt from scratch when the new k-mers
+ * do not fit into its MPHF well anymore.
  */
 template<class Graph>
 class EdgeIndex: public omnigraph::GraphActionHandler<Graph> {
@@ -42,8 +55,21 @@ private:
     EdgeInfoUpdater<Graph> updater_;
     EdgeIndexRefiller refiller_;
 
-    template<class Index>
-    std::pair<EdgeId, size_t> get(const Index *index, const KMer& kmer) const {
+    // The index is rebuilt when the overflow table holds more than this part
+    // of the k-mers, or less than this part of the slots are in use
+    static constexpr double MAX_OVERFLOW = 0.125;
+    static constexpr double MIN_LOAD = 0.25;
+
+    bool deferred_;
+    std::mutex pending_lock_;
+    phmap::flat_hash_set<EdgeId> added_;
+    std::vector<bool> deleted_;
+
+    template<class Index, class Key>
+    std::pair<EdgeId, size_t> get(const Index *index, const Key& kmer) const {
+        if (deferred_)
+            return { EdgeId(), NOT_FOUND };
+
         auto kwh = index->ConstructKWH(kmer);
         if (index->contains(kwh)) {
             auto entry = index->get_value(kwh);
@@ -53,9 +79,35 @@ private:
         return { EdgeId(), NOT_FOUND };
     }
 
+    template<class Index, class Key>
+    void get(const Index *index, const Key *kmers, size_t n,
+             std::pair<EdgeId, size_t> *res) const {
+        if (deferred_) {
+            std::fill(res, res + n, std::make_pair(EdgeId(), NOT_FOUND));
+            return;
+        }
+
+        // K-mers are looked up in windows, so that the buffer stays on the stack
+        constexpr size_t WINDOW = 64;
+        llvm::SmallVector<typename Index::KeyWithHash, WINDOW> kwhs;
+        for (size_t start = 0; start < n; start += WINDOW) {
+            size_t cnt = std::min(WINDOW, n - start);
+            kwhs.clear();
+            index->ConstructKWH(kmers + start, cnt, kwhs);
+            for (size_t i = 0; i < cnt; ++i) {
+                const auto &kwh = kwhs[i];
+                if (index->contains(kwh)) {
+                    auto entry = index->get_value(kwh);
+                    res[start + i] = { entry.edge(), (size_t)entry.offset() };
+                } else
+                    res[start + i] = { EdgeId(), NOT_FOUND };
+            }
+        }
+    }
+
     template<class Index>
     bool contains(const Index *index, const KMer& kmer) const {
-        return index->contains(index->ConstructKWH(kmer));
+        return !deferred_ && index->contains(index->ConstructKWH(kmer));
     }
 
     template<class Index>
@@ -68,6 +120,22 @@ private:
         updater_.DeleteKmers(this->g(), e, *index);
     }
 
+    template<class Index>
+    bool Update(Index *index) {
+        if (!index)
+            return false;
+
+        index->RemoveIf([this](EdgeId e) {
+            return e.int_id() < deleted_.size() && deleted_[e.int_id()];
+        });
+        updater_.Update(this->g(), *index, std::vector<EdgeId>(added_.begin(), added_.end()));
+
+        size_t occupied = index->occupied(), overflow = index->overflow_size();
+        INFO("Index updated, " << occupied << " k-mers in place, " << overflow << " in overflow table");
+        return double(overflow) > MAX_OVERFLOW * double(occupied + overflow) ||
+               double(occupied) < MIN_LOAD * double(index->size());
+    }
+
     template<class Index>
     void clear(Index *index) {
         if (!inner_index_)
@@ -109,7 +177,7 @@ public:
     EdgeIndex(const Graph& g, const std::string &workdir)
             : omnigraph::GraphActionHandler<Graph>(g, "EdgeIndex"),
               large_index_(true), inner_index_(nullptr),
-              refiller_(workdir) {
+              refiller_(workdir), deferred_(false) {
         INFO("Size of edge index entries: "
              << sizeof(typename InnerIndex64::KmerPos) << "/"
              << sizeof(typename InnerIndex32::KmerPos));
@@ -134,13 +202,65 @@ public:
     } while(0)
 
     void HandleAdd(EdgeId e) override {
+        if (deferred_) {
+            std::lock_guard<std::mutex> guard(pending_lock_);
+            added_.insert(e);
+            return;
+        }
         DISPATCH_TO(UpdateKmers, e);
     }
 
     void HandleDelete(EdgeId e) override {
+        if (deferred_) {
+            std::lock_guard<std::mutex> guard(pending_lock_);
+            // The k-mers of the edges added since are not in the index yet
+            if (added_.erase(e))
+                return;
+            if (deleted_.size() <= e.int_id())
+                deleted_.resize(std::max(this->g().max_eid(), e.int_id() + 1));
+            deleted_[e.int_id()] = true;
+            return;
+        }
         DISPATCH_TO(DeleteKmers, e);
     }
 
+    // Only the deferred updates are cheap enough to be done concurrently
+    bool IsThreadSafe() const override {
+        return deferred_;
+    }
+
+    /**
+     * Defers the updates until the next Update() call. Nothing is found in
+     * the index in between.
+     */
+    void DeferUpdates() {
+        VERIFY(this->IsAttached());
+        deferred_ = true;
+    }
+
+    bool IsDeferred() const {
+        return deferred_;
+    }
+
+    /**
+     * Applies the deferred updates, rebuilding the index if needed.
+     */
+    void Update() {
+        if (!deferred_)
+            return;
+
+        bool rebuild;
+        if (large_index_)
+            rebuild = Update(static_cast<InnerIndex64*>(inner_index_));
+        else
+            rebuild = Update(static_cast<InnerIndex32*>(inner_index_));
+        ResetDeferred();
+        if (rebuild) {
+            INFO("Too many k-mers are out of place, rebuilding the index");
+            Refill();
+        }
+    }
+
     bool contains(const KMer& kmer) const {
         DISPATCH_TO(contains, kmer);
     }
@@ -149,6 +269,27 @@ public:
         DISPATCH_TO(get, kmer);
     }
 
+    /**
+     * Looks up n k-mers at once. Hashing, MPHF and value accesses of all the
+     * k-mers are issued before any of them is resolved, so this is faster than
+     * n separate get() calls.
+     */
+    void get(const KMer *kmers, size_t n, std::pair<EdgeId, size_t> *res) const {
+        DISPATCH_TO(get, kmers, n, res);
+    }
+
+    /**
+     * Same as above, but the canonical k-mers are taken from the rollers
+     * instead of being reverse complemented once again.
+     */
+    std::pair<EdgeId, size_t> get(const CanonicalKMerRoller<KMer>& kmer) const {
+        DISPATCH_TO(get, kmer);
+    }
+
+    void get(const CanonicalKMerRoller<KMer> *kmers, size_t n, std::pair<EdgeId, size_t> *res) const {
+        DISPATCH_TO(get, kmers, n, res);
+    }
+
     void Refill() {
         clear();
         uint64_t max_id = this->g().max_eid();
@@ -171,6 +312,7 @@ public:
     }
 
     void clear() {
+        ResetDeferred();
         DISPATCH_TO(clear);
     }
 
@@ -182,6 +324,7 @@ public:
 
     template<class Writer>
     void BinWrite(Writer &writer) const {
+        VERIFY(!deferred_);
         writer << large_index_;
         DISPATCH_TO(BinWrite, writer);
     }
@@ -193,6 +336,13 @@ public:
         DISPATCH_TO(BinRead, reader);
     }
 
+private:
+    void ResetDeferred() {
+        deferred_ = false;
+        added_.clear();
+        deleted_.clear();
+        deleted_.shrink_to_fit();
+    }
 };
 
 #undef DISPATCH_TO
@@ -12,11 +12,16 @@
 #include "common/utils/logger/logger.hpp"
 #include "utils/filesystem/file_opener.hpp"
 
+#include "adt/iterator_range.hpp"
+
+#include <parallel_hashmap/phmap.h>
+
 #include <string>
 #include <vector>
 #include <map>
 #include <set>
 #include <algorithm>
+#include <numeric>
 
 namespace debruijn_graph {
 
@@ -62,89 +67,158 @@ public:
     }
 };
 
+/**
+ * Storage of the distinct edge paths (long reads, trusted contigs) with
+ * their weights. Paths live one after another in a single edge arena and are
+ * referred to by their ids; a hash set over the ids (hashing the path itself)
+ * finds the duplicates. Iteration and serialization go in the lexicographic
+ * order of the paths, i.e. grouped by their first edge.
+ */
 template<class Graph>
 class PathStorage {
-    friend class PathInfo<Graph> ;
     typedef typename Graph::EdgeId EdgeId;
-    typedef std::map<EdgeId, std::set<PathInfo<Graph>>> InnerIndex;
+    typedef typename std::vector<EdgeId>::const_iterator edge_const_iterator;
+
+    struct PathHash {
+        const PathStorage *storage;
+
+        size_t operator()(size_t id) const {
+            size_t h = 0;
+            for (EdgeId e : storage->path(id))
+                h = phmap::HashState().combine(h, e.int_id());
+            return h;
+        }
+    };
+
+    struct PathEq {
+        const PathStorage *storage;
+
+        bool operator()(size_t id1, size_t id2) const {
+            auto p1 = storage->path(id1), p2 = storage->path(id2);
+            return std::equal(p1.begin(), p1.end(), p2.begin(), p2.end());
+        }
+    };
+
+    typedef phmap::flat_hash_set<size_t, PathHash, PathEq> PathSet;
 
     const Graph &g_;
-    InnerIndex inner_index_;
+    std::vector<EdgeId> edges_;
+    // Path i occupies edges_[offsets_[i], offsets_[i + 1])
+    std::vector<size_t> offsets_;
+    std::vector<size_t> weights_;
+    PathSet paths_;
+
     static const size_t kLongEdgeForStats = 500;
 
-    void HiddenAddPath(const std::vector<EdgeId> &p, int w) {
+    void HiddenAddPath(const std::vector<EdgeId> &p, size_t w) {
         if (p.size() == 0 ) return;
-        for (typename std::set<PathInfo<Graph>>::iterator iter = inner_index_[p[0]].begin(); iter != inner_index_[p[0]].end(); ++iter) {
-            if (iter->path() == p) {
-                iter->increase_weight(w);
-                return;
-            }
+
+        // Put the path in place first, so that the set can compare it with the others
+        size_t id = weights_.size();
+        edges_.insert(edges_.end(), p.begin(), p.end());
+        offsets_.push_back(edges_.size());
+        weights_.push_back(w);
+
+        auto res = paths_.insert(id);
+        if (!res.second) {
+            weights_[*res.first] += w;
+            weights_.pop_back();
+            offsets_.pop_back();
+            edges_.resize(offsets_.back());
+        }
+    }
+
+    // Ids of the paths in the lexicographic order
+    std::vector<size_t> SortedIds() const {
+        std::vector<size_t> ids(size());
+        std::iota(ids.begin(), ids.end(), 0);
+        std::sort(ids.begin(), ids.end(), [this](size_t id1, size_t id2) {
+            auto p1 = path(id1), p2 = path(id2);
+            return std::lexicographical_compare(p1.begin(), p1.end(), p2.begin(), p2.end());
+        });
+        return ids;
+    }
+
+    // Calls f(first_edge, ids) for the groups of the sorted ids of the paths
+    // sharing the first edge
+    template<class F>
+    void ForEachGroup(const std::vector<size_t> &ids, F f) const {
+        for (auto group = ids.begin(); group != ids.end(); ) {
+            EdgeId first = edges_[offsets_[*group]];
+            auto group_end = std::find_if(group, ids.end(),
+                                          [&](size_t id) { return edges_[offsets_[id]] != first; });
+            f(first, adt::make_range(group, group_end));
+            group = group_end;
         }
-        inner_index_[p[0]].insert(PathInfo<Graph>(p, w));
-        size_++;
     }
 
 public:
     PathStorage(const Graph &g)
-            : g_(g),
-              inner_index_(),
-              size_(0) {
+            : g_(g), offsets_(1, 0),
+              paths_(0, PathHash{this}, PathEq{this}) {
     }
 
-    PathStorage(const PathStorage & p)
-            : g_(p.g_),
-              inner_index_(),
-              size_(0) {
-        for (auto iter = p.inner_index_.begin(); iter != p.inner_index_.end();
-                iter++) {
-            for (auto j_iter = iter->second.begin();
-                    j_iter != iter->second.end(); j_iter++) {
-                this->AddPath(j_iter->path(), (int) j_iter->weight());
-            }
-        }
+    PathStorage(const PathStorage &p)
+            : g_(p.g_), edges_(p.edges_), offsets_(p.offsets_), weights_(p.weights_),
+              paths_(0, PathHash{this}, PathEq{this}) {
+        paths_.reserve(size());
+        for (size_t id = 0; id < size(); ++id)
+            paths_.insert(id);
     }
 
-    void ReplaceEdges(std::map<EdgeId, EdgeId> &old_to_new){
-        std::map<int, EdgeId> tmp_map;
-//        for (auto iter = g_.SmartEdgeBegin(); !iter.IsEnd(); ++iter ){
-//            tmp_map[g_.int_id(*iter)] = *iter;
-//        }
-        InnerIndex new_index;
-        for (auto iter = inner_index_.begin(); iter != inner_index_.end(); iter++) {
-            auto tmp = iter->second;
-            EdgeId new_first;
-            if (old_to_new.find(iter->first) == old_to_new.end())
-                new_first = iter->first;
-            else {
-                DEBUG("new first edge: "<< g_.int_id(old_to_new[iter->first]) << " with " << tmp.size() << " edges ");
-                new_first = old_to_new[iter->first];
-            }
-            std::set<PathInfo<Graph>> new_tmp;
-            for (auto j_iter = tmp.begin(); j_iter != tmp.end(); j_iter++) {
-                PathInfo<Graph> pi = *(j_iter);
-                for (size_t k = 0; k < pi.path().size(); k++)
-                    if (old_to_new.find(pi.path()[k]) != old_to_new.end()) {
-//                        INFO(g_.int_id(old_to_new[pi.path[k]]));
-                        pi.path()[k] = old_to_new[pi.path()[k]];
-                    }
-                DEBUG(pi.str(g_));
-                new_tmp.insert(pi);
+    size_t size() const {
+        return weights_.size();
+    }
 
-            }
-            if (new_first != iter->first) {
-                TRACE("and mmew_tmp.size: "<< new_tmp.size());
-            }
-            if (new_index.find(new_first) == new_index.end()) {
-                new_index[new_first] = new_tmp;
-            } else {
-                for (auto j_iter = new_tmp.begin(); j_iter != new_tmp.end(); j_iter++) {
-                    new_index[new_first].insert(*j_iter);
-                }
-            }
+    adt::iterator_range<edge_const_iterator> path(size_t id) const {
+        return adt::make_range(edges_.begin() + offsets_[id], edges_.begin() + offsets_[id + 1]);
+    }
+
+    size_t weight(size_t id) const {
+        return weights_[id];
+    }
+
+    // Renames the edges in place. As before, if some paths become equal, only
+    // the first of them (in the old order) is kept together with its weight.
+    void ReplaceEdges(const std::map<EdgeId, EdgeId> &old_to_new) {
+        if (old_to_new.empty())
+            return;
+
+        std::vector<size_t> order = SortedIds();
+        for (EdgeId &e : edges_) {
+            auto it = old_to_new.find(e);
+            if (it != old_to_new.end())
+                e = it->second;
+        }
 
+        paths_.clear();
+        std::vector<bool> kept(size(), false);
+        size_t removed = 0;
+        for (size_t id : order) {
+            kept[id] = paths_.insert(id).second;
+            removed += !kept[id];
         }
+        if (!removed)
+            return;
+
+        DEBUG("Removing " << removed << " paths duplicated after the edges replacement");
+        size_t new_id = 0, pos = 0;
+        for (size_t id = 0; id < kept.size(); ++id) {
+            if (!kept[id])
+                continue;
+            size_t start = offsets_[id], end = offsets_[id + 1];
+            std::copy(edges_.begin() + start, edges_.begin() + end, edges_.begin() + pos);
+            pos += end - start;
+            weights_[new_id] = weights_[id];
+            offsets_[++new_id] = pos;
+        }
+        edges_.resize(pos);
+        offsets_.resize(new_id + 1);
+        weights_.resize(new_id);
 
-        inner_index_ = new_index;
+        paths_.clear();
+        for (size_t id = 0; id < size(); ++id)
+            paths_.insert(id);
     }
 
     void AddPath(const std::vector<EdgeId> &p, int w, bool add_rc = false) {
@@ -164,30 +238,34 @@ public:
 
     void BinWrite(std::ostream &str) const {
         using io::binary::BinWrite;
-        BinWrite(str, inner_index_.size());
-        for (const auto &i : inner_index_) {
-            BinWrite(str, (size_t)i.second.size());
-            for (const auto &j : i.second) {
-                BinWrite(str, j.weight());
-                BinWrite(str, j.path().size());
-                for (const auto &p : j.path()) {
-                    BinWrite(str, g_.int_id(p));
+        std::vector<size_t> sorted_ids = SortedIds();
+        size_t groups = 0;
+        ForEachGroup(sorted_ids, [&](EdgeId, const auto &) { groups += 1; });
+        BinWrite(str, groups);
+        ForEachGroup(sorted_ids, [&](EdgeId, const auto &ids) {
+            BinWrite(str, (size_t)std::distance(ids.begin(), ids.end()));
+            for (size_t id : ids) {
+                BinWrite(str, weight(id));
+                BinWrite(str, (size_t)(offsets_[id + 1] - offsets_[id]));
+                for (EdgeId e : path(id)) {
+                    BinWrite(str, g_.int_id(e));
                 }
             }
-        }
+        });
     }
 
     void BinRead(std::istream &str) {
-        inner_index_.clear();
+        Clear();
         using io::binary::BinRead;
 
         auto size = BinRead<size_t>(str);
+        std::vector<EdgeId> path;
         while (size--) {
             auto count = BinRead<size_t>(str);
             while (count--) {
                 auto weight = BinRead<size_t>(str);
                 auto length = BinRead<size_t>(str);
-                std::vector<EdgeId> path;
+                path.clear();
                 path.reserve(length);
                 while (length--) {
                     auto eid = BinRead<uint64_t>(str);
@@ -203,17 +281,18 @@ public:
         std::ofstream filestr(filename);
         std::set<EdgeId> continued_edges;
 
-        for(auto iter = inner_index_.begin(); iter != inner_index_.end(); ++iter){
-            filestr << iter->second.size() << std::endl;
+        ForEachGroup(SortedIds(), [&](EdgeId, const auto &ids) {
+            filestr << std::distance(ids.begin(), ids.end()) << std::endl;
             int non1 = 0;
-            for (auto j_iter = iter->second.begin(); j_iter != iter->second.end(); ++j_iter) {
-                filestr << " Weight: " << j_iter->weight();
-                if (j_iter->weight() > stats_weight_cutoff)
+            for (size_t id : ids) {
+                filestr << " Weight: " << weight(id);
+                if (weight(id) > stats_weight_cutoff)
                     non1++;
 
-                filestr << " length: " << j_iter->path().size() << " ";
-                for (auto p_iter = j_iter->path().begin(); p_iter != j_iter->path().end(); ++p_iter) {
-                    if (p_iter != j_iter->path().end() - 1 && j_iter->weight() > stats_weight_cutoff) {
+                auto p = path(id);
+                filestr << " length: " << std::distance(p.begin(), p.end()) << " ";
+                for (auto p_iter = p.begin(); p_iter != p.end(); ++p_iter) {
+                    if (p_iter != p.end() - 1 && weight(id) > stats_weight_cutoff) {
                         continued_edges.insert(*p_iter);
                     }
 
@@ -222,7 +301,7 @@ public:
                 filestr << std::endl;
             }
             filestr << std::endl;
-        }
+        });
 
         int noncontinued = 0;
         int long_gapped = 0;
@@ -257,10 +336,10 @@ public:
     }
 
     void SaveAllPaths(std::vector<PathInfo<Graph>> &res) const {
-        for (auto iter = inner_index_.begin(); iter != inner_index_.end(); ++iter) {
-            for (auto j_iter = iter->second.begin(); j_iter != iter->second.end(); ++j_iter) {
-                res.push_back(*j_iter);
-            }
+        res.reserve(res.size() + size());
+        for (size_t id : SortedIds()) {
+            auto p = path(id);
+            res.emplace_back(std::vector<EdgeId>(p.begin(), p.end()), weight(id));
         }
     }
 
@@ -316,35 +395,23 @@ public:
         INFO("Loading finished.");
     }
 
-    void AddStorage(PathStorage<Graph> &to_add) {
-        for (auto iter = to_add.inner_index_.begin(); iter != to_add.inner_index_.end(); iter++) {
-            for(auto j_iter = iter->second.begin(); j_iter != iter->second.end(); j_iter ++) {
-                this->AddPath(j_iter->path(), (int) j_iter->weight());
-            }
+    void AddStorage(const PathStorage<Graph> &to_add) {
+        std::vector<EdgeId> p;
+        for (size_t id = 0; id < to_add.size(); ++id) {
+            auto to_add_path = to_add.path(id);
+            p.assign(to_add_path.begin(), to_add_path.end());
+            HiddenAddPath(p, to_add.weight(id));
         }
     }
 
     void Clear() {
-        inner_index_.clear();
-        size_ = 0;
+        edges_.clear();
+        offsets_.assign(1, 0);
+        weights_.clear();
+        paths_.clear();
     }
 
-    size_t size() const {
-        return size_;
-    }
-
-//    typename InnerIndex::iterator begin() const {
-//        return inner_index.begin();
-//    }
-//
-//    typename InnerIndex::iterator end() const {
-//        return inner_index.end();
-//    }
-//    typename InnerIndex::iterator operator*(){
-//        return this->first;
-//    }
-private:
-    size_t size_;
+    DECL_LOGGER("PathStorage");
 };
 
 template<class Graph>
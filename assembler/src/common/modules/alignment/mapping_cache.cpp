@@ -0,0 +1,136 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "mapping_cache.hpp"
+
+#include "io/binary/binary.hpp"
+
+namespace debruijn_graph {
+
+MappingCache::PathStream::PathStream(const std::string &file, bool replay)
+        : replay_(replay),
+          stream_(new std::fstream(file, std::ios::binary | (replay ? std::ios::in : std::ios::out | std::ios::trunc))) {
+    CHECK_FATAL_ERROR(stream_->good(), "Cannot open mapping cache file " << file);
+}
+
+// Edge ids are stored as the difference with the previous edge of the path,
+// the ranges as offsets from the end of the previous range and lengths
+omnigraph::MappingPath<EdgeId> MappingCache::PathStream::Read() {
+    VERIFY(replay_);
+    using io::binary::BinRead;
+
+    size_t size;
+    BinRead(*stream_, size);
+    std::vector<EdgeId> edges;
+    std::vector<omnigraph::MappingRange> ranges;
+    edges.reserve(size);
+    ranges.reserve(size);
+
+    uint64_t prev_id = 0;
+    size_t prev_end = 0;
+    for (size_t i = 0; i < size; ++i) {
+        int64_t id_diff, start_diff;
+        size_t initial_len, mapped_start, mapped_len;
+        BinRead(*stream_, id_diff, start_diff, initial_len, mapped_start, mapped_len);
+
+        prev_id += id_diff;
+        size_t initial_start = prev_end + start_diff;
+        prev_end = initial_start + initial_len;
+        edges.emplace_back(prev_id);
+        ranges.emplace_back(Range(initial_start, prev_end),
+                            Range(mapped_start, mapped_start + mapped_len));
+    }
+    VERIFY_MSG(!stream_->fail(), "Mapping cache is truncated");
+
+    return omnigraph::MappingPath<EdgeId>(edges, ranges);
+}
+
+void MappingCache::PathStream::Write(const omnigraph::MappingPath<EdgeId> &path) {
+    VERIFY(!replay_);
+    using io::binary::BinWrite;
+
+    BinWrite(*stream_, path.size());
+    uint64_t prev_id = 0;
+    size_t prev_end = 0;
+    for (size_t i = 0; i < path.size(); ++i) {
+        uint64_t id = path.edge_at(i).int_id();
+        omnigraph::MappingRange range = path.mapping_at(i);
+        BinWrite(*stream_,
+                 int64_t(id - prev_id),
+                 int64_t(range.initial_range.start_pos - prev_end),
+                 range.initial_range.size(),
+                 range.mapped_range.start_pos,
+                 range.mapped_range.size());
+        prev_id = id;
+        prev_end = range.initial_range.end_pos;
+    }
+}
+
+MappingCache::MappingCache(const Graph &g, const std::string &workdir)
+        : base(g, "MappingCache"), workdir_(workdir), outdated_(false) {}
+
+void MappingCache::DropOutdated() {
+    if (!outdated_)
+        return;
+
+    if (!entries_.empty())
+        INFO("Graph was modified, dropping " << entries_.size() << " cached read mappings");
+    entries_.clear();
+    outdated_ = false;
+}
+
+bool MappingCache::ready(const std::string &key, size_t streams) {
+    // Detached cache does not see the graph modifications
+    if (!this->IsAttached()) {
+        Invalidate();
+        return false;
+    }
+
+    DropOutdated();
+    auto it = entries_.find(key);
+    return it != entries_.end() && it->second.complete && it->second.files.size() == streams;
+}
+
+std::vector<MappingCache::PathStream> MappingCache::Open(const std::string &key, size_t streams) {
+    std::vector<PathStream> res;
+    if (ready(key, streams)) {
+        INFO("Using cached read mappings for " << key);
+        const Entry &entry = entries_.at(key);
+        for (const auto &file : entry.files)
+            res.emplace_back(file->file(), /*replay*/true);
+        return res;
+    }
+
+    if (!tmp_dir_)
+        tmp_dir_ = fs::tmp::make_temp_dir(workdir_, "mapping_cache");
+
+    Entry &entry = entries_[key];
+    entry.complete = false;
+    entry.files.clear();
+    entry.prefix = tmp_dir_->tmp_file("paths");
+    for (size_t i = 0; i < streams; ++i) {
+        entry.files.push_back(entry.prefix->CreateDep(std::to_string(i)));
+        res.emplace_back(entry.files.back()->file(), /*replay*/false);
+    }
+
+    return res;
+}
+
+void MappingCache::Commit(const std::string &key) {
+    DropOutdated();
+    auto it = entries_.find(key);
+    if (it != entries_.end())
+        it->second.complete = true;
+}
+
+void MappingCache::Clear() {
+    if (!entries_.empty())
+        INFO("Dropping " << entries_.size() << " cached read mappings");
+    entries_.clear();
+    outdated_ = false;
+}
+
+}
@@ -0,0 +1,98 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "assembly_graph/core/action_handlers.hpp"
+#include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/paths/mapping_path.hpp"
+#include "utils/filesystem/temporary.hpp"
+
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace debruijn_graph {
+
+/**
+ * On-disk storage of the read mapping results. Libraries are mapped through
+ * SequenceMapperNotifier several times (insert size estimation, paired info
+ * filtering, paired info counting); the first pass records the MappingPaths
+ * of every read stream and the subsequent passes over the same graph replay
+ * them instead of mapping the reads again.
+ *
+ * Paths are stored per read stream as the sequence of edge ids and ranges,
+ * delta-encoded with LEB128 (mapping quality is not stored, the short read
+ * mappers do not set it). Entries are keyed by a caller-provided string,
+ * the caller is responsible for the same key always denoting the same reads
+ * mapped by the same mapper. Any modification of the graph drops everything.
+ */
+class MappingCache : public omnigraph::GraphActionHandler<Graph> {
+    typedef omnigraph::GraphActionHandler<Graph> base;
+
+    struct Entry {
+        fs::TmpFile prefix;
+        std::vector<fs::DependentTmpFile> files;
+        bool complete = false;
+    };
+
+public:
+    class PathStream {
+    public:
+        PathStream(const std::string &file, bool replay);
+
+        bool replay() const { return replay_; }
+
+        omnigraph::MappingPath<EdgeId> Read();
+        void Write(const omnigraph::MappingPath<EdgeId> &path);
+
+    private:
+        bool replay_;
+        std::unique_ptr<std::fstream> stream_;
+    };
+
+    MappingCache(const Graph &g, const std::string &workdir);
+
+    bool ready(const std::string &key, size_t streams);
+
+    /**
+     * Opens the path streams for the reads streams of the library. If the
+     * entry is ready, the streams replay the stored paths, otherwise they
+     * record new ones. The entry becomes ready after Commit().
+     */
+    std::vector<PathStream> Open(const std::string &key, size_t streams);
+    void Commit(const std::string &key);
+
+    // Drops all the entries, e.g. once their last consumer is done
+    void Clear();
+
+    // Graph modifications might come from several threads, so they only
+    // mark the cache as outdated and the entries are dropped lazily
+    void Invalidate() { outdated_ = true; }
+
+    bool IsThreadSafe() const override { return true; }
+
+    void HandleAdd(EdgeId) override { Invalidate(); }
+    void HandleDelete(EdgeId) override { Invalidate(); }
+    void HandleMerge(const std::vector<EdgeId> &, EdgeId) override { Invalidate(); }
+    void HandleGlue(EdgeId, EdgeId, EdgeId) override { Invalidate(); }
+    void HandleSplit(EdgeId, EdgeId, EdgeId) override { Invalidate(); }
+
+private:
+    void DropOutdated();
+
+    std::string workdir_;
+    fs::TmpDir tmp_dir_;
+    std::unordered_map<std::string, Entry> entries_;
+    std::atomic<bool> outdated_;
+
+    DECL_LOGGER("MappingCache");
+};
+
+}
@@ -31,26 +31,73 @@ bool DijkstraGraphSequenceBase::IsBetter(int seq_ind, int ed) {
 }
 
 void DijkstraGraphSequenceBase::Update(const QueueState &state, const QueueState &prev_state, int score) {
-    if (visited_.count(state) > 0) {
-        if (visited_[state] >= score) {
+    auto it = states_.find(state);
+    if (it != states_.end()) {
+        StateInfo &info = it->second;
+        if (info.score >= score) {
             ++ updates_;
-            q_.erase(make_pair(visited_[state], state));
             if (IsBetter(state.i, score)) {
-                q_.insert(make_pair(score, state));
-                visited_[state] = score;
-                prev_states_[state] = prev_state;
+                // The entry already in the queue is still valid for the same score
+                if (!info.queued || info.score != score)
+                    Push(state, score);
+                if (!info.queued)
+                    ++ queued_;
+                info.score = score;
+                info.queued = true;
+                info.prev = prev_state;
+            } else if (info.queued) {
+                info.queued = false;
+                -- queued_;
             }
         }
     } else {
         if (IsBetter(state.i, score)) {
             ++ updates_;
-            visited_.insert(make_pair(state, score));
-            prev_states_.insert(make_pair(state, prev_state));
-            q_.insert(make_pair(score, state));
+            StateInfo &info = states_[state];
+            info.score = score;
+            info.queued = true;
+            info.prev = prev_state;
+            ++ queued_;
+            Push(state, score);
         }
     }
 }
 
+static bool StateGreater(const QueueState &a, const QueueState &b) {
+    return b < a;
+}
+
+void DijkstraGraphSequenceBase::Push(const QueueState &state, int score) {
+    VERIFY(score >= 0);
+    size_t bucket = (size_t) score;
+    if (bucket >= buckets_.size())
+        buckets_.resize(bucket + 1);
+    buckets_[bucket].push_back(state);
+    push_heap(buckets_[bucket].begin(), buckets_[bucket].end(), StateGreater);
+    min_bucket_ = min(min_bucket_, bucket);
+}
+
+bool DijkstraGraphSequenceBase::Pop(QueueState &state, int &score) {
+    while (queued_ > 0) {
+        while (buckets_[min_bucket_].empty())
+            ++ min_bucket_;
+        auto &bucket = buckets_[min_bucket_];
+        pop_heap(bucket.begin(), bucket.end(), StateGreater);
+        QueueState top = bucket.back();
+        bucket.pop_back();
+
+        StateInfo &info = states_.find(top)->second;
+        if (!info.queued || info.score != (int) min_bucket_)
+            continue;
+        info.queued = false;
+        -- queued_;
+        state = top;
+        score = info.score;
+        return true;
+    }
+    return false;
+}
+
 void DijkstraGraphSequenceBase::AddNewEdge(const GraphState &gs, const QueueState &prev_state, int ed) {
     string edge_str = g_.EdgeNucls(gs.e).Subseq(gs.start_pos, gs.end_pos).str();
     if (0 == edge_str.size()) {
@@ -92,7 +139,7 @@ void DijkstraGraphSequenceBase::AddNewEdge(const GraphState &gs, const QueueStat
 }
 
 bool DijkstraGraphSequenceBase::QueueLimitsExceeded(size_t iter) {
-    return_code_.queue_limit = q_.size() > queue_limit_;
+    return_code_.queue_limit = queued_ > queue_limit_;
     return_code_.iter_limit = iter > iter_limit_;
     return return_code_.status;
 }
@@ -102,15 +149,13 @@ bool DijkstraGraphSequenceBase::RunDijkstra() {
     size_t iter = 0;
     QueueState cur_state;
     int ed = 0;
-    while (q_.size() > 0 &&
+    while (queued_ > 0 &&
             !QueueLimitsExceeded(iter) &&
             ed <= path_max_length_ &&
             updates_ < gap_cfg_.updates_limit) {
-        cur_state = q_.begin()->second;
-        ed = visited_[cur_state];
+        Pop(cur_state, ed);
         ++ iter;
-        q_.erase(q_.begin());
-        if (visited_.count(end_qstate_) > 0) {
+        if (states_.count(end_qstate_) > 0) {
             found_path = true;
         }
         if (IsEndPosition(cur_state)) {
@@ -136,13 +181,14 @@ void DijkstraGraphSequenceBase::CloseGap() {
     if (found_path) {
         QueueState state(end_qstate_);
         while (!state.empty()) {
-            min_score_ = visited_[end_qstate_];
-            int start_edge = prev_states_[state].i;
+            min_score_ = states_[end_qstate_].score;
+            QueueState prev_state = states_[state].prev;
+            int start_edge = prev_state.i;
             int end_edge =  state.i;
             mapping_path_.push_back(state.gs.e,
                                     omnigraph::MappingRange(Range(start_edge, end_edge),
                                             Range(state.gs.start_pos, state.gs.end_pos) ));
-            state = prev_states_[state];
+            state = prev_state;
         }
         mapping_path_.reverse();
     }
@@ -12,6 +12,10 @@
 #include "sequence/sequence_tools.hpp"
 #include "utils/perf/perfcounter.hpp"
 
+#include <parallel_hashmap/phmap.h>
+
+#include <vector>
+
 namespace sensitive_aligner {
 
 using debruijn_graph::EdgeId;
@@ -158,7 +162,10 @@ class DijkstraGraphSequenceBase {
         , min_score_(std::numeric_limits<int>::max())
         , queue_limit_(gap_cfg_.queue_limit)
         , iter_limit_(gap_cfg_.iteration_limit)
-        , updates_(0) {
+        , updates_(0)
+        , buckets_(std::max(path_max_length_, 0) + 1)
+        , min_bucket_(0)
+        , queued_(0) {
         best_ed_.resize(ss_.size(), path_max_length_);
         AddNewEdge(GraphState(start_e_, start_p_, (int) g_.length(start_e_)), QueueState(), 0);
     }
@@ -205,6 +212,10 @@ class DijkstraGraphSequenceBase {
 
     void Update(const QueueState &state, const QueueState &prev_state, int score);
 
+    void Push(const QueueState &state, int score);
+
+    bool Pop(QueueState &state, int &score);
+
     void AddNewEdge(const GraphState &gs, const QueueState &prev_state, int ed);
 
     bool QueueLimitsExceeded(size_t iter);
@@ -234,14 +245,27 @@ class DijkstraGraphSequenceBase {
     static const int SHORT_SEQ_LENGTH = 100;
     static const int ED_DEVIATION = 20;
 
-    std::set<std::pair<int, QueueState>> q_;
-    std::unordered_map<QueueState, int> visited_;
-    std::unordered_map<QueueState, QueueState> prev_states_;
     std::vector<int> best_ed_;
 
     const size_t queue_limit_;
     const size_t iter_limit_;
     size_t updates_;
+
+    struct StateInfo {
+        int score = 0;
+        bool queued = false;
+        QueueState prev;
+    };
+
+    // Scores are edit distances bounded by path_max_length_, so the queue is
+    // a vector of buckets indexed by score. Every bucket is a heap popping
+    // states in QueueState order, the same order an ordered set of
+    // (score, state) pairs would give. Entries are never removed from the
+    // buckets on update, the ones not matching the state info are skipped.
+    std::vector<std::vector<QueueState>> buckets_;
+    size_t min_bucket_;
+    size_t queued_;
+    phmap::flat_hash_map<QueueState, StateInfo, std::hash<QueueState>> states_;
 };
 
 
@@ -11,14 +11,18 @@ namespace debruijn_graph {
 std::shared_ptr<BasicSequenceMapper<Graph, EdgeIndex<Graph>>> MapperInstance(const GraphPack &gp) {
     return std::make_shared<BasicSequenceMapper<Graph, EdgeIndex<Graph>>>(gp.get<Graph>(),
                                                                           gp.get<EdgeIndex<Graph>>(),
-                                                                          gp.get<KmerMapper<Graph>>());
+                                                                          gp.get<KmerMapper<Graph>>(),
+                                                                          /*optimization_on*/ true,
+                                                                          /*batched_lookup*/ true);
 }
 
 std::shared_ptr<BasicSequenceMapper<Graph, EdgeIndex<Graph>>> MapperInstance(const GraphPack &gp,
                                                                              const EdgeIndex<Graph> &index) {
     return std::make_shared<BasicSequenceMapper<Graph, EdgeIndex<Graph>>>(gp.get<Graph>(),
                                                                           index,
-                                                                          gp.get<KmerMapper<Graph>>());
+                                                                          gp.get<KmerMapper<Graph>>(),
+                                                                          /*optimization_on*/ true,
+                                                                          /*batched_lookup*/ true);
 }
 }
 
@@ -12,6 +12,7 @@
 #include "assembly_graph/paths/path_processor.hpp"
 #include "io/reads/single_read.hpp"
 
+#include "sequence/canonical_kmer_roller.hpp"
 #include "sequence/sequence_tools.hpp"
 #include "pipeline/graph_pack.hpp"
 
@@ -298,10 +299,79 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
   const KmerSubs& kmer_mapper_;
   size_t k_;
   bool optimization_on_;
+  bool batched_lookup_;
 
-  bool FindKmer(const Kmer &kmer, size_t kmer_pos, std::vector<EdgeId> &passed,
+  typedef std::pair<EdgeId, size_t> KmerPosition;
+  typedef CanonicalKMerRoller<Kmer> KmerRoller;
+
+  KmerRoller Substitute(const KmerRoller &kmer) const {
+      Kmer subs = kmer_mapper_.Substitute(kmer.forward());
+      if (subs == kmer.forward())
+          return kmer;
+      return KmerRoller(subs);
+  }
+
+  // Looks up k-mers in the index one by one
+  class SingleLookup {
+    const BasicSequenceMapper &mapper_;
+
+  public:
+    SingleLookup(const BasicSequenceMapper &mapper, const Sequence &)
+        : mapper_(mapper) {}
+
+    KmerPosition operator()(const KmerRoller &kmer, size_t, bool substitute) {
+        if (substitute)
+            return mapper_.index_.get(mapper_.Substitute(kmer));
+        return mapper_.index_.get(kmer);
+    }
+  };
+
+  // Looks up the window of the consequent k-mers at once, so the cache misses
+  // in the index overlap. A single k-mer is queried first after the found
+  // one: the mapper usually proceeds threading along the edge and the window
+  // would be wasted. Once the k-mer is missing, the following ones are likely
+  // to miss as well, so the full window is requested.
+  class BatchedLookup {
+    static constexpr size_t BATCH = 16;
+
+    const BasicSequenceMapper &mapper_;
+    const Sequence &sequence_;
+    size_t start_ = 0, end_ = 0;
+    KmerRoller kmers_[BATCH];
+    KmerPosition positions_[BATCH];
+
+    void Fill(const KmerRoller &kmer, size_t kmer_pos) {
+        bool missing = (kmer_pos == end_ && end_ > start_ &&
+                        positions_[end_ - start_ - 1].second == Index::NOT_FOUND);
+        size_t cnt = std::min(missing ? BATCH : 1,
+                              sequence_.size() - mapper_.k_ + 1 - kmer_pos);
+        KmerRoller cur = kmer;
+        kmers_[0] = mapper_.Substitute(cur);
+        for (size_t i = 1; i < cnt; ++i) {
+            cur <<= sequence_[kmer_pos + mapper_.k_ - 1 + i];
+            kmers_[i] = mapper_.Substitute(cur);
+        }
+        mapper_.index_.get(kmers_, cnt, positions_);
+        start_ = kmer_pos;
+        end_ = kmer_pos + cnt;
+    }
+
+  public:
+    BatchedLookup(const BasicSequenceMapper &mapper, const Sequence &sequence)
+        : mapper_(mapper), sequence_(sequence) {}
+
+    // Substitution of non-substitutable k-mer is identity, so the window is
+    // always filled with substituted k-mers
+    KmerPosition operator()(const KmerRoller &kmer, size_t kmer_pos, bool) {
+        if (kmer_pos < start_ || kmer_pos >= end_)
+            Fill(kmer, kmer_pos);
+
+        return positions_[kmer_pos - start_];
+    }
+  };
+
+  bool FindKmer(const KmerPosition &position, size_t kmer_pos, std::vector<EdgeId> &passed,
                 RangeMappings& range_mappings) const {
-    const auto& position = index_.get(kmer);
     if (position.second == Index::NOT_FOUND)
         return false;
     
@@ -351,56 +421,71 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
     return false;
   }
 
-  bool ProcessKmer(const Kmer &kmer, size_t kmer_pos, std::vector<EdgeId> &passed_edges,
-                   RangeMappings& range_mapping, bool try_thread) const {
+  template<class Lookup>
+  bool ProcessKmer(const KmerRoller &kmer, size_t kmer_pos, std::vector<EdgeId> &passed_edges,
+                   RangeMappings& range_mapping, bool try_thread, Lookup &lookup) const {
     if (try_thread) {
-        if (!TryThread(kmer, kmer_pos, passed_edges, range_mapping)) {
-            FindKmer(kmer_mapper_.Substitute(kmer), kmer_pos, passed_edges, range_mapping);
+        if (!TryThread(kmer.forward(), kmer_pos, passed_edges, range_mapping)) {
+            FindKmer(lookup(kmer, kmer_pos, true), kmer_pos, passed_edges, range_mapping);
             return false;
         }
 
         return true;
     }
 
-    if (kmer_mapper_.CanSubstitute(kmer)) {
-        FindKmer(kmer_mapper_.Substitute(kmer), kmer_pos, passed_edges, range_mapping);
+    if (kmer_mapper_.CanSubstitute(kmer.forward())) {
+        FindKmer(lookup(kmer, kmer_pos, true), kmer_pos, passed_edges, range_mapping);
         return false;
     }
 
-    return FindKmer(kmer, kmer_pos, passed_edges, range_mapping);
+    return FindKmer(lookup(kmer, kmer_pos, false), kmer_pos, passed_edges, range_mapping);
+  }
+
+  template<class Lookup>
+  MappingPath<EdgeId> DoMapSequence(const Sequence &sequence,
+                                    bool only_simple, Lookup &lookup) const {
+    std::vector<EdgeId> passed_edges;
+    RangeMappings range_mapping;
+
+    KmerRoller kmer(sequence.start<Kmer>(k_));
+    bool try_thread = false;
+    try_thread = ProcessKmer(kmer, 0, passed_edges,
+                             range_mapping, try_thread, lookup);
+    for (size_t i = k_; i < sequence.size(); ++i) {
+      kmer <<= sequence[i];
+      try_thread = ProcessKmer(kmer, i - k_ + 1, passed_edges,
+                               range_mapping, try_thread, lookup);
+      if (only_simple && passed_edges.size() > 1)
+        return MappingPath<EdgeId>();
+    }
+
+    return MappingPath<EdgeId>(passed_edges, range_mapping);
   }
 
  public:
   BasicSequenceMapper(const Graph& g,
                       const Index& index,
                       const KmerSubs& kmer_mapper,
-                      bool optimization_on = true) :
+                      bool optimization_on = true,
+                      bool batched_lookup = false) :
       AbstractSequenceMapper<Graph>(g), index_(index),
       kmer_mapper_(kmer_mapper), k_(g.k()+1),
-      optimization_on_(optimization_on) { }
+      optimization_on_(optimization_on),
+      batched_lookup_(batched_lookup) { }
 
   MappingPath<EdgeId> MapSequence(const Sequence &sequence,
                                   bool only_simple = false) const {
-    std::vector<EdgeId> passed_edges;
-    RangeMappings range_mapping;
-    
     if (sequence.size() < k_) {
       return MappingPath<EdgeId>();
     }
 
-    Kmer kmer = sequence.start<Kmer>(k_);
-    bool try_thread = false;
-    try_thread = ProcessKmer(kmer, 0, passed_edges,
-                             range_mapping, try_thread);
-    for (size_t i = k_; i < sequence.size(); ++i) {
-      kmer <<= sequence[i];
-      try_thread = ProcessKmer(kmer, i - k_ + 1, passed_edges,
-                               range_mapping, try_thread);
-      if (only_simple && passed_edges.size() > 1)
-        return MappingPath<EdgeId>();
+    if (batched_lookup_) {
+      BatchedLookup lookup(*this, sequence);
+      return DoMapSequence(sequence, only_simple, lookup);
     }
 
-    return MappingPath<EdgeId>(passed_edges, range_mapping);
+    SingleLookup lookup(*this, sequence);
+    return DoMapSequence(sequence, only_simple, lookup);
   }
 
   DECL_LOGGER("BasicSequenceMapper");
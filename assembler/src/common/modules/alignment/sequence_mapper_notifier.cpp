@@ -12,6 +12,31 @@
 
 namespace debruijn_graph {
 
+namespace {
+
+MappingPath<EdgeId> MapRead(const io::SingleReadSeq &r, const SequenceMapper<Graph> &mapper) {
+    return mapper.MapSequence(r.sequence());
+}
+
+MappingPath<EdgeId> MapRead(const io::SingleRead &r, const SequenceMapper<Graph> &mapper) {
+    return mapper.MapRead(r);
+}
+
+template<class ReadType>
+MappingPath<EdgeId> MapRead(const ReadType &r, const SequenceMapper<Graph> &mapper,
+                            MappingCache::PathStream *paths) {
+    if (paths && paths->replay())
+        return paths->Read();
+
+    MappingPath<EdgeId> path = MapRead(r, mapper);
+    if (paths)
+        paths->Write(path);
+
+    return path;
+}
+
+}
+
 SequenceMapperNotifier::SequenceMapperNotifier(const GraphPack& gp, size_t lib_count)
     : gp_(gp)
     , listeners_(lib_count) 
@@ -43,12 +68,11 @@ template<>
 void SequenceMapperNotifier::NotifyProcessRead(const io::PairedReadSeq& r,
                                                const SequenceMapperT& mapper,
                                                size_t ilib,
-                                               size_t ithread) const
+                                               size_t ithread,
+                                               MappingCache::PathStream *paths) const
 {
-    const Sequence& read1 = r.first().sequence();
-    const Sequence& read2 = r.second().sequence();
-    MappingPath<EdgeId> path1 = mapper.MapSequence(read1);
-    MappingPath<EdgeId> path2 = mapper.MapSequence(read2);
+    MappingPath<EdgeId> path1 = MapRead(r.first(), mapper, paths);
+    MappingPath<EdgeId> path2 = MapRead(r.second(), mapper, paths);
     for (const auto& listener : listeners_[ilib]) {
         listener->ProcessPairedRead(ithread, r, path1, path2);
         listener->ProcessSingleRead(ithread, r.first(), path1);
@@ -60,10 +84,11 @@ template<>
 void SequenceMapperNotifier::NotifyProcessRead(const io::PairedRead& r,
                                                const SequenceMapperT& mapper,
                                                size_t ilib,
-                                               size_t ithread) const
+                                               size_t ithread,
+                                               MappingCache::PathStream *paths) const
 {
-    MappingPath<EdgeId> path1 = mapper.MapRead(r.first());
-    MappingPath<EdgeId> path2 = mapper.MapRead(r.second());
+    MappingPath<EdgeId> path1 = MapRead(r.first(), mapper, paths);
+    MappingPath<EdgeId> path2 = MapRead(r.second(), mapper, paths);
     for (const auto& listener : listeners_[ilib]) {
         listener->ProcessPairedRead(ithread, r, path1, path2);
         listener->ProcessSingleRead(ithread, r.first(), path1);
@@ -75,10 +100,10 @@ template<>
 void SequenceMapperNotifier::NotifyProcessRead(const io::SingleReadSeq& r,
                                                const SequenceMapperT& mapper,
                                                size_t ilib,
-                                               size_t ithread) const
+                                               size_t ithread,
+                                               MappingCache::PathStream *paths) const
 {
-    const Sequence& read = r.sequence();
-    MappingPath<EdgeId> path = mapper.MapSequence(read);
+    MappingPath<EdgeId> path = MapRead(r, mapper, paths);
     for (const auto& listener : listeners_[ilib])
         listener->ProcessSingleRead(ithread, r, path);
 }
@@ -87,9 +112,10 @@ template<>
 void SequenceMapperNotifier::NotifyProcessRead(const io::SingleRead& r,
                                                const SequenceMapperT& mapper,
                                                size_t ilib,
-                                               size_t ithread) const
+                                               size_t ithread,
+                                               MappingCache::PathStream *paths) const
 {
-    MappingPath<EdgeId> path = mapper.MapRead(r);
+    MappingPath<EdgeId> path = MapRead(r, mapper, paths);
     for (const auto& listener : listeners_[ilib])
         listener->ProcessSingleRead(ithread, r, path);
 }
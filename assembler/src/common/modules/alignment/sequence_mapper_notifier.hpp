@@ -9,6 +9,7 @@
 #define SEQUENCE_MAPPER_NOTIFIER_HPP_
 
 #include "sequence_mapper.hpp"
+#include "mapping_cache.hpp"
 
 #include "assembly_graph/paths/mapping_path.hpp"
 #include "assembly_graph/core/graph.hpp"
@@ -54,6 +55,28 @@ public:
     template<class ReadType>
     void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
                         size_t lib_index, const SequenceMapperT& mapper, size_t threads_count = 0) {
+        ProcessLibrary(streams, lib_index, mapper, threads_count, nullptr);
+    }
+
+    /**
+     * Same as above, but the mapping paths are stored in the cache under the
+     * given key, or, if they were stored by the previous pass, read from
+     * there instead of mapping the reads again.
+     */
+    template<class ReadType>
+    void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
+                        size_t lib_index, const SequenceMapperT& mapper,
+                        MappingCache &cache, const std::string &key, size_t threads_count = 0) {
+        auto paths = cache.Open(key, streams.size());
+        ProcessLibrary(streams, lib_index, mapper, threads_count, &paths);
+        cache.Commit(key);
+    }
+
+private:
+    template<class ReadType>
+    void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
+                        size_t lib_index, const SequenceMapperT& mapper, size_t threads_count,
+                        std::vector<MappingCache::PathStream> *paths) {
         std::string lib_str = std::to_string(lib_index);
         TIME_TRACE_SCOPE("SequenceMapperNotifier::ProcessLibrary", lib_str);
         if (threads_count == 0)
@@ -68,6 +91,7 @@ public:
             size_t size = 0;
             ReadType r;
             auto& stream = streams[i];
+            MappingCache::PathStream *path_stream = paths ? &(*paths)[i] : nullptr;
             while (!stream.eof()) {
                 if (size == BUFFER_SIZE) {
                     #pragma omp critical
@@ -83,7 +107,7 @@ public:
                 }
                 stream >> r;
                 ++size;
-                NotifyProcessRead(r, mapper, lib_index, i);
+                NotifyProcessRead(r, mapper, lib_index, i, path_stream);
             }
             #pragma omp atomic
             counter += size;
@@ -96,10 +120,9 @@ public:
         NotifyStopProcessLibrary(lib_index);
     }
 
-private:
     template<class ReadType>
-    void NotifyProcessRead(const ReadType& r, const SequenceMapperT& mapper, size_t ilib, size_t ithread) const;
-
+    void NotifyProcessRead(const ReadType& r, const SequenceMapperT& mapper, size_t ilib, size_t ithread,
+                           MappingCache::PathStream *paths) const;
     void NotifyStartProcessLibrary(size_t ilib, size_t thread_count) const;
 
     void NotifyStopProcessLibrary(size_t ilib) const;
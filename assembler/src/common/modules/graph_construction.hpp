@@ -50,7 +50,9 @@ KMerFiles ConstructGraphUsingExtensionIndex(const config::debruijn_config::const
     TRACE("... in parallel");
     utils::DeBruijnExtensionIndex<> ext(k);
 
-    KMerFiles kmers = utils::DeBruijnExtensionIndexBuilder().BuildExtensionIndexFromStream(workdir, ext, streams, params.read_buffer_size);
+    KMerFiles kmers = utils::DeBruijnExtensionIndexBuilder().BuildExtensionIndexFromStream(workdir, ext, streams,
+                                                                                            params.read_buffer_size,
+                                                                                            params.in_memory_kmer_counting);
 
     EarlyClipTips(params, ext);
 
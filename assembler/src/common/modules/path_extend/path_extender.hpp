@@ -17,6 +17,8 @@
 #include "assembly_graph/graph_support/scaff_supplementary.hpp"
 
 #include <cmath>
+#include <functional>
+#include <unordered_set>
 
 namespace path_extend {
 
@@ -424,18 +426,38 @@ protected:
 
 
 class CompositeExtender {
+public:
+    typedef std::vector<std::shared_ptr<PathExtender>> Extenders;
+    typedef std::function<Extenders(const GraphCoverageMap&, UsedUniqueStorage&)> ExtendersFactory;
+
 private:
+    struct Speculation;
+    class Worker;
+
     bool MakeGrowStep(BidirectionalPath& path, PathContainer* paths_storage);
     void GrowAllPaths(PathContainer& paths, PathContainer& result);
+    void GrowAllPathsParallel(PathContainer& paths, PathContainer& result);
+    bool GrowSeed(const BidirectionalPath& seed, PathContainer& result);
+    void Commit(const BidirectionalPath& seed, Speculation& speculation,
+                PathContainer& result, std::unordered_set<EdgeId>& written,
+                bool regrow);
 
 public:
     CompositeExtender(const Graph &g, GraphCoverageMap& cov_map,
                       UsedUniqueStorage &unique,
-                      const std::vector<std::shared_ptr<PathExtender>> &pes)
-            : g_(g),
-              cover_map_(cov_map),
-              used_storage_(unique),
-              extenders_(pes) {}
+                      const Extenders &pes);
+
+    ~CompositeExtender();
+
+    /**
+     * Seeds are grown speculatively in the given number of threads, each
+     * using its own set of extenders produced by the factory (over the
+     * overlays of the shared coverage map and used edges storage). The grown
+     * paths are then committed in the seed order; a path is regrown serially
+     * if any edge it has looked at was covered or used by the path committed
+     * before it. So the result does not depend on the thread scheduling.
+     */
+    void UseThreads(size_t threads, ExtendersFactory factory);
 
     void GrowAll(PathContainer& paths, PathContainer& result);
     void GrowPath(BidirectionalPath& path, PathContainer* paths_storage) {
@@ -446,7 +468,10 @@ private:
     const Graph &g_;
     GraphCoverageMap &cover_map_;
     UsedUniqueStorage &used_storage_;
-    std::vector<std::shared_ptr<PathExtender>> extenders_;
+    Extenders extenders_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    DECL_LOGGER("CompositeExtender")
 };
 
 
@@ -9,9 +9,66 @@
 
 namespace path_extend {
 
+// Number of seeds grown by each thread between the commits
+static const size_t SEEDS_PER_THREAD = 16;
+
+// Result of the speculative growth of a single seed
+struct CompositeExtender::Speculation {
+    bool grown = false;
+    // The grown path (first) and the paths created by the extenders
+    PathContainer paths;
+    // Edges looked up in the shared coverage map and used edges storage
+    std::vector<EdgeId> reads;
+    UsedUniqueStorage::InsertionLog used;
+};
+
+// Extenders of a single thread, working over the overlays of the shared
+// coverage map and used edges storage
+class CompositeExtender::Worker {
+public:
+    Worker(const CompositeExtender &main, const ExtendersFactory &factory)
+            : cover_map_(main.cover_map_, nullptr),
+              used_storage_(main.used_storage_, nullptr),
+              extender_(main.g_, cover_map_, used_storage_, factory(cover_map_, used_storage_)) {}
+
+    void Grow(const BidirectionalPath &seed, Speculation &speculation) {
+        cover_map_.ResetOverlay(&speculation.reads);
+        used_storage_.ResetOverlay(&speculation.reads);
+        used_storage_.SetInsertionLog(&speculation.used);
+        speculation.grown = extender_.GrowSeed(seed, speculation.paths);
+    }
+
+private:
+    GraphCoverageMap cover_map_;
+    UsedUniqueStorage used_storage_;
+    CompositeExtender extender_;
+};
+
+CompositeExtender::CompositeExtender(const Graph &g, GraphCoverageMap& cov_map,
+                                     UsedUniqueStorage &unique,
+                                     const Extenders &pes)
+        : g_(g),
+          cover_map_(cov_map),
+          used_storage_(unique),
+          extenders_(pes) {}
+
+CompositeExtender::~CompositeExtender() {}
+
+void CompositeExtender::UseThreads(size_t threads, ExtendersFactory factory) {
+    workers_.clear();
+    if (threads < 2)
+        return;
+
+    for (size_t i = 0; i < threads; ++i)
+        workers_.push_back(std::make_unique<Worker>(*this, factory));
+}
+
 void CompositeExtender::GrowAll(PathContainer& paths, PathContainer& result) {
     result.clear();
-    GrowAllPaths(paths, result);
+    if (workers_.empty())
+        GrowAllPaths(paths, result);
+    else
+        GrowAllPathsParallel(paths, result);
     result.FilterEmptyPaths();
 }
 
@@ -35,44 +92,130 @@ void CompositeExtender::GrowAllPaths(PathContainer& paths, PathContainer& result
         if (paths.size() > 10 && i % (paths.size() / 10 + 1) == 0) {
             INFO("Processed " << i << " paths from " << paths.size() << " (" << i * 100 / paths.size() << "%)");
         }
-        //In 2015 modes do not use a seed already used in paths.
-        //FIXME what is the logic here?
-        if (used_storage_.UniqueCheckEnabled()) {
-            bool was_used = false;
-            const BidirectionalPath &p = paths.Get(i);
-            for (size_t ind =0; ind < p.Size(); ind++) {
-                EdgeId eid = p.At(ind);
-                auto path_id = p.GetId();
-                if (used_storage_.IsUsedAndUnique(eid, path_id)) {
-                    DEBUG("Used edge " << g_.int_id(eid));
-                    was_used = true;
-                    break;
-                } else {
-                    used_storage_.insert(eid, path_id);
-                }
-            }
-            if (was_used) {
-                DEBUG("skipping already used seed");
-                continue;
+        GrowSeed(paths.Get(i), result);
+    }
+}
+
+void CompositeExtender::GrowAllPathsParallel(PathContainer& paths, PathContainer& result) {
+    const size_t threads = workers_.size();
+    const size_t round_size = threads * SEEDS_PER_THREAD;
+    INFO("Growing seeds in " << threads << " threads");
+
+    size_t regrown = 0;
+    for (size_t start = 0; start < paths.size(); start += round_size) {
+        size_t end = std::min(paths.size(), start + round_size);
+        if (paths.size() > 10 && start * 10 / paths.size() != end * 10 / paths.size()) {
+            INFO("Processed " << start << " paths from " << paths.size() << " (" << start * 100 / paths.size() << "%)");
+        }
+
+        // Seeds are assigned to the workers statically, so the state of
+        // their extenders does not depend on the scheduling
+        std::vector<Speculation> speculations(end - start);
+#       pragma omp parallel for num_threads(threads) schedule(static, 1)
+        for (size_t w = 0; w < threads; ++w) {
+            for (size_t i = start + w; i < end; i += threads)
+                workers_[w]->Grow(paths.Get(i), speculations[i - start]);
+        }
+
+        std::unordered_set<EdgeId> written;
+        for (size_t i = start; i < end; ++i) {
+            Speculation &speculation = speculations[i - start];
+            bool conflict = std::any_of(speculation.reads.begin(), speculation.reads.end(),
+                                        [&](EdgeId e) { return written.count(e); });
+            if (conflict) {
+                DEBUG("Regrowing seed " << paths.Get(i).GetId());
+                regrown += 1;
             }
+            Commit(paths.Get(i), speculation, result, written, conflict);
+        }
+    }
+    INFO("Regrown " << regrown << " of " << paths.size() << " seeds due to conflicts");
+}
+
+void CompositeExtender::Commit(const BidirectionalPath& seed, Speculation& speculation,
+                               PathContainer& result, std::unordered_set<EdgeId>& written,
+                               bool regrow) {
+    bool was_empty = (cover_map_.size() == 0);
+    size_t first = result.size();
+
+    UsedUniqueStorage::InsertionLog used;
+    used_storage_.SetInsertionLog(&used);
+    if (regrow) {
+        GrowSeed(seed, result);
+    } else {
+        // Paths get new ids on cloning, the ones of the used edges are remapped
+        std::unordered_map<size_t, size_t> ids;
+        for (size_t i = 0; i < speculation.paths.size(); ++i) {
+            const BidirectionalPath &path = speculation.paths.Get(i);
+            const BidirectionalPath &conj = speculation.paths.GetConjugate(i);
+            auto ppair = result.AddPair(BidirectionalPath::clone(path),
+                                        BidirectionalPath::clone(conj));
+            // As in GrowSeed, only the grown seed is covered, the paths
+            // created by the extenders are just stored
+            if (i == 0 && speculation.grown)
+                cover_map_.Subscribe(ppair);
+            ids[path.GetId()] = ppair.first.GetId();
+            ids[conj.GetId()] = ppair.second.GetId();
+        }
+        for (const auto &entry : speculation.used) {
+            auto id = ids.find(entry.second);
+            used_storage_.insert(entry.first, id == ids.end() ? entry.second : id->second);
         }
+    }
+    used_storage_.SetInsertionLog(nullptr);
 
-        if (!cover_map_.IsCovered(paths.Get(i))) {
-            BidirectionalPath &path = CreatePath(result, cover_map_,
-                                                 paths.Get(i));
-
-            size_t count_trying = 0;
-            size_t current_path_len = 0;
-            do {
-                current_path_len = path.Length();
-                count_trying++;
-                GrowPath(path, &result);
-                GrowPath(*path.GetConjPath(), &result);
-            } while (count_trying < 10 && (path.Length() != current_path_len));
-                DEBUG("result path " << path.GetId());
-                path.PrintDEBUG();
+    for (const auto &entry : used) {
+        written.insert(entry.first);
+        written.insert(g_.conjugate(entry.first));
+    }
+    for (size_t i = first; i < result.size(); ++i) {
+        for (EdgeId e : result.Get(i)) {
+            written.insert(e);
+            written.insert(g_.conjugate(e));
         }
     }
+    if (was_empty && cover_map_.size() != 0)
+        written.insert(EdgeId());
+}
+
+bool CompositeExtender::GrowSeed(const BidirectionalPath& seed, PathContainer& result) {
+    //In 2015 modes do not use a seed already used in paths.
+    //FIXME what is the logic here?
+    if (used_storage_.UniqueCheckEnabled()) {
+        bool was_used = false;
+        for (size_t ind =0; ind < seed.Size(); ind++) {
+            EdgeId eid = seed.At(ind);
+            auto path_id = seed.GetId();
+            if (used_storage_.IsUsedAndUnique(eid, path_id)) {
+                DEBUG("Used edge " << g_.int_id(eid));
+                was_used = true;
+                break;
+            } else {
+                used_storage_.insert(eid, path_id);
+            }
+        }
+        if (was_used) {
+            DEBUG("skipping already used seed");
+            return false;
+        }
+    }
+
+    if (cover_map_.IsCovered(seed))
+        return false;
+
+    BidirectionalPath &path = CreatePath(result, cover_map_, seed);
+
+    size_t count_trying = 0;
+    size_t current_path_len = 0;
+    do {
+        current_path_len = path.Length();
+        count_trying++;
+        GrowPath(path, &result);
+        GrowPath(*path.GetConjPath(), &result);
+    } while (count_trying < 10 && (path.Length() != current_path_len));
+    DEBUG("result path " << path.GetId());
+    path.PrintDEBUG();
+    return true;
 }
 
 bool LoopDetectingPathExtender::TryUseEdge(BidirectionalPath &path, EdgeId e, const Gap &gap) {
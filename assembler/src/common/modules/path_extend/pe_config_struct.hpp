@@ -134,6 +134,9 @@ struct pe_config {
 
         bool use_coordinated_coverage;
 
+        // Grow seeds speculatively in several threads
+        bool parallel_extension;
+
         struct CoordinatedCoverageT {
             size_t max_edge_length_in_repeat;
             double delta;
@@ -31,6 +31,16 @@ private:
     phmap::parallel_flat_hash_map<EdgeId, MapDataT> edge_coverage_;
     const MapDataT empty_;
 
+    // Overlay mode, see the corresponding constructor
+    const GraphCoverageMap *base_ = nullptr;
+    std::vector<EdgeId> *base_reads_ = nullptr;
+
+    const GraphCoverageMap *Base(EdgeId e) const {
+        if (base_reads_)
+            base_reads_->push_back(e);
+        return base_;
+    }
+
     void EdgeAdded(EdgeId e, BidirectionalPath &path) {
         edge_coverage_[e][&path] += 1;
     }
@@ -76,6 +86,19 @@ public:
         AddPaths(paths, subscribe);
     }
 
+    // Overlay over the (read-only) base map: the queries see the paths from
+    // both maps, while the new paths are subscribed to the overlay only.
+    // Edges looked up in the base map are appended to base_reads.
+    GraphCoverageMap(const GraphCoverageMap& base, std::vector<EdgeId> *base_reads) :
+            g_(base.g_), base_(&base), base_reads_(base_reads) {}
+
+    // Drops all the paths of the overlay
+    void ResetOverlay(std::vector<EdgeId> *base_reads) {
+        VERIFY(base_);
+        edge_coverage_.clear();
+        base_reads_ = base_reads;
+    }
+
     ~GraphCoverageMap() {}
 
     void AddPaths(const PathContainer& paths, bool subscribe = false) {
@@ -114,26 +137,34 @@ public:
         EdgeRemoved(e, path);
     }
 
-    const MapDataT &GetEdgePaths(EdgeId e) const {
+    // Returned by value, since in overlay mode the paths are merged with the
+    // ones of the base map
+    MapDataT GetEdgePaths(EdgeId e) const {
         auto iter = edge_coverage_.find(e);
-        if (iter != edge_coverage_.end()) {
-            return iter->second;
-        }
-        return empty_;
+        const MapDataT &paths = (iter != edge_coverage_.end() ? iter->second : empty_);
+        if (!base_)
+            return paths;
+
+        MapDataT res = Base(e)->GetEdgePaths(e);
+        for (const auto &entry : paths)
+            res[entry.first] += entry.second;
+        return res;
     }
 
     size_t Count(EdgeId e, const BidirectionalPath &path) const {
+        size_t base_count = (base_ ? Base(e)->Count(e, path) : 0);
         auto entry = edge_coverage_.find(e);
         if (entry == edge_coverage_.end())
-            return 0;
+            return base_count;
 
         auto cov = entry->second.find(const_cast<BidirectionalPath*>(&path));
-        return (cov == entry->second.end() ? 0 : cov->second);
+        return base_count + (cov == entry->second.end() ? 0 : cov->second);
     }
 
     size_t GetCoverage(EdgeId e) const {
+        size_t base_coverage = (base_ ? Base(e)->GetCoverage(e) : 0);
         auto iter = edge_coverage_.find(e);
-        return (iter != edge_coverage_.end() ? iter->second.size() : 0);
+        return base_coverage + (iter != edge_coverage_.end() ? iter->second.size() : 0);
     }
 
     bool IsCovered(EdgeId e) const {
@@ -150,6 +181,9 @@ public:
 
     BidirectionalPathSet GetCoveringPaths(EdgeId e) const {
         BidirectionalPathSet res;
+        if (base_)
+            res = Base(e)->GetCoveringPaths(e);
+
         auto iter = edge_coverage_.find(e);
         if (iter == edge_coverage_.end())
             return res;
@@ -168,8 +202,9 @@ public:
         return edge_coverage_.end();
     }
 
+    // Reads of the base map size are logged as reads of the empty edge
     size_t size() const {
-        return edge_coverage_.size();
+        return edge_coverage_.size() + (base_ ? Base(EdgeId())->size() : 0);
     }
 
     const Graph& graph() const {
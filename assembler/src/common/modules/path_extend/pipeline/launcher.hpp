@@ -70,13 +70,18 @@ class PathExtendLauncher {
 
     void PolishPaths(const PathContainer &paths, PathContainer &result, const GraphCoverageMap &cover_map) const;
 
-    Extenders ConstructExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage);
+    bool UsePBExtenders() const;
 
-    Extenders ConstructMPExtenders(const ExtendersGenerator &generator);
+    bool UseMPExtenders() const;
 
-    void AddScaffUniqueStorage(size_t uniqe_edge_len);
+    // Fills the long reads coverage maps and the unique edge storages used by the extenders
+    void PrepareExtenders();
+
+    Extenders ConstructExtenders(const GraphCoverageMap &cover_map, UsedUniqueStorage &used_unique_storage) const;
 
-    Extenders ConstructPBExtenders(const ExtendersGenerator &generator);
+    void FillMPUniqueEdgeStorages();
+
+    void AddScaffUniqueStorage(size_t uniqe_edge_len);
 
     void FilterPaths();
 
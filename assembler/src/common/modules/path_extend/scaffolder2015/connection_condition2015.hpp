@@ -6,6 +6,7 @@
 #include "modules/alignment/long_read_storage.hpp"
 #include "utils/logger/logger.hpp"
 #include <map>
+#include <mutex>
 #include <set>
 
 namespace path_extend {
@@ -134,6 +135,7 @@ protected:
     size_t max_connection_length_;
     EdgeSet interesting_edge_set_;
     mutable std::map<EdgeId, Connections> stored_distances_;
+    mutable std::mutex stored_distances_mutex_;
 public:
     AssemblyGraphConnectionCondition(const Graph &g, size_t max_connection_length,
                                      const ScaffoldingUniqueEdgeStorage &unique_edges);
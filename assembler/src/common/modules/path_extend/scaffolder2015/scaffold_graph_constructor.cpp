@@ -4,6 +4,8 @@
 
 #include "scaffold_graph_constructor.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+
 namespace path_extend {
 
 namespace scaffold_graph {
@@ -39,14 +41,27 @@ void BaseScaffoldGraphConstructor::ConstructFromConditions(ConnectionConditions
 
 void BaseScaffoldGraphConstructor::ConstructFromSingleCondition(const std::shared_ptr<ConnectionCondition> condition,
                                                                 bool use_terminal_vertices_only) {
+    // Only the edges added for v itself change the outgoing edges of v,
+    // so the vertices to be connected are known beforehand
+    std::vector<ScaffoldGraph::ScaffoldVertex> vertices;
     for (const auto& v : graph_->vertices()) {
-        TRACE("Vertex " << graph_->int_id(v));
-
         if (use_terminal_vertices_only && graph_->OutgoingEdgeCount(v) > 0)
             continue;
+        vertices.push_back(v);
+    }
+
+    // Conditions are read-only, the connections are found in parallel and
+    // added in the vertex order afterwards
+    std::vector<Connections> connections(vertices.size());
+#   pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < vertices.size(); ++i)
+        connections[i] = condition->ConnectedWith(vertices[i]);
+
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        const auto &v = vertices[i];
+        TRACE("Vertex " << graph_->int_id(v));
 
-        auto connected_with = condition->ConnectedWith(v);
-        for (const auto& pair : connected_with) {
+        for (const auto& pair : connections[i]) {
             EdgeId connected = pair.first;
             double w = pair.second;
             TRACE("Connected with " << graph_->int_id(connected));
@@ -5,6 +5,26 @@ namespace de {
 
 using namespace debruijn_graph;
 
+GraphDistanceFinder::GraphDistanceFinder(const Graph &graph, size_t insert_size, size_t read_length, size_t delta,
+                                         size_t cache_size)
+        : base(graph, "GraphDistanceFinder"),
+          graph_(graph), insert_size_(insert_size), gap_((int) (insert_size - 2 * read_length)),
+          delta_((double) delta),
+          shard_capacity_((cache_size + CACHE_SHARDS - 1) / CACHE_SHARDS),
+          cache_(new CacheShard[CACHE_SHARDS]), cached_(0),
+          processors_(omp_get_max_threads()) {}
+
+void GraphDistanceFinder::Invalidate() {
+    if (!cached_)
+        return;
+
+    for (size_t i = 0; i < CACHE_SHARDS; ++i) {
+        std::lock_guard<std::mutex> guard(cache_[i].lock);
+        cached_ -= cache_[i].lengths.size();
+        cache_[i].lengths.clear();
+    }
+}
+
 std::vector<size_t> GraphDistanceFinder::GetGraphDistancesLengths(EdgeId e1, EdgeId e2) const {
     LengthMap m;
     m.insert({e2, {}});
@@ -14,26 +34,68 @@ std::vector<size_t> GraphDistanceFinder::GetGraphDistancesLengths(EdgeId e1, Edg
     return m[e2];
 }
 
+GraphDistanceFinder::GraphLengths GraphDistanceFinder::PathLengths(const PathProcessorT &paths_proc,
+                                                                   VertexId end, size_t path_upper_bound) const {
+    DistancesLengthsCallback<Graph> callback(graph_);
+    // The lower bound does not affect the traversal itself, only the paths reported
+    paths_proc.Process(end, 0, path_upper_bound, callback);
+    return callback.distances();
+}
+
 void GraphDistanceFinder::FillGraphDistancesLengths(EdgeId e1, LengthMap &second_edges) const {
-    std::vector<size_t> path_lower_bounds;
+    VertexId start = graph_.EdgeEnd(e1);
     size_t path_upper_bound = PairInfoPathLengthUpperBound(graph_.k(), insert_size_, delta_);
-    PathProcessor <Graph> paths_proc(graph_, graph_.EdgeEnd(e1), path_upper_bound);
+
+    // Dijkstra is run from the end of e1 only once something is missing in the cache
+    size_t tid = omp_get_thread_num();
+    std::unique_ptr<PathProcessorT> local;
+    std::unique_ptr<PathProcessorT> &paths_proc = tid < processors_.size() ? processors_[tid] : local;
+    bool processor_ready = false;
 
     for (auto &entry : second_edges) {
         EdgeId e2 = entry.first;
+        VertexId end = graph_.EdgeStart(e2);
         size_t path_lower_bound = PairInfoPathLengthLowerBound(graph_.k(), graph_.length(e1),
                                                                graph_.length(e2), gap_, delta_);
 
         TRACE("Bounds for paths are " << path_lower_bound << " " << path_upper_bound);
 
-        DistancesLengthsCallback<Graph> callback(graph_);
-        paths_proc.Process(graph_.EdgeStart(e2), path_lower_bound, path_upper_bound, callback);
-        GraphLengths lengths = callback.distances();
-        for (size_t j = 0; j < lengths.size(); ++j) {
-            lengths[j] += graph_.length(e1);
+        VertexPair key(start.int_id(), end.int_id());
+        CacheShard &shard = cache_[VertexPairHash()(key) % CACHE_SHARDS];
+        GraphLengths path_lengths;
+        bool cached = false;
+        {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            auto it = shard.lengths.find(key);
+            if (it != shard.lengths.end()) {
+                path_lengths = it->second;
+                cached = true;
+            }
+        }
+
+        if (!cached) {
+            if (!paths_proc)
+                paths_proc.reset(new PathProcessorT(graph_, start, path_upper_bound));
+            else if (!processor_ready)
+                paths_proc->Reset(start);
+            processor_ready = true;
+
+            path_lengths = PathLengths(*paths_proc, end, path_upper_bound);
+
+            std::lock_guard<std::mutex> guard(shard.lock);
+            if (shard.lengths.size() < shard_capacity_ &&
+                shard.lengths.emplace(key, path_lengths).second)
+                cached_ += 1;
+        }
+
+        GraphLengths lengths;
+        for (size_t length : path_lengths) {
+            if (length < path_lower_bound)
+                continue;
+            lengths.push_back(length + graph_.length(e1));
             TRACE("Resulting distance set for " <<
                                                 " edge " << graph_.int_id(e2) <<
-                                                " #" << j << " length " << lengths[j]);
+                                                " #" << lengths.size() - 1 << " length " << lengths.back());
         }
 
         if (e1 == e2)
@@ -9,6 +9,7 @@
 #define DISTANCE_ESTIMATION_HPP_
 
 #include "utils/parallel/openmp_wrapper.h"
+#include "assembly_graph/core/action_handlers.hpp"
 #include "assembly_graph/core/basic_graph_stats.hpp"
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/paths/path_processor.hpp"
@@ -17,32 +18,83 @@
 #include "paired_info.hpp"
 #include "math/xmath.h"
 
+#include <parallel_hashmap/phmap.h>
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 namespace omnigraph {
 
 namespace de {
 
 //todo move to some more common place
-class GraphDistanceFinder {
+/**
+ * Finds the lengths of the paths between the pairs of edges. Lengths of all
+ * the paths (up to the upper bound given by the insert size) between the end
+ * of the first edge and the start of the second one depend on the pair of
+ * vertices only, so they are memoized in a bounded cache shared by all the
+ * threads; the lower bounds are applied on top of the cached lengths. Any
+ * modification of the graph topology drops the cache.
+ */
+class GraphDistanceFinder : public omnigraph::GraphActionHandler<debruijn_graph::Graph> {
+    typedef omnigraph::GraphActionHandler<debruijn_graph::Graph> base;
     typedef std::vector<debruijn_graph::EdgeId> Path;
     typedef std::vector<size_t> GraphLengths;
     typedef std::map<debruijn_graph::EdgeId, GraphLengths> LengthMap;
+    typedef PathProcessor<debruijn_graph::Graph> PathProcessorT;
 
 public:
-    GraphDistanceFinder(const debruijn_graph::Graph &graph, size_t insert_size, size_t read_length, size_t delta) :
-            graph_(graph), insert_size_(insert_size), gap_((int) (insert_size - 2 * read_length)),
-            delta_((double) delta) { }
+    static const size_t DEFAULT_CACHE_SIZE = 1 << 18;
+
+    GraphDistanceFinder(const debruijn_graph::Graph &graph, size_t insert_size, size_t read_length, size_t delta,
+                        size_t cache_size = DEFAULT_CACHE_SIZE);
 
     std::vector<size_t> GetGraphDistancesLengths(debruijn_graph::EdgeId e1, debruijn_graph::EdgeId e2) const;
 
     // finds all distances from a current edge to a set of edges
     void FillGraphDistancesLengths(debruijn_graph::EdgeId e1, LengthMap &second_edges) const;
 
+    void Invalidate();
+
+    bool IsThreadSafe() const override { return true; }
+
+    void HandleAdd(debruijn_graph::EdgeId) override { Invalidate(); }
+    void HandleDelete(debruijn_graph::EdgeId) override { Invalidate(); }
+    void HandleMerge(const std::vector<debruijn_graph::EdgeId> &, debruijn_graph::EdgeId) override { Invalidate(); }
+    void HandleGlue(debruijn_graph::EdgeId, debruijn_graph::EdgeId, debruijn_graph::EdgeId) override { Invalidate(); }
+    void HandleSplit(debruijn_graph::EdgeId, debruijn_graph::EdgeId, debruijn_graph::EdgeId) override { Invalidate(); }
+
 private:
+    typedef std::pair<uint64_t, uint64_t> VertexPair;
+
+    struct VertexPairHash {
+        size_t operator()(const VertexPair &p) const {
+            return phmap::HashState().combine(0, p.first, p.second);
+        }
+    };
+
+    struct CacheShard {
+        std::mutex lock;
+        phmap::flat_hash_map<VertexPair, GraphLengths, VertexPairHash> lengths;
+    };
+
+    static const size_t CACHE_SHARDS = 64;
+
+    // Lengths of all the paths from the start of the processor to the vertex
+    GraphLengths PathLengths(const PathProcessorT &paths_proc, debruijn_graph::VertexId end,
+                             size_t path_upper_bound) const;
+
     DECL_LOGGER("GraphDistanceFinder");
     const debruijn_graph::Graph &graph_;
     const size_t insert_size_;
     const int gap_;
     const double delta_;
+
+    const size_t shard_capacity_;
+    mutable std::unique_ptr<CacheShard[]> cache_;
+    mutable std::atomic<size_t> cached_;
+    mutable std::vector<std::unique_ptr<PathProcessorT>> processors_;
 };
 
 class AbstractDistanceEstimator {
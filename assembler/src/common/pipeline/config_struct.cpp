@@ -219,6 +219,7 @@ void load(debruijn_config::construction& con,
     load(con.keep_perfect_loops, pt, "keep_perfect_loops", complete);
     load(con.read_buffer_size, pt, "read_buffer_size", complete);
     load(con.read_cov_threshold, pt, "read_cov_threshold", complete);
+    load(con.in_memory_kmer_counting, pt, "in_memory_kmer_counting", false);
 
     con.read_buffer_size *= 1024 * 1024;
     load(con.early_tc, pt, "early_tip_clipper", complete);
@@ -626,6 +627,7 @@ void load(debruijn_config::simplification& simp,
   using config_common::load;
 
   load(simp.cycle_iter_count, pt, "cycle_iter_count", complete);
+  load(simp.apply_batch_size, pt, "apply_batch_size", false);
 
   load(simp.topology_simplif_enabled, pt, "topology_simplif_enabled", complete);
   load(simp.tc, pt, "tc", complete); // tip clipper:
@@ -747,6 +749,7 @@ void load_launch_info(debruijn_config &cfg, boost::property_tree::ptree const &p
     load(cfg.temp_bin_reads_dir, pt, "temp_bin_reads_dir");
     if (cfg.temp_bin_reads_dir[cfg.temp_bin_reads_dir.length() - 1] != '/')
         cfg.temp_bin_reads_dir += '/';
+    cfg.compress_bin_reads = pt.get("compress_bin_reads", false);
 
     load(cfg.max_threads, pt, "max_threads");
     cfg.max_threads = spades_set_omp_threads(cfg.max_threads);
@@ -269,6 +269,8 @@ struct debruijn_config {
         };
 
         size_t cycle_iter_count;
+        // candidates of the edge removers are checked in parallel in batches of this size, 0 to disable
+        size_t apply_batch_size;
 
         bool topology_simplif_enabled;
         tip_clipper tc;
@@ -292,6 +294,8 @@ struct debruijn_config {
         bulge_remover final_br;
         bulge_remover subspecies_br;
         init_cleaning init_clean;
+
+        simplification() : apply_batch_size(0) {}
     };
 
     struct construction {
@@ -305,10 +309,12 @@ struct debruijn_config {
         bool keep_perfect_loops;
         unsigned read_cov_threshold;
         size_t read_buffer_size;
+        bool in_memory_kmer_counting;
         construction() :
                 keep_perfect_loops(true),
                 read_cov_threshold(0),
-                read_buffer_size(0) {}
+                read_buffer_size(0),
+                in_memory_kmer_counting(true) {}
     };
 
     simplification simp;
@@ -508,6 +514,7 @@ struct debruijn_config {
     // Conversion options
     std::string temp_bin_reads_dir;
     std::string temp_bin_reads_path;
+    bool compress_bin_reads;
     std::string paired_read_prefix;
     std::string single_read_prefix;
 
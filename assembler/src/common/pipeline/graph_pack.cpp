@@ -15,6 +15,7 @@
 #include "modules/alignment/edge_index.hpp"
 #include "modules/alignment/kmer_mapper.hpp"
 #include "modules/alignment/long_read_storage.hpp"
+#include "modules/alignment/mapping_cache.hpp"
 #include "paired_info/paired_info.hpp"
 #include "sequence/genome_storage.hpp"
 #include "visualization/position_filler.hpp"
@@ -30,6 +31,7 @@ GraphPack::GraphPack(size_t k, const std::string &workdir, size_t lib_count,
     Graph &g = emplace<Graph>(k);
     emplace<EdgeIndex<Graph>>(g, workdir);
     emplace<KmerMapper<Graph>>(g);
+    emplace<MappingCache>(g, workdir);
     emplace<FlankingCoverage<Graph>>(g, flanking_range);
     emplace<UnclusteredPairedInfoIndicesT<Graph>>(g, lib_count);
     emplace_with_key<PairedInfoIndicesT<Graph>>("clustered_indices", g, lib_count);
@@ -61,8 +63,10 @@ void GraphPack::ClearQuality() {
 
 void GraphPack::EnsureIndex() {
     auto &index = get_mutable<EdgeIndex<Graph>>();
-    if (index.IsAttached())
+    if (index.IsAttached()) {
+        index.Update();
         return;
+    }
 
     INFO("Index refill");
     index.Refill();
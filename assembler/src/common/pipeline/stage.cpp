@@ -32,7 +32,7 @@ void AssemblyStage::load(debruijn_graph::GraphPack& gp,
     io::binary::FullPackIO().Load(p, gp);
     debruijn_graph::config::load_lib_data(p);
 
-    io::ConvertIfNeeded(cfg::get_writable().ds.reads, cfg::get().max_threads);
+    io::ConvertIfNeeded(cfg::get_writable().ds.reads, cfg::get().max_threads, cfg::get().compress_bin_reads);
 
 }
 
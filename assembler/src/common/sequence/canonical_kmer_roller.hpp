@@ -0,0 +1,91 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "nucl.hpp"
+#include "utils/verify.hpp"
+
+#include <cstddef>
+
+/**
+ * Rolls a k-mer together with its reverse complement along a sequence.
+ *
+ * Shifting a nucleotide in costs one left shift of the forward k-mer and one
+ * right shift of the reverse complement, so the canonical (minimal of the two)
+ * k-mer is available at every position without building !kmer from scratch.
+ *
+ * @example
+ *   CanonicalKMerRoller<RtSeq> roller(seq.start<RtSeq>(k));
+ *   Process(roller.canonical());
+ *   for (size_t i = k; i < seq.size(); ++i) {
+ *     roller <<= seq[i];
+ *     Process(roller.canonical());
+ *   }
+ * @param Seq RtSeq or Seq<K>
+ */
+template<class Seq>
+class CanonicalKMerRoller {
+    Seq fwd_;
+    Seq rc_;
+
+public:
+    CanonicalKMerRoller() = default;
+
+    explicit CanonicalKMerRoller(const Seq &kmer)
+            : fwd_(kmer), rc_(!kmer) {}
+
+    /**
+     * Appends c to the forward k-mer and prepends its complement to the
+     * reverse complement one.
+     *
+     * @param c ACGT or 0123 char
+     */
+    void operator<<=(char c) {
+        if (is_nucl(c))
+            c = dignucl(c);
+        VERIFY_DEV(is_dignucl(c));
+
+        fwd_ <<= c;
+        rc_ >>= complement(c);
+    }
+
+    const Seq &forward() const {
+        return fwd_;
+    }
+
+    const Seq &reverse_complement() const {
+        return rc_;
+    }
+
+    /**
+     * Same as forward().IsMinimal(), but compares two ready k-mers.
+     */
+    bool IsMinimal() const {
+        const auto *fwd = fwd_.data();
+        const auto *rc = rc_.data();
+        for (size_t i = 0; i < fwd_.data_size(); ++i) {
+            auto diff = fwd[i] ^ rc[i];
+            if (diff) {
+                // The first nucleotide resides in the lowest bits
+                unsigned shift = unsigned(__builtin_ctzll(diff)) & ~1u;
+                return ((fwd[i] >> shift) & 3) < ((rc[i] >> shift) & 3);
+            }
+        }
+        return true;
+    }
+
+    const Seq &canonical() const {
+        return IsMinimal() ? fwd_ : rc_;
+    }
+
+    /**
+     * Hash of the canonical k-mer, the same for both strands.
+     */
+    size_t GetHash(uint64_t seed = 0) const {
+        return canonical().GetHash(seed);
+    }
+};
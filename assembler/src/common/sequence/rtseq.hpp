@@ -31,6 +31,33 @@
 #define XXH_INLINE_ALL
 #include "xxh/xxhash.h"
 
+namespace rtseq_kernels {
+
+/**
+ * Reverses the order of 2-bit nucleotides within the word: swap of the
+ * neighbouring nucleotides, then of the nibbles, then the byte swap.
+ */
+inline uint64_t ReverseNucls(uint64_t w) {
+    w = ((w >> 2) & 0x3333333333333333ULL) | ((w & 0x3333333333333333ULL) << 2);
+    w = ((w >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((w & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return __builtin_bswap64(w);
+}
+
+inline uint32_t ReverseNucls(uint32_t w) {
+    w = ((w >> 2) & 0x33333333U) | ((w & 0x33333333U) << 2);
+    w = ((w >> 4) & 0x0F0F0F0FU) | ((w & 0x0F0F0F0FU) << 4);
+    return __builtin_bswap32(w);
+}
+
+template<typename T>
+struct HasWordKernels : std::integral_constant<bool, std::is_same<T, uint64_t>::value ||
+                                                     std::is_same<T, uint32_t>::value> {};
+
+// Number of words handled by the unrolled kernels, longer sequences take the generic path
+const size_t MAX_UNROLLED_WORDS = 4;
+
+}
+
 template<size_t max_size_, typename T = seq_element_type>
 class RuntimeSeq {
 public:
@@ -195,6 +222,87 @@ private:
                 (data_[i >> TNuclBits] & ~((T) 3 << ((i & (TNucl - 1)) << 1))) | ((T) c << ((i & (TNucl - 1)) << 1));
     }
 
+    /*
+     * Kernels for the hot k-mer operations. N is the number of words occupied
+     * by the sequence; the kernels are instantiated for all N up to
+     * min(DataSize, MAX_UNROLLED_WORDS), so for the common K the loops are
+     * fully unrolled and free of branches. N == 0 denotes the generic kernel
+     * with the runtime number of words.
+     */
+    template<size_t N>
+    using Words = std::integral_constant<size_t, N>;
+
+    template<class Kernel>
+    static void DispatchWords(size_t data_size, Kernel kernel) {
+        using rtseq_kernels::MAX_UNROLLED_WORDS;
+        const size_t Unrolled = DataSize < MAX_UNROLLED_WORDS ? DataSize : MAX_UNROLLED_WORDS;
+        switch (data_size) {
+            case 1: kernel(Words<1>()); break;
+            case 2: kernel(Words<(2 < Unrolled ? 2 : Unrolled)>()); break;
+            case 3: kernel(Words<(3 < Unrolled ? 3 : Unrolled)>()); break;
+            case 4: kernel(Words<(4 < Unrolled ? 4 : Unrolled)>()); break;
+            default: kernel(Words<0>());
+        }
+    }
+
+    // Drops the first nucleotide and appends c after the last one
+    template<size_t N>
+    static void ShiftLeftKernel(T *data, size_t data_size, size_t size, T c) {
+        const size_t words = N ? N : data_size;
+        for (size_t i = 0; i + 1 < words; ++i)
+            data[i] = T(data[i] >> 2) | T(data[i + 1] << (TBits - 2));
+        data[words - 1] = T(data[words - 1] >> 2) | T(c << (((size - 1) & (TNucl - 1)) << 1));
+    }
+
+    // Drops the last nucleotide and prepends c before the first one
+    template<size_t N>
+    static void ShiftRightKernel(T *data, size_t data_size, size_t size, T c) {
+        const size_t words = N ? N : data_size;
+        for (size_t i = words - 1; i > 0; --i)
+            data[i] = T(data[i] << 2) | T(data[i - 1] >> (TBits - 2));
+        data[0] = T(data[0] << 2) | c;
+        data[words - 1] &= T(MaskForLastBucket(size));
+    }
+
+    // Word i of the reverse complement: the whole words are reversed and
+    // complemented, then shifted by the padding of the last word
+    template<size_t N>
+    static T RCWord(const T *data, size_t data_size, size_t pad, size_t i) {
+        const size_t words = N ? N : data_size;
+        T res = rtseq_kernels::ReverseNucls(T(~data[words - 1 - i]));
+        if (pad == 0)
+            return res;
+        res = T(res >> pad);
+        if (i + 1 < words)
+            res |= T(rtseq_kernels::ReverseNucls(T(~data[words - 2 - i])) << (TBits - pad));
+        return res;
+    }
+
+    template<size_t N>
+    static void RCKernel(const T *data, T *res, size_t data_size, size_t size) {
+        const size_t words = N ? N : data_size;
+        const size_t pad = ((words << TNuclBits) - size) << 1;
+        for (size_t i = 0; i < words; ++i)
+            res[i] = RCWord<N>(data, data_size, pad, i);
+    }
+
+    // Lexicographic comparison starts with the lowest bits of the first word,
+    // the reverse complement is built word by word only until the first difference
+    template<size_t N>
+    static bool IsMinimalKernel(const T *data, size_t data_size, size_t size) {
+        const size_t words = N ? N : data_size;
+        const size_t pad = ((words << TNuclBits) - size) << 1;
+        for (size_t i = 0; i < words; ++i) {
+            T rc = RCWord<N>(data, data_size, pad, i);
+            T diff = data[i] ^ rc;
+            if (diff) {
+                unsigned shift = unsigned(__builtin_ctzll(diff)) & ~1u;
+                return ((data[i] >> shift) & 3) < ((rc >> shift) & 3);
+            }
+        }
+        return true;
+    }
+
     // Template voodoo to calculate the length of the string regardless whether it is std::string or const char*
     template<class S>
     size_t size(const S &t,
@@ -395,7 +503,7 @@ public:
 //    if ((size_ & 1) == 1) {
 //      res.set(size_ >> 1, complement(res[size_ >> 1]));
 //    }
-        return FastRC();
+        return RC(rtseq_kernels::HasWordKernels<T>());
 //    return res;
     }
 
@@ -405,6 +513,39 @@ public:
      * @return True if kmer < !kmer and false otherwise.
      */
     bool IsMinimal() const {
+        return IsMinimal(rtseq_kernels::HasWordKernels<T>());
+    }
+
+private:
+    RuntimeSeq<max_size_, T> RC(std::true_type) const {
+        RuntimeSeq<max_size_, T> res(size_);
+        size_t data_size = GetDataSize(size_);
+        if (data_size == 0)
+            return res;
+
+        DispatchWords(data_size, [&](auto words) {
+            RCKernel<decltype(words)::value>(data_.data(), res.data_.data(), data_size, size_);
+        });
+        return res;
+    }
+
+    RuntimeSeq<max_size_, T> RC(std::false_type) const {
+        return FastRC();
+    }
+
+    bool IsMinimal(std::true_type) const {
+        size_t data_size = GetDataSize(size_);
+        if (data_size == 0)
+            return true;
+
+        bool res = true;
+        DispatchWords(data_size, [&](auto words) {
+            res = IsMinimalKernel<decltype(words)::value>(data_.data(), data_size, size_);
+        });
+        return res;
+    }
+
+    bool IsMinimal(std::false_type) const {
         for (size_t i = 0; (i << 1) + 1 <= size_; ++i) {
             auto front = this->operator[](i);
             auto end = complement(this->operator[](size_ - 1 - i));
@@ -414,6 +555,8 @@ public:
         return true;
     }
 
+public:
+
     /**
      * Shift left
      *
@@ -421,29 +564,8 @@ public:
      * @return Shifted (to the left) sequence with 'c' char on the right.
      */
     RuntimeSeq<max_size_, T> operator<<(char c) const {
-        if (is_nucl(c)) {
-            c = dignucl(c);
-        }
-
         RuntimeSeq<max_size_, T> res(*this);
-        std::array<T, DataSize> &data = res.data_;
-
-        size_t data_size = GetDataSize(size_);
-
-        if (data_size != 0) { // unless empty sequence
-            T rm = data[data_size - 1] & 3;
-            T lastnuclshift_ = ((size_ + TNucl - 1) & (TNucl - 1)) << 1;
-            data[data_size - 1] = (data[data_size - 1] >> 2) | ((T) c << lastnuclshift_);
-
-            if (data_size >= 2) { // if we have at least 2 elements in data
-                for (int i = (int) data_size - 2; i >= 0; --i) {
-                    T new_rm = data[i] & 3;
-                    data[i] = (data[i] >> 2) |
-                              (rm << (TBits - 2)); // we need & here because if we shift negative, it fill with ones :(
-                    rm = new_rm;
-                }
-            }
-        }
+        res <<= c;
         return res;
     }
 
@@ -458,12 +580,9 @@ public:
             return;
         }
 
-        for (size_t i = 0; i < data_size - 1; ++i) {
-            data_[i] = (data_[i] >> 2) | (((T) data_[i + 1] & 3) << (TBits - 2));
-        }
-
-        T lastnuclshift_ = ((size_ + TNucl - 1) & (TNucl - 1)) << 1;
-        data_[data_size - 1] = (data_[data_size - 1] >> 2) | ((T) c << lastnuclshift_);
+        DispatchWords(data_size, [&](auto words) {
+            ShiftLeftKernel<decltype(words)::value>(data_.data(), data_size, size_, T(c));
+        });
     }
 
 //todo naming convention violation!
@@ -558,27 +677,11 @@ public:
      * @return Shifted (to the right) sequence with 'c' char on the left.
      */
     RuntimeSeq<max_size_, T> operator>>(char c) const {
-        if (is_nucl(c)) {
-            c = dignucl(c);
-        }
-        VERIFY_DEV(is_dignucl(c));
-
         RuntimeSeq<max_size_, T> res(*this);
-        size_t data_size = GetDataSize(size_);
-
-        T rm = c;
-        for (size_t i = 0; i < data_size; ++i) {
-            T new_rm = (res.data_[i] >> (TBits - 2)) & 3;
-            res.data_[i] = (res.data_[i] << 2) | rm;
-            rm = new_rm;
-        }
-
-        res.data_[data_size - 1] &= MaskForLastBucket(size_);
-
+        res >>= c;
         return res;
     }
 
-    //todo remove code duplication!
     void operator>>=(char c) {
         if (is_nucl(c)) {
             c = dignucl(c);
@@ -587,14 +690,13 @@ public:
 
         size_t data_size = GetDataSize(size_);
 
-        T rm = (T) c;
-        for (size_t i = 0; i < data_size; ++i) {
-            T new_rm = (data_[i] >> (TBits - 2)) & 3;
-            data_[i] = (data_[i] << 2) | rm;
-            rm = new_rm;
+        if (data_size == 0) {
+            return;
         }
 
-        data_[data_size - 1] &= MaskForLastBucket(size_);
+        DispatchWords(data_size, [&](auto words) {
+            ShiftRightKernel<decltype(words)::value>(data_.data(), data_size, size_, T(c));
+        });
     }
 
     bool operator==(const RuntimeSeq<max_size_, T> &s) const {
@@ -277,6 +277,10 @@ public:
         return res;
     }
 
+    void operator<<=(char c) {
+        *this = *this << c;
+    }
+
     Seq<size_ + 1, T> pushBack(char c) const {
         if (is_nucl(c)) {
             c = dignucl(c);
@@ -349,6 +353,10 @@ public:
         return res;
     }
 
+    void operator>>=(char c) {
+        *this = *this >> c;
+    }
+
     /**
      * Sets i-th symbol of Seq with 0123-char
      */
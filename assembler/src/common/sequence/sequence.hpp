@@ -170,6 +170,31 @@ public:
         kmer.copy_data(data_->data());
     }
 
+    /**
+     * Sequence of size nucleotides which raw 2-bit packed storage
+     * (DataSize(size) words) is filled in place by fill(ST *). Several
+     * sequences can be put into a single buffer this way and then shared as
+     * its Subseq()'s.
+     */
+    template<class F>
+    static Sequence FromRawData(size_t size, F fill) {
+        Sequence res(size, 0);
+        fill(res.data_->data());
+        return res;
+    }
+
+    /**
+     * Raw 2-bit packed storage (as in FromRawData) starting from the first
+     * nucleotide, if the sequence is a forward view starting at a word
+     * boundary of its buffer, nullptr otherwise. Bits past the end of the
+     * sequence are not necessarily zero.
+     */
+    const ST *raw_data() const {
+        if (rtl_ || (from_ & (STN - 1)))
+            return nullptr;
+        return data_->data() + (from_ >> STNBits);
+    }
+
     Sequence(const Sequence &s)
             : Sequence(s, s.from_, s.size_, s.rtl_) {}
 
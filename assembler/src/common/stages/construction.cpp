@@ -38,6 +38,7 @@ struct ConstructionStorage {
     std::unique_ptr<CoverageMap> coverage_map;
     config::debruijn_config::construction params;
     io::ReadStreamList<io::SingleReadSeq> read_streams;
+    size_t read_count = 0;
     io::ReadStreamList<io::SingleReadSeq> contigs_streams;
     fs::TmpDir workdir;
 };
@@ -157,6 +158,7 @@ void Construction::init(debruijn_graph::GraphPack &gp, const char *) {
 
     dataset.aRL = double(total_nucls) / double(read_count);
     INFO("Average read length " << dataset.aRL);
+    storage().read_count = read_count;
 }
 
 void Construction::fini(debruijn_graph::GraphPack &) {
@@ -168,6 +170,7 @@ Construction::~Construction() {}
 namespace {
 
 class CoverageFilter: public Construction::Phase {
+    static constexpr size_t CARDINALITY_SAMPLE_READS = 16000000;
   public:
     CoverageFilter()
             : Construction::Phase("k-mer multiplicity estimation", "cqf_filter") { }
@@ -187,16 +190,21 @@ class CoverageFilter: public Construction::Phase {
         unsigned kplusone = index.k() + 1;
         rolling_hash::SymmetricCyclicHash<rolling_hash::NDNASeqHash> hasher(kplusone);
 
+        // Only a sample of reads is used for the estimation, the CQF grows
+        // while being filled if the estimate turns out to be too small
         INFO("Estimating k-mers cardinality");
-        size_t kmers = EstimateCardinalityUpperBound(kplusone, read_streams, hasher, KmerFilter());
+        size_t kmers = EstimateCardinalityFromSample(kplusone, read_streams, hasher,
+                                                     storage().read_count, CARDINALITY_SAMPLE_READS, KmerFilter());
 
         // Create main CQF using # of slots derived from estimated # of k-mers
         storage().cqf.reset(new qf::cqf(kmers));
 
         INFO("Building k-mer coverage histogram");
-        FillCoverageHistogram(*storage().cqf, kplusone, hasher, read_streams, rthr, KmerFilter());
+        FillCoverageHistogram(*storage().cqf, kplusone, hasher, read_streams, rthr, KmerFilter(),
+                              cfg::get().ds.RL);
 
-        // Replace input streams with wrapper ones
+        // Replace input streams with wrapper ones, they remember the decisions,
+        // so the subsequent passes over the reads do not compute them again
         storage().read_streams = io::CovFilteringWrap(std::move(read_streams), kplusone, hasher, *storage().cqf, rthr);
     }
 
@@ -239,10 +247,10 @@ public:
         using Splitter =  utils::DeBruijnReadKMerSplitter<io::SingleReadSeq,
                                                           utils::StoringTypeFilter<storing_type>>;
 
-        kmers::KMerDiskCounter<RtSeq>
-                counter(storage().workdir,
-                        Splitter(storage().workdir, index.k() + 1, merge_streams, buffer_size));
-        auto kmers = counter.Count(10 * nthreads, nthreads);
+        auto counter = kmers::make_kmer_counter<RtSeq>(storage().workdir,
+                                                       Splitter(storage().workdir, index.k() + 1, merge_streams, buffer_size),
+                                                       storage().params.in_memory_kmer_counting);
+        auto kmers = counter->Count(10 * nthreads, nthreads);
         storage().kmers.reset(new kmers::KMerDiskStorage<RtSeq>(std::move(kmers)));
     }
 
@@ -272,7 +280,8 @@ public:
                                                                               storage().ext_index,
                                                                               *storage().kmers,
                                                                               unsigned(storage().read_streams.size()),
-                                                                              storage().params.read_buffer_size);
+                                                                              storage().params.read_buffer_size,
+                                                                              storage().params.in_memory_kmer_counting);
     }
 
     void load(debruijn_graph::GraphPack&,
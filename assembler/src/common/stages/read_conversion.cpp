@@ -11,7 +11,7 @@ namespace spades {
 
 void ReadConversion::run(debruijn_graph::GraphPack &, const char *) {
     io::ConvertIfNeeded(cfg::get_writable().ds.reads,
-                        cfg::get().max_threads);
+                        cfg::get().max_threads, cfg::get().compress_bin_reads);
 }
 
 void ReadConversion::load(debruijn_graph::GraphPack &,
@@ -31,7 +31,8 @@ SimplifInfoContainer CreateInfoContainer(const GraphPack &gp) {
     SimplifInfoContainer info_container(cfg::get().mode);
     info_container.set_read_length(cfg::get().ds.RL)
             .set_main_iteration(cfg::get().main_iteration)
-            .set_chunk_cnt(5 * cfg::get().max_threads);
+            .set_chunk_cnt(5 * cfg::get().max_threads)
+            .set_apply_batch_size(cfg::get().simp.apply_batch_size);
 
     //0 if model didn't converge
     //todo take max with trusted_bound
@@ -421,8 +422,9 @@ void RawSimplification::run(GraphPack &gp, const char*) {
     //no other handlers here, todo change with DetachAll
     auto &index = gp.get_mutable<EdgeIndex<Graph>>();
     if (index.IsAttached())
-        index.Detach();
-    index.clear();
+        index.DeferUpdates();
+    else
+        index.clear();
 
     visualization::graph_labeler::DefaultLabeler<Graph> labeler(gp.get<Graph>(), gp.get<EdgesPositionHandler<Graph>>());
     stats::detail_info_printer printer(gp, labeler, cfg::get().output_dir);
@@ -439,6 +441,7 @@ void RawSimplification::run(GraphPack &gp, const char*) {
     } else {
         simplifier.InitialCleaning();
     }
+    index.Update();
 }
 
 void Simplification::run(GraphPack &gp, const char*) {
@@ -447,8 +450,9 @@ void Simplification::run(GraphPack &gp, const char*) {
     //no other handlers here, todo change with DetachAll
     auto &index = gp.get_mutable<EdgeIndex<Graph>>();
     if (index.IsAttached())
-        index.Detach();
-    index.clear();
+        index.DeferUpdates();
+    else
+        index.clear();
 
     visualization::graph_labeler::DefaultLabeler<Graph> labeler(gp.get<Graph>(), gp.get<EdgesPositionHandler<Graph>>());
     stats::detail_info_printer printer(gp, labeler, cfg::get().output_dir);
@@ -472,6 +476,7 @@ void Simplification::run(GraphPack &gp, const char*) {
                                printer);
     simplifier.SimplifyGraph();
     CompressAllVertices(gp.get_mutable<Graph>());
+    index.Update();
 }
 
 void SimplificationCleanup::run(GraphPack &gp, const char*) {
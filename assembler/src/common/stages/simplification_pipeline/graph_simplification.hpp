@@ -343,7 +343,17 @@ protected:
         return false;
     }
 
+    bool Check(EdgeId e) const override {
+        return remove_condition_(e);
+    }
+
+    void Apply(EdgeId e) override {
+        edge_remover_.DeleteEdge(e);
+    }
+
 public:
+    using base::set_batch_size;
+
     LowCoverageEdgeRemovingAlgorithm(Graph &g,
                                      const std::string &condition_str,
                                      const SimplifInfoContainer &simplif_info,
@@ -531,11 +541,13 @@ AlgoPtr<Graph> RelativeECRemoverInstance(Graph &g,
     if (!rcec_config.enabled)
         return nullptr;
 
-    return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph>>(g,
+    auto algo = std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph>>(g,
             AddRelativeCoverageECCondition(g, rcec_config.rcec_ratio,
                                            AddAlternativesPresenceCondition(g, func::TypedPredicate<typename Graph::EdgeId>
                                                    (LengthUpperBound<Graph>(g, rcec_config.max_ec_length)))),
             info.chunk_cnt(), removal_handler, /*canonical_only*/true);
+    algo->set_batch_size(info.apply_batch_size());
+    return algo;
 }
 
 template<class Graph>
@@ -546,8 +558,10 @@ AlgoPtr<Graph> ECRemoverInstance(Graph &g,
     if (ec_config.condition.empty())
         return nullptr;
 
-    return std::make_shared<LowCoverageEdgeRemovingAlgorithm<Graph>>(
+    auto algo = std::make_shared<LowCoverageEdgeRemovingAlgorithm<Graph>>(
             g, ec_config.condition, info, removal_handler);
+    algo->set_batch_size(info.apply_batch_size());
+    return algo;
 }
 
 template<class Graph>
@@ -556,13 +570,15 @@ AlgoPtr<Graph> TipClipperInstance(Graph &g,
                                   const SimplifInfoContainer &info,
                                   EdgeRemovalHandlerF<Graph> removal_handler = nullptr,
                                   bool track_changes = true) {
-    return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
+    auto algo = std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
                                                                         AddTipCondition(g, condition),
                                                                         info.chunk_cnt(),
                                                                         removal_handler,
                                                                         /*canonical_only*/true,
                                                                         LengthComparator<Graph>(g),
                                                                         track_changes);
+    algo->set_batch_size(info.apply_batch_size());
+    return algo;
 }
 
 template<class Graph>
@@ -594,9 +610,11 @@ AlgoPtr<Graph> DeadEndInstance(Graph &g,
 
     ConditionParser<Graph> parser(g, dead_end_config.condition, info);
     auto condition = parser();
-    return std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
+    auto algo = std::make_shared<omnigraph::ParallelEdgeRemovingAlgorithm<Graph, omnigraph::LengthComparator<Graph>>>(g,
             AddDeadEndCondition(g, condition), info.chunk_cnt(), removal_handler, /*canonical_only*/true,
             LengthComparator<Graph>(g), /*track changes*/true);
+    algo->set_batch_size(info.apply_batch_size());
+    return algo;
 }
 
 template<class Graph>
@@ -51,10 +51,12 @@ void SSEdgeSplit::run(GraphPack& gp, const char *) {
 
         auto &index = gp.get_mutable<EdgeIndex<Graph>>();
         if (index.IsAttached())
-            index.Detach();
-        index.clear();
+            index.DeferUpdates();
+        else
+            index.clear();
 
         splitter.SplitEdges();
+        index.Update();
         break;
     }
 }
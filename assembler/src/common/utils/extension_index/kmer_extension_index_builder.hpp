@@ -63,18 +63,20 @@ public:
     kmers::KMerDiskStorage<RtSeq>
     BuildExtensionIndexFromStream(fs::TmpDir workdir, Index &index,
                                   Streams &streams,
-                                  size_t read_buffer_size = 0) const {
+                                  size_t read_buffer_size = 0,
+                                  bool in_memory = false) const {
         unsigned nthreads = (unsigned) streams.size();
         using KmerFilter = StoringTypeFilter<typename Index::storing_type>;
 
         // First, build a k+1-mer index
         using Splitter = DeBruijnReadKMerSplitter<typename Streams::ReadT, KmerFilter>;
-        kmers::KMerDiskCounter<RtSeq> counter(workdir,
-                                              Splitter(workdir, index.k() + 1, streams, read_buffer_size));
-        auto kmers = counter.Count(10 * nthreads, nthreads);
+        auto counter = kmers::make_kmer_counter<RtSeq>(workdir,
+                                                       Splitter(workdir, index.k() + 1, streams, read_buffer_size),
+                                                       in_memory);
+        auto kmers = counter->Count(10 * nthreads, nthreads);
 
         BuildExtensionIndexFromKPOMers(workdir, index, kmers,
-                                       nthreads, read_buffer_size);
+                                       nthreads, read_buffer_size, in_memory);
 
         return kmers;
     }
@@ -82,7 +84,8 @@ public:
     template<class Index, class KMerStorage>
     void BuildExtensionIndexFromKPOMers(fs::TmpDir workdir,
                                         Index &index, const KMerStorage &kpomers,
-                                        unsigned nthreads, size_t read_buffer_size = 0) const {
+                                        unsigned nthreads, size_t read_buffer_size = 0,
+                                        bool in_memory = false) const {
         VERIFY(kpomers.k() == index.k() + 1);
 
         // Now, count unique k-mers from k+1-mers
@@ -92,9 +95,9 @@ public:
                           index.k() + 1, Index::storing_type::IsInvertable(), read_buffer_size);
         for (unsigned i = 0; i < kpomers.num_buckets(); ++i)
             splitter.AddKMers(adt::make_range(kpomers.bucket_begin(i), kpomers.bucket_end(i)));
-        kmers::KMerDiskCounter<RtSeq> counter(workdir, std::move(splitter));
+        auto counter = kmers::make_kmer_counter<RtSeq>(workdir, std::move(splitter), in_memory);
 
-        BuildIndex(index, counter, kpomers.num_buckets(), nthreads);
+        BuildIndex(index, *counter, kpomers.num_buckets(), nthreads);
 
         // Build the kmer extensions
         INFO("Building k-mer extensions from k+1-mers");
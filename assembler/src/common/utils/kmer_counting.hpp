@@ -234,9 +234,71 @@ size_t EstimateCardinalityUpperBound(unsigned k, ReadStream &streams, const Hash
     return size_t(res);
 }
 
+/**
+ * Estimates the number of distinct k-mers in total_reads reads of the streams
+ * from a sample of about sample_reads first reads. The number of new k-mers
+ * brought by a read only decreases as more reads are seen, so the rate over
+ * the second half of the sample extrapolated to the rest of the reads gives an
+ * upper bound. If the sample covers all the reads, the estimate is the same as
+ * EstimateCardinalityUpperBound() one.
+ */
+template<class ReadStream, class Hasher, class KMerFilter = utils::StoringTypeFilter<utils::SimpleStoring>>
+size_t EstimateCardinalityFromSample(unsigned k, ReadStream &streams, const Hasher &hasher,
+                                     size_t total_reads, size_t sample_reads,
+                                     const KMerFilter &filter = utils::StoringTypeFilter<utils::SimpleStoring>()) {
+    unsigned stream_num = unsigned(streams.size());
+    std::vector<hll::hll<>> hlls(stream_num);
+    std::vector<HllProcessor> processors;
+    for (size_t i = 0; i < hlls.size(); ++i) {
+        processors.push_back(HllProcessor(hlls[i]));
+    }
+
+    size_t half = std::max(sample_reads / (2 * stream_num), size_t(1));
+    auto fill_half = [&]() {
+        size_t reads = 0;
+#       pragma omp parallel for reduction(+:reads)
+        for (unsigned i = 0; i < stream_num; ++i) {
+            reads += FillFromStream(streams[i], hasher, processors[i], k, half, filter);
+        }
+        return reads;
+    };
+    auto cardinality = [&]() {
+        hll::hll<> res;
+        for (const auto &hll : hlls)
+            res.merge(hll);
+        return res.cardinality();
+    };
+
+    streams.reset();
+    size_t reads = fill_half();
+    double first_half = cardinality();
+    size_t second_half_reads = fill_half();
+    reads += second_half_reads;
+    double res = cardinality();
+    INFO("Sampled " << reads << " reads, " << size_t(res) << " distinct kmers");
+
+    if (!streams.eof() && total_reads > reads && second_half_reads) {
+        double rate = std::max(res - first_half, 0.) / double(second_half_reads);
+        res += rate * double(total_reads - reads);
+    }
+    res *= 1.1;
+
+    INFO("Estimated " << size_t(res) << " distinct kmers");
+    return size_t(res);
+}
+
+static const unsigned MIN_CQF_REMAINDER_BITS = 4;
+
+/**
+ * Counts the k-mers of the streams in cqf (up to thr). If max_read_length is
+ * given, cqf is expanded whenever it gets half full, so it could be sized
+ * from an estimate. Expansions shorten the remainders, once they get below
+ * MIN_CQF_REMAINDER_BITS the counting starts over with longer hashes.
+ */
 template<class Hasher, class ReadStream, class KMerFilter = utils::StoringTypeFilter<utils::SimpleStoring>>
 void FillCoverageHistogram(qf::cqf &cqf, unsigned k, const Hasher &hasher, ReadStream &streams,
-                           unsigned thr, const KMerFilter &filter = utils::StoringTypeFilter<utils::SimpleStoring>()) {
+                           unsigned thr, const KMerFilter &filter = utils::StoringTypeFilter<utils::SimpleStoring>(),
+                           size_t max_read_length = 0) {
     unsigned stream_num = unsigned(streams.size());
 
     // Create fallback per-thread CQF using same hash_size (important!) but different # of slots
@@ -249,10 +311,41 @@ void FillCoverageHistogram(qf::cqf &cqf, unsigned k, const Hasher &hasher, ReadS
     streams.reset();
     size_t reads = 0, n = 15;
     while (!streams.eof()) {
+        size_t round_reads = 1000000;
+        if (max_read_length) {
+            // The size of the CQF is not known in advance, so it grows. Every
+            // k-mer occupies at most one more slot, thus the number of reads
+            // processed before the next check is limited by the free slots.
+            size_t occupied = cqf.occupied_slots();
+            for (const auto &local_cqf : local_cqfs)
+                occupied += local_cqf.occupied_slots();
+            while (occupied > cqf.slots() / 2) {
+                if (cqf.remainder_bits() > MIN_CQF_REMAINDER_BITS) {
+                    INFO("Expanding CQF to " << 2 * cqf.slots() << " slots");
+                    cqf.expand();
+                    continue;
+                }
+
+                // The stored hashes are too short to be expanded once more
+                unsigned hash_bits = cqf.hash_bits() + 1 + qf::cqf::DEFAULT_REMAINDER_BITS - cqf.remainder_bits();
+                INFO("Rebuilding CQF with " << 2 * cqf.slots() << " slots and " << hash_bits << " hash bits");
+                cqf.reset(2 * cqf.slots(), hash_bits);
+                for (auto &local_cqf : local_cqfs)
+                    local_cqf.reset(local_cqf.slots(), hash_bits);
+                streams.reset();
+                reads = 0, n = 15;
+                occupied = 0;
+            }
+
+            size_t kmers_per_read = max_read_length >= k ? max_read_length - k + 1 : 1;
+            size_t free_slots = size_t(0.9 * double(cqf.slots())) - occupied;
+            round_reads = std::min(round_reads, std::max(free_slots / (stream_num * kmers_per_read), size_t(1)));
+        }
+
         #pragma omp parallel for reduction(+:reads)
         for (unsigned i = 0; i < stream_num; ++i) {
             CQFProcessor processor(cqf, local_cqfs[i], thr);
-            reads += FillFromStream(streams[i], hasher, processor, k, 1000000, filter);
+            reads += FillFromStream(streams[i], hasher, processor, k, round_reads, filter);
         }
 
         if (reads >> n) {
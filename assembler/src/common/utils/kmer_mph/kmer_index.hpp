@@ -89,6 +89,28 @@ public:
     return (idx == -1ULL ? idx : segment_starts_[bucket] + idx);
   }
 
+  // Batched version of seq_idx(): hashes of several k-mers are computed and
+  // the corresponding MPHF cells are prefetched before any of them is resolved,
+  // so the cache misses overlap.
+  void seq_idx(const KMerSeq *s, size_t n, size_t *idx) const {
+    constexpr size_t BATCH = 16;
+    boomphf::hash_pair_t hashes[BATCH];
+    size_t buckets[BATCH];
+    for (size_t start = 0; start < n; start += BATCH) {
+      size_t cnt = std::min(BATCH, n - start);
+      for (size_t i = 0; i < cnt; ++i) {
+        buckets[i] = seq_bucket(s[start + i]);
+        hashes[i] = index_[buckets[i]].hash(s[start + i]);
+        index_[buckets[i]].prefetch(hashes[i]);
+      }
+
+      for (size_t i = 0; i < cnt; ++i) {
+        size_t res = index_[buckets[i]].lookup(hashes[i]);
+        idx[start + i] = (res == -1ULL ? res : segment_starts_[buckets[i]] + res);
+      }
+    }
+  }
+
   size_t raw_seq_idx(const KMerRawReference data) const {
     size_t bucket = raw_seq_bucket(data);
     size_t idx = index_[bucket].lookup(data);
@@ -42,6 +42,9 @@
 #include <vector>
 #include <cmath>
 
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace kmers {
 
 // TODO: Make interface
@@ -248,15 +251,7 @@ public:
 
     INFO("Starting k-mer counting.");
     KMerDiskStorage<Seq> res(work_dir_, this->k(), splitter_->bucket_policy());
-    size_t kmers = 0;
-    {
-        TIME_TRACE_SCOPE("KMerDiskCounter::Count");
-#       pragma omp parallel for shared(raw_kmers) num_threads(num_threads) schedule(dynamic) reduction(+:kmers)
-        for (size_t i = 0; i < raw_kmers.size(); ++i) {
-          kmers += MergeKMers(*raw_kmers[i], *res.create(i));
-          raw_kmers[i].reset();
-        }
-    }
+    size_t kmers = MergeRawKMers(raw_kmers, res, num_threads);
     INFO("K-mer counting done. There are " << kmers << " kmers in total. ");
     if (!kmers) {
       FATAL_ERROR("No kmers were extracted from reads. Check the read lengths and k-mer length settings");
@@ -274,45 +269,152 @@ public:
     return storage;
   }
 
-private:
+protected:
   std::unique_ptr<kmers::KMerSplitter<Seq>> splitter_;
   fs::TmpDir work_dir_;
 
-  size_t MergeKMers(const std::string &ifname, const std::string &ofname) {
-    MMappedRecordArrayReader<typename Seq::DataType> ins(ifname, Seq::GetDataSize(this->k()), /* unlink */ true);
+  // Merges the sorted runs of the raw k-mer files. Large buckets are cut into
+  // several parts, so the parts of all the buckets are merged in parallel and
+  // a single huge bucket does not serialize the whole stage.
+  size_t MergeRawKMers(typename KMerSplitter<Seq>::RawKMers &raw_kmers,
+                       KMerDiskStorage<Seq> &res, unsigned num_threads) {
+    TIME_TRACE_SCOPE("KMerDiskCounter::Count");
 
-    std::string IdxFileName = ifname + ".idx";
-    if (FILE *f = fopen(IdxFileName.c_str(), "rb")) {
-      fclose(f);
-      MMappedRecordReader<size_t> index(ifname + ".idx", true, -1ULL);
+    size_t total_size = 0;
+    for (const auto &raw : raw_kmers)
+      total_size += fs::filesize(*raw) / kmer_size();
+    size_t part_size = std::max(total_size / (4 * num_threads + 1), size_t(MIN_PART_SIZE));
+
+    size_t kmers = 0;
+    std::vector<std::unique_ptr<BucketMerger>> mergers(raw_kmers.size());
+#   pragma omp parallel for shared(raw_kmers) num_threads(num_threads) schedule(dynamic) reduction(+:kmers)
+    for (size_t i = 0; i < raw_kmers.size(); ++i) {
+      const std::string &ifname = *raw_kmers[i];
+      if (fs::check_existence(ifname + ".idx")) {
+        size_t parts = (fs::filesize(ifname) / kmer_size() + part_size - 1) / part_size;
+        mergers[i].reset(new BucketMerger(ifname, *res.create(i), this->k(), parts));
+      } else {
+        kmers += SortKMers(ifname, *res.create(i));
+        raw_kmers[i].reset();
+      }
+    }
 
-      // INFO("Total runs: " << index.size());
+    std::vector<std::pair<size_t, size_t>> parts;
+    for (size_t i = 0; i < mergers.size(); ++i) {
+      if (!mergers[i])
+        continue;
+      for (size_t j = 0; j < mergers[i]->num_parts(); ++j)
+        parts.emplace_back(i, j);
+    }
+
+#   pragma omp parallel for num_threads(num_threads) schedule(dynamic)
+    for (size_t i = 0; i < parts.size(); ++i)
+      mergers[parts[i].first]->MergePart(parts[i].second);
+
+#   pragma omp parallel for shared(raw_kmers) num_threads(num_threads) schedule(dynamic) reduction(+:kmers)
+    for (size_t i = 0; i < mergers.size(); ++i) {
+      if (!mergers[i])
+        continue;
+      kmers += mergers[i]->Finish();
+      mergers[i].reset();
+      raw_kmers[i].reset();
+    }
+
+    return kmers;
+  }
+
+private:
+  static constexpr size_t MIN_PART_SIZE = 1024 * 1024;
+
+  // Sorted runs of a single bucket cut at common pivots into independent
+  // parts. Each part is merged into its own region of the output file which is
+  // sized to the total number of input k-mers, the gaps left by the duplicates
+  // are squeezed out in the end.
+  class BucketMerger {
+    typedef typename Seq::DataType ElTy;
+    typedef MMappedRecordArrayReader<ElTy> RunStorage;
+    typedef typename RunStorage::iterator iterator;
+
+   public:
+    BucketMerger(const std::string &ifname, const std::string &ofname,
+                 unsigned k, size_t parts)
+        : ofname_(ofname), k_(k), el_bytes_(Seq::GetDataSize(k) * sizeof(ElTy)),
+          ins_(ifname, Seq::GetDataSize(k), /* unlink */ true) {
+      MMappedRecordReader<size_t> index(ifname + ".idx", true, -1ULL);
 
       // Prepare runs
-      std::vector<adt::iterator_range<decltype(ins.begin())>> ranges;
-      auto beg = ins.begin();
+      std::vector<adt::iterator_range<iterator>> runs;
+      auto beg = ins_.begin();
       for (size_t sz : index) {
         auto end = std::next(beg, sz);
-        ranges.push_back(adt::make_range(beg, end));
-        VERIFY(std::is_sorted(beg, end, adt::array_less<typename Seq::DataType>()));
+        runs.push_back(adt::make_range(beg, end));
+        VERIFY(std::is_sorted(beg, end, adt::array_less<ElTy>()));
         beg = end;
       }
 
-      // Construct tree on top entries of runs
-      adt::loser_tree<decltype(beg),
-              adt::array_less<typename Seq::DataType>> tree(ranges);
-
-      if (tree.empty()) {
-        FILE *g = fopen(ofname.c_str(), "ab");
-        if (!g)
-          FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
-        fclose(g);
-        return 0;
+      // Select the pivots from the sample of all runs. All the copies of the
+      // k-mer fall into the same part, so parts could be deduplicated
+      // independently.
+      adt::KMerVector<Seq> pivots(k_);
+      parts = std::max<size_t>(std::min(parts, ins_.size() / MIN_PART_SIZE), 1);
+      if (parts > 1) {
+        size_t step = std::max<size_t>(ins_.size() / (64 * parts), 1);
+        adt::KMerVector<Seq> sample(k_, ins_.size() / step + runs.size());
+        for (const auto &run : runs)
+          for (size_t i = 0; i < size_t(run.end() - run.begin()); i += step)
+            sample.push_back(run.begin()[i]);
+        libcxx::sort(sample.begin(), sample.end(), adt::array_less<ElTy>());
+
+        for (size_t i = 1; i < parts; ++i) {
+          auto pivot = sample.begin()[i * sample.size() / parts];
+          if (pivots.size() && adt::array_equal_to<ElTy>()(pivots.back(), pivot))
+            continue;
+          pivots.push_back(pivot);
+        }
+      }
+
+      parts_.resize(pivots.size() + 1);
+      for (const auto &run : runs) {
+        auto cur = run.begin();
+        for (size_t i = 0; i < pivots.size(); ++i) {
+          auto next = std::lower_bound(cur, run.end(), pivots.begin()[i], adt::array_less<ElTy>());
+          parts_[i].runs.push_back(adt::make_range(cur, next));
+          cur = next;
+        }
+        parts_.back().runs.push_back(adt::make_range(cur, run.end()));
+      }
+
+      size_t offset = 0;
+      for (auto &part : parts_) {
+        part.offset = offset;
+        for (const auto &run : part.runs)
+          offset += run.end() - run.begin();
       }
 
+      fd_ = ::open(ofname_.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if (fd_ < 0)
+        FATAL_ERROR("Cannot open temporary file " << ofname_ << " for writing");
+      if (::ftruncate(fd_, off_t(ins_.size() * el_bytes_)) != 0)
+        FATAL_ERROR("I/O error! Cannot preallocate " << ofname_ << ". Reason: " << strerror(errno) << ". Error code: " << errno);
+    }
+
+    ~BucketMerger() {
+      if (fd_ >= 0)
+        ::close(fd_);
+    }
+
+    size_t num_parts() const { return parts_.size(); }
+
+    void MergePart(size_t idx) {
+      Part &part = parts_[idx];
+      if (part.runs.empty())
+        return;
+
+      // Construct tree on top entries of runs
+      adt::loser_tree<iterator, adt::array_less<ElTy>> tree(part.runs);
+
       // Write it down!
-      adt::KMerVector<Seq> buf(this->k(), 1024*1024);
-      size_t total = 0;
+      adt::KMerVector<Seq> buf(k_, 1024*1024);
       while (!tree.empty()) {
           buf.clear();
           buf.push_back(tree.pop());
@@ -320,7 +422,7 @@ private:
 
           while (cnt < buf.capacity()) {
             while (!tree.empty() &&
-                   adt::array_equal_to<typename Seq::DataType>()(buf.back(), tree.top()))
+                   adt::array_equal_to<ElTy>()(buf.back(), tree.top()))
               tree.replay();
 
             if (tree.empty())
@@ -333,38 +435,178 @@ private:
 
           // Handle the last value
           while (!tree.empty() &&
-                 adt::array_equal_to<typename Seq::DataType>()(buf.back(), tree.top()))
+                 adt::array_equal_to<ElTy>()(buf.back(), tree.top()))
             tree.replay();
 
-          total += buf.size();
+          Write(buf.data(), buf.size(), part.offset + part.written);
+          part.written += buf.size();
+      }
+    }
 
-          FILE *g = fopen(ofname.c_str(), "ab");
-          if (!g)
-            FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
-          size_t res = fwrite(buf.data(), buf.el_data_size(), buf.size(), g);
-          if (res != buf.size())
-            FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-          fclose(g);
+    size_t Finish() {
+      size_t total = 0;
+      std::vector<char> buf(8 * 1024 * 1024 / el_bytes_ * el_bytes_);
+      for (const auto &part : parts_) {
+        // Move the part down. Source is never before the destination, so the
+        // chunks could be copied in forward order.
+        for (size_t pos = 0; part.offset != total && pos < part.written; ) {
+          size_t cnt = std::min(part.written - pos, buf.size() / el_bytes_);
+          Read(buf.data(), cnt, part.offset + pos);
+          Write(buf.data(), cnt, total + pos);
+          pos += cnt;
+        }
+        total += part.written;
       }
 
+      if (::ftruncate(fd_, off_t(total * el_bytes_)) != 0)
+        FATAL_ERROR("I/O error! Cannot truncate " << ofname_ << ". Reason: " << strerror(errno) << ". Error code: " << errno);
+      ::close(fd_);
+      fd_ = -1;
+
       return total;
-    } else {
-      // Sort the stuff
-      libcxx::sort(ins.begin(), ins.end(), adt::array_less<typename Seq::DataType>());
+    }
 
-      // FIXME: Use something like parallel version of unique_copy but with explicit
-      // resizing.
-      auto it = std::unique(ins.begin(), ins.end(), adt::array_equal_to<typename Seq::DataType>());
+   private:
+    struct Part {
+      std::vector<adt::iterator_range<iterator>> runs;
+      size_t offset = 0;
+      size_t written = 0;
+    };
+
+    void Write(const void *data, size_t cnt, size_t pos) {
+      const char *ptr = static_cast<const char*>(data);
+      size_t bytes = cnt * el_bytes_;
+      off_t off = off_t(pos * el_bytes_);
+      while (bytes) {
+        ssize_t res = ::pwrite(fd_, ptr, bytes, off);
+        if (res < 0 && errno == EINTR)
+          continue;
+        if (res <= 0)
+          FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+        ptr += res; bytes -= size_t(res); off += res;
+      }
+    }
+
+    void Read(void *data, size_t cnt, size_t pos) {
+      char *ptr = static_cast<char*>(data);
+      size_t bytes = cnt * el_bytes_;
+      off_t off = off_t(pos * el_bytes_);
+      while (bytes) {
+        ssize_t res = ::pread(fd_, ptr, bytes, off);
+        if (res < 0 && errno == EINTR)
+          continue;
+        if (res <= 0)
+          FATAL_ERROR("I/O error! Incomplete read! Reason: " << strerror(errno) << ". Error code: " << errno);
+        ptr += res; bytes -= size_t(res); off += res;
+      }
+    }
+
+    std::string ofname_;
+    unsigned k_;
+    size_t el_bytes_;
+    RunStorage ins_;
+    std::vector<Part> parts_;
+    int fd_ = -1;
+  };
+
+  size_t SortKMers(const std::string &ifname, const std::string &ofname) {
+    MMappedRecordArrayReader<typename Seq::DataType> ins(ifname, Seq::GetDataSize(this->k()), /* unlink */ true);
+
+    // Sort the stuff
+    libcxx::sort(ins.begin(), ins.end(), adt::array_less<typename Seq::DataType>());
 
-      MMappedRecordArrayWriter<typename Seq::DataType> os(ofname, Seq::GetDataSize(this->k()));
-      os.resize(it - ins.begin());
-      std::copy(ins.begin(), it, os.begin());
+    // FIXME: Use something like parallel version of unique_copy but with explicit
+    // resizing.
+    auto it = std::unique(ins.begin(), ins.end(), adt::array_equal_to<typename Seq::DataType>());
+
+    MMappedRecordArrayWriter<typename Seq::DataType> os(ofname, Seq::GetDataSize(this->k()));
+    os.resize(it - ins.begin());
+    std::copy(ins.begin(), it, os.begin());
+
+    return it - ins.begin();
+  }
+};
+
+// Counts k-mers keeping the sorted buckets produced by the splitter in memory,
+// so the raw k-mer spill and the subsequent merge of the runs are avoided. Only
+// the final deduplicated buckets are written, in KMerDiskStorage format. If the
+// buckets do not fit into the memory budget, the splitter spills them and the
+// counting proceeds exactly as in KMerDiskCounter.
+template<class Seq, class traits = kmer_index_traits<Seq> >
+class KMerMemoryCounter : public KMerDiskCounter<Seq, traits> {
+  typedef KMerDiskCounter<Seq, traits> __super;
+public:
+  template<class Splitter>
+  KMerMemoryCounter(fs::TmpDir work_dir,
+                    Splitter splitter, size_t memory_budget = 0)
+      : __super(work_dir, std::move(splitter)), memory_budget_(memory_budget) {
+    static_assert(std::is_base_of<KMerSortingSplitter<Seq>, Splitter>::value,
+                  "in-memory counting requires sorting splitter");
+  }
+
+  template<class Splitter>
+  KMerMemoryCounter(const std::string &work_dir,
+                    Splitter splitter, size_t memory_budget = 0)
+      : KMerMemoryCounter(fs::tmp::make_temp_dir(work_dir, "kmer_counter"), std::move(splitter), memory_budget) {}
 
-      return it - ins.begin();
+  KMerDiskStorage<Seq> Count(unsigned num_buckets, unsigned num_threads) override {
+    auto &splitter = static_cast<KMerSortingSplitter<Seq>&>(*this->splitter_);
+    splitter.keep_in_memory(memory_budget_ ? memory_budget_ : utils::get_free_memory() / 3);
+
+    INFO("Splitting kmer instances into " << num_buckets << " buckets using " << num_threads << " threads. This might take a while.");
+    TIME_TRACE_BEGIN("KMerMemoryCounter::Split");
+    auto raw_kmers = splitter.Split(num_buckets, num_threads);
+    VERIFY(raw_kmers.size() == num_buckets);
+    TIME_TRACE_END;
+
+    KMerDiskStorage<Seq> res(this->work_dir_, this->k(), splitter.bucket_policy());
+    size_t kmers = 0;
+    if (splitter.in_memory()) {
+      INFO("Storing k-mer buckets.");
+      TIME_TRACE_SCOPE("KMerMemoryCounter::Store");
+#     pragma omp parallel for num_threads(num_threads) schedule(dynamic) reduction(+:kmers)
+      for (size_t i = 0; i < raw_kmers.size(); ++i) {
+        kmers += StoreBucket(splitter.MergeMemoryBucket(i), *res.create(i));
+      }
+    } else {
+      INFO("K-mer buckets did not fit into memory, starting k-mer counting on disk.");
+      kmers = this->MergeRawKMers(raw_kmers, res, num_threads);
+    }
+
+    INFO("K-mer counting done. There are " << kmers << " kmers in total. ");
+    if (!kmers) {
+      FATAL_ERROR("No kmers were extracted from reads. Check the read lengths and k-mer length settings");
+      exit(-1);
     }
+
+    return res;
+  }
+
+private:
+  size_t memory_budget_;
+
+  size_t StoreBucket(const adt::KMerVector<Seq> &bucket, const std::string &ofname) const {
+    FILE *g = fopen(ofname.c_str(), "wb");
+    if (!g)
+      FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
+    size_t res = fwrite(bucket.data(), bucket.el_data_size(), bucket.size(), g);
+    if (res != bucket.size())
+      FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+    fclose(g);
+
+    return bucket.size();
   }
 };
 
+template<class Seq, class Splitter>
+std::unique_ptr<KMerCounter<Seq>> make_kmer_counter(fs::TmpDir work_dir, Splitter splitter,
+                                                    bool in_memory) {
+  if (in_memory)
+    return std::make_unique<KMerMemoryCounter<Seq>>(work_dir, std::move(splitter));
+
+  return std::make_unique<KMerDiskCounter<Seq>>(work_dir, std::move(splitter));
+}
+
 template<class Index>
 class KMerIndexBuilder {
   typedef typename Index::KMerSeq Seq;
@@ -9,6 +9,7 @@
 #include "kmer_buckets.hpp"
 
 #include "adt/kmer_vector.hpp"
+#include "adt/loser_tree.hpp"
 #include "utils/filesystem/file_limit.hpp"
 #include "utils/filesystem/temporary.hpp"
 #include "utils/memory_limit.hpp"
@@ -62,14 +63,41 @@ public:
     KMerSortingSplitter(fs::TmpDir work_dir, unsigned K)
             : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0) {}
 
-protected:
     using SeqKMerVector = adt::KMerVector<Seq>;
+
+    // Keep sorted and deduplicated runs in memory instead of spilling them to
+    // raw k-mer files. Once the runs outgrow the memory budget they are dumped
+    // to disk and the splitter proceeds as usual.
+    void keep_in_memory(size_t memory_budget) {
+        in_memory_ = true;
+        memory_budget_ = memory_budget;
+    }
+
+    bool in_memory() const { return in_memory_; }
+
+    // Merges the in-memory runs of the bucket into the final sorted unique
+    // bucket and releases them
+    SeqKMerVector MergeMemoryBucket(size_t idx) {
+        VERIFY(in_memory_);
+        MemoryRuns &runs = memory_runs_.at(idx);
+        SeqKMerVector res = (runs.size() == 1 ? std::move(runs.front()) : MergeRuns(runs.begin(), runs.end()));
+        runs.clear();
+        runs.shrink_to_fit();
+        return res;
+    }
+
+protected:
     using KMerBuffer = std::vector<SeqKMerVector>;
+    using MemoryRuns = std::vector<SeqKMerVector>;
 
     std::vector<KMerBuffer> kmer_buffers_;
     size_t cell_size_;
     size_t num_files_;
 
+    bool in_memory_ = false;
+    size_t memory_budget_ = 0;
+    std::vector<MemoryRuns> memory_runs_;
+
     RawKMers PrepareBuffers(size_t num_files, unsigned nthreads, size_t reads_buffer_size) {
         num_files_ = num_files;
         this->bucket_.reset(num_files);
@@ -105,6 +133,12 @@ protected:
             entry.resize(num_files_, adt::KMerVector<Seq>(this->K_, (size_t) (1.1 * (double) cell_size_)));
         }
 
+        if (in_memory_) {
+            INFO("Keeping k-mer buckets in memory, budget " << (double)memory_budget_ / 1024.0 / 1024.0 / 1024.0 << " Gb");
+            memory_runs_.clear();
+            memory_runs_.resize(num_files_);
+        }
+
         return out;
     }
 
@@ -120,7 +154,8 @@ protected:
     void DumpBuffers(const RawKMers &ostreams) {
         VERIFY(ostreams.size() == num_files_ && kmer_buffers_[0].size() == num_files_);
 
-#   pragma omp parallel for
+        size_t memory_size = 0;
+#   pragma omp parallel for reduction(+ : memory_size)
         for (size_t k = 0; k < num_files_; ++k) {
             // Below k is thread id!
 
@@ -136,34 +171,41 @@ protected:
             }
             libcxx::sort(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::less2_fast());
             auto it = std::unique(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::equal_to());
+            size_t cnt =  it - SortBuffer.begin();
+
+            if (in_memory_) {
+                SortBuffer.shrink(cnt);
+                AddMemoryRun(memory_runs_[k], std::move(SortBuffer));
+                for (const auto &run : memory_runs_[k])
+                    memory_size += run.capacity() * run.el_data_size();
+                continue;
+            }
 
 #     pragma omp critical
             {
-                size_t cnt =  it - SortBuffer.begin();
-
-                // Write k-mers
-                FILE *f = fopen(ostreams[k]->file().c_str(), "ab");
-                if (!f)
-                    FATAL_ERROR("Cannot open temporary file " << ostreams[k]->file() << " for writing");
-                size_t res = fwrite(SortBuffer.data(), SortBuffer.el_data_size(), cnt, f);
-                if (res != cnt)
-                    FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-                fclose(f);
-
-                // Write index
-                f = fopen((ostreams[k]->file() + ".idx").c_str(), "ab");
-                if (!f)
-                    FATAL_ERROR("Cannot open temporary file " << ostreams[k]->file() << " for writing");
-                res = fwrite(&cnt, sizeof(cnt), 1, f);
-                if (res != 1)
-                    FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
-                fclose(f);
+                WriteRun(*ostreams[k], SortBuffer.data(), SortBuffer.el_data_size(), cnt);
             }
         }
 
         for (auto & entry : kmer_buffers_)
             for (auto & eentry : entry)
                 eentry.clear();
+
+        if (in_memory_ && memory_size > memory_budget_) {
+            INFO("In-memory k-mer runs occupy " << (double)memory_size / 1024.0 / 1024.0 / 1024.0 << " Gb, spilling them to disk");
+            SpillMemoryBuckets(ostreams);
+        }
+    }
+
+    void SpillMemoryBuckets(const RawKMers &ostreams) {
+        VERIFY(in_memory_);
+        for (size_t k = 0; k < num_files_; ++k)
+            for (const auto &run : memory_runs_[k])
+                WriteRun(*ostreams[k], run.data(), run.el_data_size(), run.size());
+
+        memory_runs_.clear();
+        memory_runs_.shrink_to_fit();
+        in_memory_ = false;
     }
 
     void ClearBuffers() {
@@ -173,6 +215,70 @@ protected:
                 eentry.shrink_to_fit();
             }
     }
+
+private:
+    // Keeps the run sizes decreasing geometrically, so each k-mer takes part
+    // in a logarithmic number of merges only, while the duplicates between the
+    // runs are still dropped early
+    void AddMemoryRun(MemoryRuns &runs, SeqKMerVector run) const {
+        if (run.size() == 0)
+            return;
+
+        run.shrink_to_fit();
+        runs.push_back(std::move(run));
+        while (runs.size() > 1 && 2 * runs.back().size() >= runs[runs.size() - 2].size()) {
+            SeqKMerVector merged = MergeRuns(runs.end() - 2, runs.end());
+            runs.pop_back();
+            runs.back().swap(merged);
+        }
+    }
+
+    // Merges the sorted unique runs into the single sorted unique one
+    SeqKMerVector MergeRuns(typename MemoryRuns::iterator begin, typename MemoryRuns::iterator end) const {
+        typedef typename SeqKMerVector::iterator iterator;
+
+        size_t total = 0;
+        std::vector<adt::iterator_range<iterator>> ranges;
+        for (auto run = begin; run != end; ++run) {
+            ranges.push_back(adt::make_range(run->begin(), run->end()));
+            total += run->size();
+        }
+
+        SeqKMerVector merged(this->K_, total);
+        if (ranges.empty())
+            return merged;
+
+        typename SeqKMerVector::equal_to equal;
+        adt::loser_tree<iterator, typename SeqKMerVector::less2_fast> tree(ranges);
+        for (; !tree.empty(); tree.replay()) {
+            if (merged.size() == 0 || !equal(merged.back(), tree.top()))
+                merged.push_back(tree.top());
+        }
+        merged.shrink_to_fit();
+
+        return merged;
+    }
+
+    static void WriteRun(const std::string &fname, const typename Seq::DataType *data,
+                         size_t el_data_size, size_t cnt) {
+        // Write k-mers
+        FILE *f = fopen(fname.c_str(), "ab");
+        if (!f)
+            FATAL_ERROR("Cannot open temporary file " << fname << " for writing");
+        size_t res = fwrite(data, el_data_size, cnt, f);
+        if (res != cnt)
+            FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+        fclose(f);
+
+        // Write index
+        f = fopen((fname + ".idx").c_str(), "ab");
+        if (!f)
+            FATAL_ERROR("Cannot open temporary file " << fname << " for writing");
+        res = fwrite(&cnt, sizeof(cnt), 1, f);
+        if (res != 1)
+            FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+        fclose(f);
+    }
 };
 
 }
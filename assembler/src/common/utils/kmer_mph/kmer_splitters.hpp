@@ -8,6 +8,7 @@
 #pragma once
 
 #include "kmer_splitter.hpp"
+#include "sequence/canonical_kmer_roller.hpp"
 #include "io/reads/io_helper.hpp"
 #include "adt/iterator_range.hpp"
 
@@ -27,14 +28,14 @@ class DeBruijnKMerSplitter : public RtSeqKMerSplitter {
       if (seq.size() < this->K_)
         return false;
 
-      RtSeq kmer = seq.start<RtSeq>(this->K_) >> 'A';
+      CanonicalKMerRoller<RtSeq> kmer(seq.start<RtSeq>(this->K_) >> 'A');
       bool stop = false;
       for (size_t j = this->K_ - 1; j < seq.size(); ++j) {
         kmer <<= seq[j];
         if (!kmer_filter_.filter(kmer))
           continue;
 
-        stop |= this->push_back_internal(kmer, thread_id);
+        stop |= this->push_back_internal(kmer.forward(), thread_id);
       }
 
       return stop;
@@ -45,14 +46,14 @@ class DeBruijnKMerSplitter : public RtSeqKMerSplitter {
       if (seq.size() < this->K_)
         return false;
 
-      RtSeq kmer = seq.start(this->K_) >> 'A';
+      CanonicalKMerRoller<RtSeq> kmer(seq.start(this->K_) >> 'A');
       bool stop = false;
       for (size_t j = this->K_ - 1; j < seq.size(); ++j) {
         kmer <<= seq[j];
         if (!kmer_filter_.filter(kmer))
           continue;
 
-        stop |= this->push_back_internal(kmer, thread_id);
+        stop |= this->push_back_internal(kmer.forward(), thread_id);
       }
 
       return stop;
@@ -0,0 +1,149 @@
+//***************************************************************************
+//* Copyright (c) 2015 Saint Petersburg State University
+//* Copyright (c) 2011-2014 Saint Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "io/reads/mpmc_bounded.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/verify.hpp"
+
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace utils {
+
+/**
+ * Three-stage pipeline: the master thread produces items, all the threads
+ * (master included, when it has to wait) process them and a separate thread
+ * consumes them. Items are processed out of order and put back into the
+ * production order before being consumed.
+ *
+ * At most max_inflight items are kept in memory: the producer waits for the
+ * consumer when it runs too far ahead.
+ */
+template<class T>
+class OrderedPipeline {
+    typedef std::unique_ptr<T> ItemPtr;
+
+    struct Task {
+        size_t no;
+        ItemPtr item;
+    };
+
+public:
+    OrderedPipeline(unsigned nthreads, size_t max_inflight)
+            : nthreads_(std::max(nthreads, 1u)), max_inflight_(std::max<size_t>(max_inflight, 1)) {}
+
+    /**
+     * produce(T&) fills the next item and returns false when there is none.
+     * process(T&) is called inside the OpenMP parallel region, so
+     * omp_get_thread_num() could be used to pick per-thread state.
+     * consume(T&) is called from a single thread, in the production order.
+     */
+    template<class Produce, class Process, class Consume>
+    void Run(Produce produce, Process process, Consume consume) {
+        // No more than max_inflight items are ever queued, twice as large
+        // queues are never found full because of a lagging dequeue
+        size_t queue_size = 2;
+        while (queue_size < 2 * max_inflight_)
+            queue_size <<= 1;
+        mpmc_bounded_queue<Task> in_queue(queue_size), out_queue(queue_size);
+
+        std::mutex inflight_lock;
+        std::condition_variable consumed;
+        size_t inflight = 0;
+
+        auto process_task = [&](Task task) {
+            process(*task.item);
+            bool res = out_queue.wait_enqueue(std::move(task));
+            VERIFY(res);
+        };
+        // Lets the master process some items instead of just waiting
+        auto process_queued = [&]() {
+            Task task;
+            if (!in_queue.dequeue(task))
+                return false;
+            process_task(std::move(task));
+            return true;
+        };
+
+        std::thread consumer([&]() {
+            std::map<size_t, ItemPtr> pending;
+            size_t next = 0;
+            auto flush = [&](Task task) {
+                pending.emplace(task.no, std::move(task.item));
+                for (auto it = pending.find(next); it != pending.end(); it = pending.find(++next)) {
+                    consume(*it->second);
+                    pending.erase(it);
+                    {
+                        std::lock_guard<std::mutex> guard(inflight_lock);
+                        inflight -= 1;
+                    }
+                    consumed.notify_one();
+                }
+            };
+
+            Task task;
+            while (out_queue.wait_dequeue(task))
+                flush(std::move(task));
+            // The queue might have been closed right after the last item came in
+            while (out_queue.dequeue(task))
+                flush(std::move(task));
+            VERIFY(pending.empty());
+        });
+
+#       pragma omp parallel num_threads(nthreads_)
+        {
+#           pragma omp master
+            {
+                for (size_t no = 0; ; ++no) {
+                    // Do not run too far ahead of the consumer
+                    while (true) {
+                        std::unique_lock<std::mutex> lock(inflight_lock);
+                        if (inflight < max_inflight_)
+                            break;
+                        lock.unlock();
+                        if (process_queued())
+                            continue;
+                        // Everything is being processed by the others or waits to be consumed
+                        lock.lock();
+                        consumed.wait(lock, [&]() { return inflight < max_inflight_; });
+                    }
+
+                    ItemPtr item(new T());
+                    if (!produce(*item))
+                        break;
+
+                    {
+                        std::lock_guard<std::mutex> guard(inflight_lock);
+                        inflight += 1;
+                    }
+                    bool res = in_queue.wait_enqueue(Task{ no, std::move(item) });
+                    VERIFY(res);
+                }
+
+                in_queue.close();
+            }
+
+            Task task;
+            while (in_queue.wait_dequeue(task))
+                process_task(std::move(task));
+        }
+
+        out_queue.close();
+        consumer.join();
+    }
+
+private:
+    unsigned nthreads_;
+    size_t max_inflight_;
+};
+
+}
@@ -8,6 +8,7 @@
 #pragma once
 
 #include "storing_traits.hpp"
+#include "sequence/canonical_kmer_roller.hpp"
 
 namespace utils {
 
@@ -36,6 +37,37 @@ public:
     SimpleKeyWithHash(Key key, const HashFunction &hash)
             : hash_(hash), key_(key), idx_(0), ready_(false) {}
 
+    SimpleKeyWithHash(const CanonicalKMerRoller<Key> &kmer, const HashFunction &hash)
+            : SimpleKeyWithHash(kmer.forward(), hash) {}
+
+    // Constructs keys with hashes for n keys, looking them up in a batch
+    template<class Container>
+    static void Construct(const Key *keys, size_t n, const HashFunction &hash, Container &res) {
+        constexpr size_t BATCH = 16;
+        IdxType idx[BATCH];
+        for (size_t start = 0; start < n; start += BATCH) {
+            size_t cnt = std::min(BATCH, n - start);
+            hash.seq_idx(keys + start, cnt, idx);
+            for (size_t i = 0; i < cnt; ++i) {
+                res.emplace_back(keys[start + i], hash);
+                res.back().idx_ = idx[i];
+                res.back().ready_ = true;
+            }
+        }
+    }
+
+    template<class Container>
+    static void Construct(const CanonicalKMerRoller<Key> *kmers, size_t n, const HashFunction &hash, Container &res) {
+        constexpr size_t BATCH = 16;
+        Key keys[BATCH];
+        for (size_t start = 0; start < n; start += BATCH) {
+            size_t cnt = std::min(BATCH, n - start);
+            for (size_t i = 0; i < cnt; ++i)
+                keys[i] = kmers[start + i].forward();
+            Construct(keys, cnt, hash, res);
+        }
+    }
+
     Key key() const {
         return key_;
     }
@@ -136,6 +168,48 @@ private:
     InvertableKeyWithHash(Key key, const HashFunction &hash)
             : hash_(hash), key_(key), idx_(0), is_minimal_(false), ready_(false) {}
 
+    // The canonical k-mer is already at hand, so the index is computed right away
+    InvertableKeyWithHash(const CanonicalKMerRoller<Key> &kmer, const HashFunction &hash)
+            : InvertableKeyWithHash(kmer.forward(), hash, kmer.IsMinimal(),
+                                    hash.seq_idx(kmer.canonical()), true) {}
+
+    // Constructs keys with hashes for n keys, looking them up in a batch
+    template<class Container>
+    static void Construct(const Key *keys, size_t n, const HashFunction &hash, Container &res) {
+        constexpr size_t BATCH = 16;
+        Key canonical[BATCH];
+        bool is_minimal[BATCH];
+        IdxType idx[BATCH];
+        for (size_t start = 0; start < n; start += BATCH) {
+            size_t cnt = std::min(BATCH, n - start);
+            for (size_t i = 0; i < cnt; ++i) {
+                is_minimal[i] = keys[start + i].IsMinimal();
+                canonical[i] = is_minimal[i] ? keys[start + i] : !keys[start + i];
+            }
+            hash.seq_idx(canonical, cnt, idx);
+            for (size_t i = 0; i < cnt; ++i)
+                res.push_back(InvertableKeyWithHash(keys[start + i], hash, is_minimal[i], idx[i], true));
+        }
+    }
+
+    template<class Container>
+    static void Construct(const CanonicalKMerRoller<Key> *kmers, size_t n, const HashFunction &hash, Container &res) {
+        constexpr size_t BATCH = 16;
+        Key canonical[BATCH];
+        bool is_minimal[BATCH];
+        IdxType idx[BATCH];
+        for (size_t start = 0; start < n; start += BATCH) {
+            size_t cnt = std::min(BATCH, n - start);
+            for (size_t i = 0; i < cnt; ++i) {
+                is_minimal[i] = kmers[start + i].IsMinimal();
+                canonical[i] = is_minimal[i] ? kmers[start + i].forward() : kmers[start + i].reverse_complement();
+            }
+            hash.seq_idx(canonical, cnt, idx);
+            for (size_t i = 0; i < cnt; ++i)
+                res.push_back(InvertableKeyWithHash(kmers[start + i].forward(), hash, is_minimal[i], idx[i], true));
+        }
+    }
+
     const Key &key() const {
         return key_;
     }
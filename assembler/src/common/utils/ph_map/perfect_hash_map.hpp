@@ -99,6 +99,22 @@ public:
         return KeyWithHash(key, *index_ptr_);
     }
 
+    KeyWithHash ConstructKWH(const CanonicalKMerRoller<KeyType> &kmer) const {
+        return KeyWithHash(kmer, *index_ptr_);
+    }
+
+    // Batched construction: the MPHF is queried for all the keys at once and
+    // the value slots are prefetched. Res could be any vector-like container.
+    template<class Key, class Res>
+    void ConstructKWH(const Key *keys, size_t n, Res &res) const {
+        res.clear();
+        KeyWithHash::Construct(keys, n, *index_ptr_, res);
+        for (const auto &kwh : res) {
+            if (valid(kwh))
+                __builtin_prefetch(&data_[kwh.idx()]);
+        }
+    }
+
     bool valid(const KeyWithHash &kwh) const {
         return KeyBase::valid(kwh.idx());
     }
@@ -151,6 +167,8 @@ public:
         return data_.size();
     }
 
+    auto value_begin() { return data_.begin(); }
+    auto value_end() { return data_.end(); }
     auto value_begin() const { return data_.begin(); }
     auto value_cbegin() const { return data_.cbegin(); }
     auto value_end() const { return data_.end(); }
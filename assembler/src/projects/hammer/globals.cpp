@@ -0,0 +1,31 @@
+//***************************************************************************
+//* Copyright (c) 2015 Saint Petersburg State University
+//* Copyright (c) 2011-2014 Saint Petersburg Academic University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "globals.hpp"
+
+#include <cmath>
+
+std::vector<uint32_t> * Globals::subKMerPositions = NULL;
+KMerData *Globals::kmer_data = NULL;
+int Globals::iteration_no = 0;
+
+char Globals::char_offset = 0;
+bool Globals::char_offset_user = true;
+
+double Globals::quality_probs[256] = { 0 };
+double Globals::quality_lprobs[256] = { 0 };
+double Globals::quality_rprobs[256] = { 0 };
+double Globals::quality_lrprobs[256] = { 0 };
+
+void Globals::InitializeQualityProbs() {
+  for (unsigned qual = 0; qual < sizeof(quality_probs) / sizeof(quality_probs[0]); ++qual) {
+    quality_rprobs[qual] = (qual < 3 ? 0.75 : pow(10.0, -(int)qual / 10.0));
+    quality_probs[qual] = 1 - quality_rprobs[qual];
+    quality_lprobs[qual] = log(quality_probs[qual]);
+    quality_lrprobs[qual] = log(quality_rprobs[qual]);
+  }
+}
@@ -25,6 +25,9 @@ struct Globals {
   static double quality_lprobs[256];
   static double quality_rprobs[256];
   static double quality_lrprobs[256];
+
+  // Pre-cache the probabilities of the base being correct (wrong) for all the qualities
+  static void InitializeQualityProbs();
 };
 
 inline double getProb(const KMerStat &kmc, size_t i, bool log) {
@@ -14,6 +14,9 @@
 #include "config_struct_hammer.hpp"
 #include "globals.hpp"
 
+#include "utils/memory_limit.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
 #include <iostream>
 #include <sstream>
 #include <fstream>
@@ -109,9 +112,145 @@ static void processBlockQuadratic(dsu::ConcurrentDSU  &uf,
   }
 }
 
+// Sorts the sub-k-mers along with the k-mer indices and calls op for every
+// block of k-mers sharing the same sub-k-mer. Returns the number of blocks.
+template<class Op>
+static size_t processBlocks(std::vector<SubKMer> &subkmers, std::vector<size_t> &kmers,
+                            unsigned nthreads, Op &&op) {
+  using PairSort = parallel_radix_sort::PairSort<SubKMer, size_t, SubKMer, EncoderKMer>;
+  PairSort::InitAndSort(subkmers.data(), kmers.data(), subkmers.size(),
+                        nthreads > 1 && subkmers.size() > 1000*16 ? int(nthreads) : 1);
+
+  std::vector<size_t> starts;
+  for (size_t i = 0; i < subkmers.size(); ++i) {
+    if (i == 0 || subkmers[i] != subkmers[i - 1])
+      starts.push_back(i);
+  }
+  starts.push_back(subkmers.size());
+
+  // Blocks are very uneven in size, so they are handed out dynamically
+# pragma omp parallel for num_threads(nthreads) schedule(dynamic, 16)
+  for (size_t i = 0; i < starts.size() - 1; ++i)
+    op(kmers.begin() + starts[i], starts[i + 1] - starts[i]);
+
+  return starts.size() - 1;
+}
+
+void KMerHamClusterer::clusterInMemory(const KMerData &data,
+                                       dsu::ConcurrentDSU &uf) {
+  unsigned nthreads = cfg::get().general_max_nthreads;
+  unsigned block_thr = cfg::get().hamming_blocksize_quadratic_threshold;
+
+  // Blocks too large for the quadratic pass, stored one after another
+  std::vector<std::vector<size_t>> big_kmers(nthreads), big_starts(nthreads);
+  size_t big_blocks1 = 0;
+  {
+    INFO("Splitting sub-kmers in memory, pass 1.");
+    std::vector<SubKMer> subkmers(data.size());
+    std::vector<size_t> kmers(data.size());
+    size_t nblocks = 0;
+    for (unsigned i = 0; i < tau_ + 1; ++i) {
+      SubKMerPartSerializer serializer((*Globals::subKMerPositions)[i],
+                                       (*Globals::subKMerPositions)[i+1]);
+#     pragma omp parallel for num_threads(nthreads) schedule(static)
+      for (size_t j = 0; j < data.size(); ++j) {
+        kmers[j] = j;
+        subkmers[j] = serializer.serialize(data.kmer(j));
+      }
+
+      nblocks += processBlocks(subkmers, kmers, nthreads,
+                               [&] (const std::vector<size_t>::iterator &start, size_t sz) {
+        if (sz < block_thr) {
+          processBlockQuadratic(uf, start, sz, data, tau_);
+        } else {
+          auto &blocks = big_kmers[omp_get_thread_num()];
+          big_starts[omp_get_thread_num()].push_back(blocks.size());
+          blocks.insert(blocks.end(), start, start + sz);
+        }
+      });
+    }
+
+    for (const auto &starts : big_starts)
+      big_blocks1 += starts.size();
+    INFO("Splitting done. Produced " << nblocks << " blocks.");
+    INFO("Merge done, total " << big_blocks1 << " new blocks generated.");
+  }
+
+  size_t big_blocks2 = 0, nblocks = 0;
+  {
+    INFO("Splitting sub-kmers in memory, pass 2.");
+    std::vector<std::pair<size_t, size_t>> blocks;
+    blocks.reserve(big_blocks1);
+    for (size_t t = 0; t < nthreads; ++t) {
+      for (size_t i = 0; i < big_starts[t].size(); ++i)
+        blocks.emplace_back(t, i);
+    }
+
+    auto processBigBlock = [&](size_t idx, unsigned stride, unsigned threads) {
+      size_t t = blocks[idx].first, i = blocks[idx].second;
+      size_t start = big_starts[t][i],
+             end = (i + 1 < big_starts[t].size() ? big_starts[t][i + 1] : big_kmers[t].size());
+
+      std::vector<size_t> kmers(big_kmers[t].begin() + start, big_kmers[t].begin() + end);
+      std::vector<SubKMer> subkmers(kmers.size());
+      SubKMerStridedSerializer serializer(stride, tau_ + 1);
+      for (size_t j = 0; j < kmers.size(); ++j)
+        subkmers[j] = serializer.serialize(data.kmer(kmers[j]));
+
+      return processBlocks(subkmers, kmers, threads,
+                           [&] (const std::vector<size_t>::iterator &block, size_t sz) {
+        if (sz > 50) {
+#         pragma omp atomic
+          big_blocks2 += 1;
+        }
+        processBlockQuadratic(uf, block, sz, data, tau_);
+      });
+    };
+
+    // Huge blocks are processed one by one using all the threads, the rest of
+    // them are processed in parallel
+    const size_t huge_thr = 1000*16;
+    std::vector<size_t> small;
+    for (size_t idx = 0; idx < blocks.size(); ++idx) {
+      size_t t = blocks[idx].first, i = blocks[idx].second;
+      size_t sz = (i + 1 < big_starts[t].size() ? big_starts[t][i + 1] : big_kmers[t].size()) - big_starts[t][i];
+      if (sz <= huge_thr) {
+        small.push_back(idx);
+        continue;
+      }
+      for (unsigned stride = 0; stride < tau_ + 1; ++stride)
+        nblocks += processBigBlock(idx, stride, nthreads);
+    }
+
+#   pragma omp parallel for num_threads(nthreads) schedule(dynamic) reduction(+ : nblocks)
+    for (size_t i = 0; i < small.size() * (tau_ + 1); ++i)
+      nblocks += processBigBlock(small[i / (tau_ + 1)], unsigned(i % (tau_ + 1)), 1);
+
+    INFO("Splitting done."
+         " Processed " << (tau_ + 1) * big_blocks1 << " blocks."
+         " Produced " << nblocks << " blocks.");
+    INFO("Merge done, saw " << big_blocks2 << " big blocks out of " << nblocks << " processed.");
+  }
+}
+
 void KMerHamClusterer::cluster(const std::string &prefix,
                                const KMerData &data,
                                dsu::ConcurrentDSU &uf) {
+  // Sub-k-mers and k-mer indices of a single pass together with the radix
+  // sort buffers, and the indices of the k-mers in the big blocks
+  size_t needed = data.size() * (2 * (sizeof(SubKMer) + sizeof(size_t)) + (tau_ + 1) * sizeof(size_t));
+  if (needed < utils::get_free_memory()) {
+    clusterInMemory(data, uf);
+    return;
+  }
+
+  INFO("Not enough memory to cluster in memory, " << needed / 1024 / 1024 << " MB needed");
+  clusterOnDisk(prefix, data, uf);
+}
+
+void KMerHamClusterer::clusterOnDisk(const std::string &prefix,
+                                     const KMerData &data,
+                                     dsu::ConcurrentDSU &uf) {
   // First pass - split & sort the k-mers
   std::string fname = prefix + ".first", bfname = fname + ".blocks", kfname = fname + ".kmers";
   std::ofstream bfs(bfname, std::ios::out | std::ios::binary);
@@ -146,6 +146,11 @@ class KMerHamClusterer {
 
   void cluster(const std::string &prefix, const KMerData &data, dsu::ConcurrentDSU &uf);
  private:
+  // Sub-k-mers are kept in memory and the blocks are processed in parallel
+  void clusterInMemory(const KMerData &data, dsu::ConcurrentDSU &uf);
+  // Sub-k-mers are spilled to disk, used when they do not fit into memory
+  void clusterOnDisk(const std::string &prefix, const KMerData &data, dsu::ConcurrentDSU &uf);
+
   DECL_LOGGER("Hamming Clustering");
 };
 
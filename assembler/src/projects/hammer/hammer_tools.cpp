@@ -15,6 +15,8 @@
 #include "io/reads/ireadstream.hpp"
 #include "io/kmers/mmapped_writer.hpp"
 #include "utils/filesystem/path_helper.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/parallel/ordered_pipeline.hpp"
 
 #include <iostream>
 #include <fstream>
@@ -76,31 +78,68 @@ string getFilename( const string & dirprefix, int iter_count, const string & suf
   return tmp.str();
 }
 
-CorrectionStats CorrectReadsBatch(std::vector<bool> &res,
-                       std::vector<Read> &reads, size_t buf_size,
-                       const KMerData &data) {
+namespace {
+
+// A batch of reads travelling through the correction pipeline. Paired
+// files fill both halves, single ones only the first.
+struct ReadBatch {
+  std::vector<Read> reads[2];
+  std::vector<bool> res[2];
+};
+
+}
+
+// Batches of reads are parsed by the master thread, corrected by all the
+// threads out of order and printed in the input order by a separate thread.
+template<class Parser, class Printer>
+static CorrectionStats CorrectReadsPipelined(const KMerData &data,
+                                             Parser parse, Printer print) {
   unsigned correct_nthreads = min(cfg::get().correct_nthreads, cfg::get().general_max_nthreads);
   bool discard_singletons = cfg::get().bayes_discard_only_singletons;
   bool correct_threshold = cfg::get().correct_use_threshold;
   bool discard_bad = cfg::get().correct_discard_bad;
 
-  ReadCorrector corrector(data, cfg::get().correct_stats);
-# pragma omp parallel for shared(reads, res, data) num_threads(correct_nthreads)
-  for (size_t i = 0; i < buf_size; ++i) {
-    if (reads[i].size() >= K) {
-      res[i] =
-          corrector.CorrectOneRead(reads[i],
-                                   correct_threshold, discard_singletons, discard_bad);
-    } else
-      res[i] = false;
-  }
+  // Keep about as many reads in memory as one buffer of correct_readbuffer
+  // reads per thread used to, but split into smaller batches so that the
+  // threads do not wait for each other
+  size_t batch_size = std::max(cfg::get().correct_readbuffer / 4, 1u);
+  size_t max_inflight = 4 * correct_nthreads;
+
+  std::vector<ReadCorrector> correctors;
+  correctors.reserve(correct_nthreads);
+  for (unsigned i = 0; i < correct_nthreads; ++i)
+    correctors.emplace_back(data, cfg::get().correct_stats);
+
+  size_t batches = 0, written = 0;
+  utils::OrderedPipeline<ReadBatch>(correct_nthreads, max_inflight).Run(
+      [&](ReadBatch &batch) {
+        return parse(batch, batch_size);
+      },
+      [&](ReadBatch &batch) {
+        ReadCorrector &corrector = correctors[omp_get_thread_num()];
+        for (unsigned half = 0; half < 2; ++half) {
+          std::vector<Read> &reads = batch.reads[half];
+          std::vector<bool> &res = batch.res[half];
+          res.resize(reads.size());
+          for (size_t i = 0; i < reads.size(); ++i)
+            res[i] = reads[i].size() >= K &&
+                     corrector.CorrectOneRead(reads[i], correct_threshold, discard_singletons, discard_bad);
+        }
+      },
+      [&](const ReadBatch &batch) {
+        print(batch);
+        written += batch.reads[0].size();
+        if (++batches % max_inflight == 0)
+          INFO("Written " << written << " reads");
+      });
 
   CorrectionStats stats;
-
-  stats.changedReads += corrector.changed_reads();
-  stats.changedNucleotides += corrector.changed_nucleotides();
-  stats.uncorrectedNucleotides += corrector.uncorrected_nucleotides();
-  stats.totalNucleotides += corrector.total_nucleotides();
+  for (const auto &corrector : correctors) {
+    stats.changedReads += corrector.changed_reads();
+    stats.changedNucleotides += corrector.changed_nucleotides();
+    stats.uncorrectedNucleotides += corrector.uncorrected_nucleotides();
+    stats.totalNucleotides += corrector.total_nucleotides();
+  }
   return stats;
 }
 
@@ -110,35 +149,24 @@ CorrectionStats CorrectReadFile(const KMerData &data,
   int qvoffset = cfg::get().input_qvoffset;
   int trim_quality = cfg::get().input_trim_quality;
 
-  unsigned correct_nthreads = min(cfg::get().correct_nthreads, cfg::get().general_max_nthreads);
-  size_t read_buffer_size = correct_nthreads * cfg::get().correct_readbuffer;
-  std::vector<Read> reads(read_buffer_size);
-  std::vector<bool> res(read_buffer_size, false);
-
   ireadstream irs(fname, qvoffset);
   VERIFY(irs.is_open());
 
-  unsigned buffer_no = 0;
-  CorrectionStats stats;
-  while (!irs.eof()) {
-    size_t buf_size = 0;
-    for (; buf_size < read_buffer_size && !irs.eof(); ++buf_size) {
-      irs >> reads[buf_size];
-      reads[buf_size].trimNsAndBadQuality(trim_quality);
-    }
-    INFO("Prepared batch " << buffer_no << " of " << buf_size << " reads.");
-
-    stats += CorrectReadsBatch(res, reads, buf_size,
-                               data);
-
-    INFO("Processed batch " << buffer_no);
-    for (size_t i = 0; i < buf_size; ++i) {
-      reads[i].print(*(res[i] ? outf_good : outf_bad), qvoffset);
-    }
-    INFO("Written batch " << buffer_no);
-    ++buffer_no;
-  }
-  return stats;
+  return CorrectReadsPipelined(data,
+                               [&](ReadBatch &batch, size_t batch_size) {
+                                 std::vector<Read> &reads = batch.reads[0];
+                                 reads.reserve(batch_size);
+                                 while (reads.size() < batch_size && !irs.eof()) {
+                                   reads.emplace_back();
+                                   irs >> reads.back();
+                                   reads.back().trimNsAndBadQuality(trim_quality);
+                                 }
+                                 return !reads.empty();
+                               },
+                               [&](const ReadBatch &batch) {
+                                 for (size_t i = 0; i < batch.reads[0].size(); ++i)
+                                   batch.reads[0][i].print(*(batch.res[0][i] ? outf_good : outf_bad), qvoffset);
+                               });
 }
 
 CorrectionStats CorrectPairedReadFiles(const KMerData &data,
@@ -147,46 +175,36 @@ CorrectionStats CorrectPairedReadFiles(const KMerData &data,
   int qvoffset = cfg::get().input_qvoffset;
   int trim_quality = cfg::get().input_trim_quality;
 
-  unsigned correct_nthreads = min(cfg::get().correct_nthreads, cfg::get().general_max_nthreads);
-  size_t read_buffer_size = correct_nthreads * cfg::get().correct_readbuffer;
-  std::vector<Read> l(read_buffer_size);
-  std::vector<Read> r(read_buffer_size);
-  std::vector<bool> left_res(read_buffer_size, false);
-  std::vector<bool> right_res(read_buffer_size, false);
-
-  unsigned buffer_no = 0;
-
   ireadstream irsl(fnamel, qvoffset), irsr(fnamer, qvoffset);
   VERIFY(irsl.is_open()); VERIFY(irsr.is_open());
-  CorrectionStats stats;
 
-  while (!irsl.eof() && !irsr.eof()) {
-    size_t buf_size = 0;
-    for (; buf_size < read_buffer_size && !irsl.eof() && !irsr.eof(); ++buf_size) {
-      irsl >> l[buf_size]; irsr >> r[buf_size];
-      l[buf_size].trimNsAndBadQuality(trim_quality);
-      r[buf_size].trimNsAndBadQuality(trim_quality);
-    }
-    INFO("Prepared batch " << buffer_no << " of " << buf_size << " reads.");
-
-    stats += CorrectReadsBatch(left_res, l, buf_size,
-                      data);
-    stats += CorrectReadsBatch(right_res, r, buf_size,
-                      data);
-
-    INFO("Processed batch " << buffer_no);
-    for (size_t i = 0; i < buf_size; ++i) {
-      if (left_res[i] && right_res[i]) {
-        l[i].print(*ofcorl, qvoffset);
-        r[i].print(*ofcorr, qvoffset);
-      } else {
-        l[i].print(*(left_res[i] ? ofunp : ofbadl), qvoffset);
-        r[i].print(*(right_res[i] ? ofunp : ofbadr), qvoffset);
-      }
-    }
-    INFO("Written batch " << buffer_no);
-    ++buffer_no;
-  }
+  CorrectionStats stats =
+      CorrectReadsPipelined(data,
+                            [&](ReadBatch &batch, size_t batch_size) {
+                              std::vector<Read> &l = batch.reads[0], &r = batch.reads[1];
+                              l.reserve(batch_size); r.reserve(batch_size);
+                              while (l.size() < batch_size && !irsl.eof() && !irsr.eof()) {
+                                l.emplace_back(); r.emplace_back();
+                                irsl >> l.back(); irsr >> r.back();
+                                l.back().trimNsAndBadQuality(trim_quality);
+                                r.back().trimNsAndBadQuality(trim_quality);
+                              }
+                              return !l.empty();
+                            },
+                            [&](const ReadBatch &batch) {
+                              const std::vector<Read> &l = batch.reads[0], &r = batch.reads[1];
+                              const std::vector<bool> &left_res = batch.res[0], &right_res = batch.res[1];
+                              for (size_t i = 0; i < l.size(); ++i) {
+                                if (left_res[i] && right_res[i]) {
+                                  l[i].print(*ofcorl, qvoffset);
+                                  r[i].print(*ofcorr, qvoffset);
+                                } else {
+                                  l[i].print(*(left_res[i] ? ofunp : ofbadl), qvoffset);
+                                  r[i].print(*(right_res[i] ? ofunp : ofbadr), qvoffset);
+                                }
+                              }
+                            });
+
   if (!irsl.eof() || !irsr.eof())
       FATAL_ERROR("Pair of read files " + fnamel + " and " + fnamer + " contain unequal amount of reads");
   return stats;
@@ -44,22 +44,15 @@ struct CorrectionStats {
   }
 };
 
-/// parallel correction of batch of reads
-CorrectionStats CorrectReadsBatch(std::vector<bool> &res, std::vector<Read> &reads, size_t buf_size,
-                       size_t &changedReads, size_t &changedNucleotides, size_t &uncorrectedNucleotides, size_t &totalNucleotides,
-                       const KMerData &data);
-
 /// correct reads in a given file
 CorrectionStats CorrectReadFile(const KMerData &data,
-                         size_t &changedReads, size_t &changedNucleotides, size_t &uncorrectedNucleotides, size_t &totalNucleotides,
-                         const std::string &fname,
-                         std::ofstream *outf_good, std::ofstream *outf_bad);
+                                const std::string &fname,
+                                std::ofstream *outf_good, std::ofstream *outf_bad);
 
 /// correct reads in a given pair of files
 CorrectionStats CorrectPairedReadFiles(const KMerData &data,
-                            size_t &changedReads, size_t &changedNucleotides, size_t &uncorrectedNucleotides, size_t &totalNucleotides,
-                            const std::string &fnamel, const std::string &fnamer,
-                            std::ofstream * ofbadl, std::ofstream * ofcorl, std::ofstream * ofbadr, std::ofstream * ofcorr, std::ofstream * ofunp);
+                                       const std::string &fnamel, const std::string &fnamer,
+                                       std::ofstream * ofbadl, std::ofstream * ofcorl, std::ofstream * ofbadr, std::ofstream * ofcorr, std::ofstream * ofunp);
 /// correct all reads
 size_t CorrectAllReads();
 
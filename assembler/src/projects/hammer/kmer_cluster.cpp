@@ -20,6 +20,7 @@
 #include <iostream>
 #include <fstream>
 #include <algorithm>
+#include <mutex>
 
 using std::max_element;
 using std::min_element;
@@ -258,7 +259,8 @@ double KMerClustering::lMeansClustering(unsigned l, const std::vector<hammer::Ex
 }
 
 
-size_t KMerClustering::SubClusterSingle(const std::vector<size_t> & block, std::vector< std::vector<size_t> > & vec) {
+size_t KMerClustering::SubClusterSingle(const std::vector<size_t> & block, std::vector< std::vector<size_t> > & vec,
+                                        std::vector<hammer::KMer> & newCenters) {
   size_t newkmers = 0;
 
   if (cfg::get().bayes_debug_output > 0) {
@@ -428,13 +430,10 @@ size_t KMerClustering::SubClusterSingle(const std::vector<size_t> & block, std::
         KMer newkmer(bestCenters[k].center_);
         size_t new_idx = data_.checking_seq_idx(newkmer);
         if (new_idx == -1ULL) {
-          #pragma omp critical
-          {
-            KMerStat kms(0 /* cnt */, 1.0 /* total quality */, NULL /*quality */);
-            kms.mark_good();
-            new_idx = data_.push_back(newkmer, kms);
-            newkmers += 1;
-          }
+          // The k-mer is added to the data by the caller
+          new_idx = NEW_CENTER;
+          newCenters.push_back(newkmer);
+          newkmers += 1;
         }
         v.insert(v.begin(), new_idx);
       }
@@ -452,12 +451,20 @@ static void UpdateErrors(numeric::matrix<uint64_t> &m,
   }
 }
 
-size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
-                                      numeric::matrix<uint64_t> &errs,
-                                      std::ofstream &ofs, std::ofstream &ofs_bad,
-                                      size_t &gsingl, size_t &tsingl, size_t &tcsingl, size_t &gcsingl,
-                                      size_t &tcls, size_t &gcls, size_t &tkmers, size_t &tncls) {
-    size_t newkmers = 0;
+KMerClustering::Stats &KMerClustering::Stats::operator+=(const Stats &other) {
+  gsingl += other.gsingl; tsingl += other.tsingl;
+  tcsingl += other.tcsingl; gcsingl += other.gcsingl;
+  tcls += other.tcls; gcls += other.gcls;
+  tkmers += other.tkmers; tncls += other.tncls;
+
+  return *this;
+}
+
+void KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
+                                    numeric::matrix<uint64_t> &errs,
+                                    ChunkResult &res) {
+    Stats &stats = res.stats;
+    bool write_good = cfg::get().bayes_write_solid_kmers, write_bad = cfg::get().bayes_write_bad_kmers;
 
     // No need for clustering for singletons
     if (cur_class.size() == 1) {
@@ -465,49 +472,44 @@ size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
         KMerStat &singl = data_[idx];
         if ((1-singl.total_qual) > cfg::get().bayes_singleton_threshold) {
             singl.mark_good();
-            gsingl += 1;
+            stats.gsingl += 1;
 
-            if (ofs.good()) {
-#               pragma omp critical
-                {
-                    ofs << " good singleton: " << idx << "\n  " << singl << '\n';
-                }
-            }
+            if (write_good)
+                res.good << " good singleton: " << idx << "\n  " << singl << '\n';
         } else {
             if (cfg::get().correct_use_threshold && (1-singl.total_qual) > cfg::get().correct_threshold)
                 singl.mark_good();
             else
                 singl.mark_bad();
 
-            if (ofs_bad.good()) {
-#               pragma omp critical
-                {
-                    ofs_bad << " bad singleton: " << idx << "\n  " << singl << '\n';
-                }
-            }
+            if (write_bad)
+                res.bad << " bad singleton: " << idx << "\n  " << singl << '\n';
         }
-        tsingl += 1;
-        return 0;
+        stats.tsingl += 1;
+        return;
     }
 
     std::vector<std::vector<size_t> > blocksInPlace;
+    std::vector<KMer> newCenters;
     if (cfg::get().bayes_debug_output) {
 #       pragma omp critical
         {
           std::cout << "process_SIN with size=" << cur_class.size() << std::endl;
         }
       }
-    newkmers += SubClusterSingle(cur_class, blocksInPlace);
+    SubClusterSingle(cur_class, blocksInPlace, newCenters);
 
-    tncls += 1;
+    stats.tncls += 1;
+    auto newCenter = newCenters.begin();
     for (size_t m = 0; m < blocksInPlace.size(); ++m) {
         const std::vector<size_t> &currentBlock = blocksInPlace[m];
         if (currentBlock.size() == 0)
             continue;
 
         size_t cidx = currentBlock[0];
-        KMerStat &center = data_[cidx];
-        KMer ckmer = data_.kmer(cidx);
+        KMerStat newStat(0 /* cnt */, 1.0 /* total quality */, NULL /*quality */);
+        KMerStat &center = (cidx == NEW_CENTER ? newStat : data_[cidx]);
+        KMer ckmer = (cidx == NEW_CENTER ? *newCenter++ : data_.kmer(cidx));
         double center_quality = 1 - center.total_qual;
 
         // Computing the overall quality of a cluster.
@@ -520,9 +522,9 @@ size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
         }
 
         if (currentBlock.size() == 1)
-            tcsingl += 1;
+            stats.tcsingl += 1;
         else
-            tcls += 1;
+            stats.tcls += 1;
 
         if ((center_quality > cfg::get().bayes_singleton_threshold &&
              cluster_quality > cfg::get().bayes_nonsingleton_threshold) ||
@@ -530,32 +532,27 @@ size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
           center.mark_good();
 
           if (currentBlock.size() == 1)
-              gcsingl += 1;
+              stats.gcsingl += 1;
           else
-              gcls += 1;
-
-          if (ofs.good()) {
-#             pragma omp critical
-              {
-                  ofs << " center of good cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
-                  << center << '\n';
-              }
-          }
+              stats.gcls += 1;
+
+          if (write_good)
+              res.good << " center of good cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
+                       << center << '\n';
         } else {
             if (cfg::get().correct_use_threshold && center_quality > cfg::get().correct_threshold)
                 center.mark_good();
             else
                 center.mark_bad();
-            if (ofs_bad.good()) {
-#               pragma omp critical
-                {
-                    ofs_bad << " center of bad cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
-                            << center << '\n';
-                }
-            }
+            if (write_bad)
+                res.bad << " center of bad cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
+                        << center << '\n';
         }
 
-        tkmers += currentBlock.size();
+        if (cidx == NEW_CENTER)
+            res.new_kmers.emplace_back(ckmer, center);
+
+        stats.tkmers += currentBlock.size();
 
         for (size_t j = 1; j < currentBlock.size(); ++j) {
             size_t eidx = currentBlock[j];
@@ -563,17 +560,11 @@ size_t KMerClustering::ProcessCluster(const std::vector<size_t> &cur_class,
 
             UpdateErrors(errs, data_.kmer(eidx), ckmer);
 
-            if (ofs_bad.good()) {
-#               pragma omp critical
-                {
-                    ofs_bad << " part of cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
-                            << kms << '\n';
-                }
-            }
+            if (write_bad)
+                res.bad << " part of cluster (" << currentBlock.size() << ", " << cluster_quality << ")" << "\n  "
+                        << kms << '\n';
         }
     }
-
-    return newkmers;
 }
 
 
@@ -588,9 +579,6 @@ public:
 };
 
 void KMerClustering::process(const std::string &Prefix) {
-  size_t newkmers = 0;
-  size_t gsingl = 0, tsingl = 0, tcsingl = 0, gcsingl = 0, tcls = 0, gcls = 0, tkmers = 0, tncls = 0;
-
   std::ofstream ofs, ofs_bad;
   if (cfg::get().bayes_write_solid_kmers)
     ofs.open(GetGoodKMersFname());
@@ -602,10 +590,14 @@ void KMerClustering::process(const std::string &Prefix) {
 
   std::vector<numeric::matrix<uint64_t> > errs(nthreads_, numeric::matrix<double>(4, 4, 0.0));
 
-# pragma omp parallel for shared(ofs, ofs_bad, errs) num_threads(nthreads_) schedule(guided) reduction(+:newkmers, gsingl, tsingl, tcsingl, gcsingl, tcls, gcls, tkmers, tncls)
-  for (size_t chunk = 0; chunk < nthreads_ * nthreads_; ++chunk) {
-      size_t *current = findex.data() + findex.size() * chunk / nthreads_ / nthreads_;
-      size_t *next = findex.data() + findex.size() * (chunk + 1)/ nthreads_ / nthreads_;
+  size_t nchunks = nthreads_ * nthreads_, flushed = 0;
+  std::vector<ChunkResult> results(nchunks);
+  std::mutex output_lock;
+
+# pragma omp parallel for shared(ofs, ofs_bad, errs, results, flushed) num_threads(nthreads_) schedule(guided)
+  for (size_t chunk = 0; chunk < nchunks; ++chunk) {
+      size_t *current = findex.data() + findex.size() * chunk / nchunks;
+      size_t *next = findex.data() + findex.size() * (chunk + 1) / nchunks;
       std::ifstream is(Prefix, std::ios::in | std::ios::binary);
 
       // Calculate how much we need to seek
@@ -616,6 +608,7 @@ void KMerClustering::process(const std::string &Prefix) {
       // Now see the stream and start processing
       is.seekg(soff * sizeof(size_t));
 
+      ChunkResult &res = results[chunk];
       for (; current != next; ++current) {
           std::vector<size_t> cluster(*current);
           VERIFY(is.good());
@@ -624,11 +617,20 @@ void KMerClustering::process(const std::string &Prefix) {
           // Underlying code expected classes to be sorted in count decreasing order.
           std::sort(cluster.begin(), cluster.end(), KMerStatCountComparator(data_));
 
-          newkmers += ProcessCluster(cluster,
-                                     errs[omp_get_thread_num()],
-                                     ofs, ofs_bad,
-                                     gsingl, tsingl, tcsingl, gcsingl,
-                                     tcls, gcls, tkmers, tncls);
+          ProcessCluster(cluster, errs[omp_get_thread_num()], res);
+      }
+
+      // Write out all the finished chunks preceding the pending ones
+      std::lock_guard<std::mutex> lock(output_lock);
+      res.done = true;
+      for (; flushed < nchunks && results[flushed].done; ++flushed) {
+          ChunkResult &done = results[flushed];
+          if (ofs.is_open())
+              ofs << done.good.str();
+          if (ofs_bad.is_open())
+              ofs_bad << done.bad.str();
+          done.good.str(std::string());
+          done.bad.str(std::string());
       }
   }
 
@@ -638,6 +640,15 @@ void KMerClustering::process(const std::string &Prefix) {
                         "unlink(2) failed. Reason: " << strerror(errno) << ". Error code: " << errno);
   }
 
+  Stats stats;
+  size_t newkmers = 0;
+  for (const auto &res : results) {
+      stats += res.stats;
+      for (const auto &entry : res.new_kmers)
+          data_.push_back(entry.first, entry.second);
+      newkmers += res.new_kmers.size();
+  }
+
   for (unsigned i = 1; i < nthreads_; ++i)
     errs[0] += errs[i];
 
@@ -649,11 +660,11 @@ void KMerClustering::process(const std::string &Prefix) {
 
   INFO("Subclustering done. Total " << newkmers << " non-read kmers were generated.");
   INFO("Subclustering statistics:");
-  INFO("  Total singleton hamming clusters: " << tsingl << ". Among them " << gsingl << " (" << 100.0 * (double)gsingl / (double)tsingl << "%) are good");
-  INFO("  Total singleton subclusters: " << tcsingl << ". Among them " << gcsingl << " (" << 100.0 * (double)gcsingl / (double)tcsingl << "%) are good");
-  INFO("  Total non-singleton subcluster centers: " << tcls << ". Among them " << gcls << " (" << 100.0 * (double)gcls / (double)tcls << "%) are good");
-  INFO("  Average size of non-trivial subcluster: " << 1.0 * (double)tkmers / (double)tcls << " kmers");
-  INFO("  Average number of sub-clusters per non-singleton cluster: " << 1.0 * (double)(tcsingl + tcls) / (double)tncls);
-  INFO("  Total solid k-mers: " << gsingl + gcsingl + gcls);
+  INFO("  Total singleton hamming clusters: " << stats.tsingl << ". Among them " << stats.gsingl << " (" << 100.0 * (double)stats.gsingl / (double)stats.tsingl << "%) are good");
+  INFO("  Total singleton subclusters: " << stats.tcsingl << ". Among them " << stats.gcsingl << " (" << 100.0 * (double)stats.gcsingl / (double)stats.tcsingl << "%) are good");
+  INFO("  Total non-singleton subcluster centers: " << stats.tcls << ". Among them " << stats.gcls << " (" << 100.0 * (double)stats.gcls / (double)stats.tcls << "%) are good");
+  INFO("  Average size of non-trivial subcluster: " << 1.0 * (double)stats.tkmers / (double)stats.tcls << " kmers");
+  INFO("  Average number of sub-clusters per non-singleton cluster: " << 1.0 * (double)(stats.tcsingl + stats.tcls) / (double)stats.tncls);
+  INFO("  Total solid k-mers: " << stats.gsingl + stats.gcsingl + stats.gcls);
   INFO("  Substitution probabilities: " << err);
 }
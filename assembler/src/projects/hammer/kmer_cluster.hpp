@@ -18,7 +18,9 @@
 #include "hamcluster.hpp"
 #include "kmer_data.hpp"
 
+#include <sstream>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <boost/numeric/ublas/fwd.hpp>
@@ -40,6 +42,26 @@ private:
     hammer::ExpandedSeq center_;
     size_t count_;
   };
+
+  struct Stats {
+    size_t gsingl = 0, tsingl = 0, tcsingl = 0, gcsingl = 0;
+    size_t tcls = 0, gcls = 0, tkmers = 0, tncls = 0;
+
+    Stats &operator+=(const Stats &other);
+  };
+
+  // Everything a chunk of clusters produces. Chunks are processed by
+  // different threads without any locking and merged in the chunk order, so
+  // the output does not depend on the scheduling.
+  struct ChunkResult {
+    Stats stats;
+    std::ostringstream good, bad;
+    std::vector<std::pair<hammer::KMer, KMerStat> > new_kmers;
+    bool done = false;
+  };
+
+  // Marks the subcluster center which is not among the k-mers of the reads
+  static const size_t NEW_CENTER = -1ULL;
     
   double ClusterBIC(const std::vector<Center> &centers,
                     const std::vector<size_t> &indices, const std::vector<hammer::ExpandedKMer> &kmers) const;
@@ -53,16 +75,20 @@ private:
   double lMeansClustering(unsigned l, const std::vector<hammer::ExpandedKMer> &kmers,
                           std::vector<size_t> & indices, std::vector<Center> & centers);
 
-  size_t SubClusterSingle(const std::vector<size_t> & block, std::vector< std::vector<size_t> > & vec);
+  /**
+    * split the block into subclusters, the center of each one goes first
+    * @param newCenters k-mers of the centers marked as NEW_CENTER, in order of their subclusters
+    * @return the number of such centers
+    */
+  size_t SubClusterSingle(const std::vector<size_t> & block, std::vector< std::vector<size_t> > & vec,
+                          std::vector<hammer::KMer> & newCenters);
 
   std::string GetGoodKMersFname() const;
   std::string GetBadKMersFname() const;
 
-  size_t ProcessCluster(const std::vector<size_t> &cur_class,
-                        boost::numeric::ublas::matrix<uint64_t> &errs,
-                        std::ofstream &ofs, std::ofstream &ofs_bad,
-                        size_t &gsingl, size_t &tsingl, size_t &tcsingl, size_t &gcsingl,
-                        size_t &tcls, size_t &gcls, size_t &tkmers, size_t &tncls);
+  void ProcessCluster(const std::vector<size_t> &cur_class,
+                      boost::numeric::ublas::matrix<uint64_t> &errs,
+                      ChunkResult &res);
 
 private:
   DECL_LOGGER("Hamming Subclustering");
@@ -74,12 +74,12 @@ class BufferFiller {
     ValidKMerGenerator<hammer::K> gen(cr);
     bool stop = false;
     for (; gen.HasMore(); gen.Next()) {
-      KMer seq = gen.kmer();
+      const KMer &seq = gen.kmer();
       if (!splitter_.filter_(seq))
         continue;
 
-      stop |= splitter_.push_back_internal( seq, thread_id);
-      stop |= splitter_.push_back_internal(!seq, thread_id);
+      stop |= splitter_.push_back_internal(seq, thread_id);
+      stop |= splitter_.push_back_internal(gen.rc_kmer(), thread_id);
     }
 
     return stop;
@@ -123,7 +123,7 @@ static inline void Merge(KMerStat &lhs, const KMerStat &rhs) {
 }
 
 static void PushKMer(KMerData &data,
-                     KMer kmer, const unsigned char *q, double prob) {
+                     const KMer &kmer, const unsigned char *q, double prob) {
   size_t idx = data.checking_seq_idx(kmer);
   if (idx == -1ULL)
       return;
@@ -135,15 +135,14 @@ static void PushKMer(KMerData &data,
 }
 
 static void PushKMerRC(KMerData &data,
-                       KMer kmer, const unsigned char *q, double prob) {
+                       const KMer &rc_kmer, const unsigned char *q, double prob) {
   unsigned char rcq[K];
 
-  // Prepare RC kmer with quality.
-  kmer = !kmer;
+  // Prepare RC kmer quality.
   for (unsigned i = 0; i < K; ++i)
     rcq[K - i - 1] = q[i];
 
-  size_t idx = data.checking_seq_idx(kmer);
+  size_t idx = data.checking_seq_idx(rc_kmer);
   if (idx == -1ULL)
       return;
   KMerStat &kmc = data[idx];
@@ -173,11 +172,10 @@ class KMerDataFiller {
     ValidKMerGenerator<hammer::K> gen(cr);
     const char *q = cr.getQualityString().data();
     while (gen.HasMore()) {
-      KMer kmer = gen.kmer();
       const unsigned char *kq = (const unsigned char*)(q + gen.pos() - 1);
 
-      PushKMer(data_, kmer, kq, 1 - gen.correct_probability());
-      PushKMerRC(data_, kmer, kq, 1 - gen.correct_probability());
+      PushKMer(data_, gen.kmer(), kq, 1 - gen.correct_probability());
+      PushKMerRC(data_, gen.rc_kmer(), kq, 1 - gen.correct_probability());
 
       gen.Next();
     }
@@ -210,10 +208,8 @@ class KMerMultiplicityCounter {
 
       ValidKMerGenerator<hammer::K> gen(cr);
       for (; gen.HasMore(); gen.Next()) {
-          KMer kmer = gen.kmer();
-
-          cqf_.add(kmer);
-          cqf_.add(!kmer);
+          cqf_.add(gen.kmer());
+          cqf_.add(gen.rc_kmer());
       }
 
       return false;
@@ -248,11 +244,10 @@ class KMerCountEstimator {
 
       ValidKMerGenerator<hammer::K> gen(cr);
       for (; gen.HasMore(); gen.Next()) {
-          KMer kmer = gen.kmer();
           auto &hll = hll_[omp_get_thread_num()];
 
-          hll.add(kmer);
-          hll.add(!kmer);
+          hll.add(gen.kmer());
+          hll.add(gen.rc_kmer());
       }
 
       return false;
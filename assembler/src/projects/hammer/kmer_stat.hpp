@@ -35,13 +35,18 @@ typedef Seq<K> KMer;
 class Read;
 struct KMerStat;
 
+// Compares the packed k-mers a word at a time: a nucleotide differs if any
+// of its two bits does. Stops early as soon as the distance exceeds tau.
 static inline unsigned hamdistKMer(const hammer::KMer &x, const hammer::KMer &y,
                                    unsigned tau = hammer::K) {
+  typedef hammer::KMer::DataType DataType;
+  const DataType low_bits = DataType(0x5555555555555555ULL);
+
   unsigned dist = 0;
-  for (unsigned i = 0; i < hammer::K; ++i) {
-    if (x[i] != y[i]) {
-      ++dist; if (dist > tau) return dist;
-    }
+  for (size_t i = 0; i < hammer::KMer::DataSize; ++i) {
+    DataType diff = x.data()[i] ^ y.data()[i];
+    dist += unsigned(__builtin_popcountll((diff | (diff >> 1)) & low_bits));
+    if (dist > tau) return dist;
   }
   return dist;
 }
@@ -35,18 +35,6 @@
 #include <cmath>
 #include <cstdlib>
 
-std::vector<uint32_t> * Globals::subKMerPositions = NULL;
-KMerData *Globals::kmer_data = NULL;
-int Globals::iteration_no = 0;
-
-char Globals::char_offset = 0;
-bool Globals::char_offset_user = true;
-
-double Globals::quality_probs[256] = { 0 };
-double Globals::quality_lprobs[256] = { 0 };
-double Globals::quality_rprobs[256] = { 0 };
-double Globals::quality_lrprobs[256] = { 0 };
-
 struct UfCmp {
   bool operator()(const std::vector<int> &lhs, const std::vector<int> &rhs) {
     return (lhs[0] < rhs[0]);
@@ -100,12 +88,7 @@ int main(int argc, char * argv[]) {
     Globals::char_offset = (char)cfg::get().input_qvoffset;
 
     // Pre-cache quality probabilities
-    for (unsigned qual = 0; qual < sizeof(Globals::quality_probs) / sizeof(Globals::quality_probs[0]); ++qual) {
-      Globals::quality_rprobs[qual] = (qual < 3 ? 0.75 : pow(10.0, -(int)qual / 10.0));
-      Globals::quality_probs[qual] = 1 - Globals::quality_rprobs[qual];
-      Globals::quality_lprobs[qual] = log(Globals::quality_probs[qual]);
-      Globals::quality_lrprobs[qual] = log(Globals::quality_rprobs[qual]);
-    }
+    Globals::InitializeQualityProbs();
 
     // initialize subkmer positions
     hammer::InitializeSubKMerPositions(cfg::get().general_tau);
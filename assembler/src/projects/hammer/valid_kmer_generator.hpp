@@ -11,6 +11,7 @@
 #include "globals.hpp"
 
 #include "io/reads/read.hpp"
+#include "sequence/canonical_kmer_roller.hpp"
 #include "sequence/seq.hpp"
 
 #include <string>
@@ -71,7 +72,7 @@ class ValidKMerGenerator {
   void Reset(const char *seq, const char *qual,
              size_t len,
              uint8_t bad_quality_threshold = 2) {
-    kmer_ = Seq<kK>();
+    kmer_ = CanonicalKMerRoller<Seq<kK>>();
     seq_ = seq;
     qual_ = qual;
     pos_ = -1;
@@ -97,7 +98,13 @@ class ValidKMerGenerator {
    * @result last k-mer generated by Next().
    */
   const Seq<kK>& kmer() const {
-    return kmer_;
+    return kmer_.forward();
+  }
+  /**
+   * @result reverse complement of the last k-mer, maintained along with it.
+   */
+  const Seq<kK>& rc_kmer() const {
+    return kmer_.reverse_complement();
   }
   /**
    * @result last k-mer position in initial read.
@@ -128,7 +135,7 @@ class ValidKMerGenerator {
       return qual_[pos];
     }
   }
-  Seq<kK> kmer_;
+  CanonicalKMerRoller<Seq<kK>> kmer_;
   const char* seq_;
   const char* qual_;
   size_t pos_;
@@ -181,14 +188,14 @@ void ValidKMerGenerator<kK>::Next() {
       }
     }
     if (i == kK + start_hypothesis) {
-      kmer_ = Seq<kK>(seq_ + start_hypothesis, 0, kK, /* raw */ true);
+      kmer_ = CanonicalKMerRoller<Seq<kK>>(Seq<kK>(seq_ + start_hypothesis, 0, kK, /* raw */ true));
       pos_ = start_hypothesis + 1;
     } else {
       has_more_ = false;
     }
   } else {
     // good case we can just shift our previous answer
-    kmer_ = kmer_ << seq_[pos_ + kK - 1];
+    kmer_ <<= seq_[pos_ + kK - 1];
     if (qual_) {
       correct_probability_ *= Prob(GetQual((uint32_t)pos_ + kK - 1));
       correct_probability_ /= Prob(GetQual((uint32_t)pos_ - 1));
@@ -15,6 +15,7 @@
 
 #include "pipeline/graph_pack.hpp"
 
+#include "adt/iterator_range.hpp"
 #include "sequence/aa.hpp"
 #include "io/reads/osequencestream.hpp"
 #include "utils/filesystem/path_helper.hpp"
@@ -22,33 +23,112 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <map>
+#include <memory>
 #include <string>
 #include <vector>
 
 extern "C" {
     #include "easel.h"
+    #include "esl_alphabet.h"
+    #include "esl_sq.h"
     #include "esl_sqio.h"
 }
 
 namespace nrps {
 
-static void MatchContigsInternal(hmmer::HMMMatcher &matcher, const path_extend::BidirectionalPath &path,
-                                 const std::string &path_string,
-                                 const std::string &type, const std::string &desc,
-                                 ContigAlnInfo &res, io::OFastaReadStream &oss_contig, size_t model_length,
-                                 bool isAA = true) {
-    if (isAA) {
-        for (size_t shift = 0; shift < 3; ++shift) {
-            std::string ref_shift = std::to_string(path.GetId()) + "_" + std::to_string(shift);
-            std::string seq_aas = aa::translate(path_string.c_str() + shift);
-            matcher.match(ref_shift.c_str(), seq_aas.c_str());
+using ESLSeqPtr = std::unique_ptr<ESL_SQ, void(*)(ESL_SQ*)>;
+
+// Contig paths made into sequences, translated and digitized once for all the HMMs.
+// The digitized sequences of both strands are kept until all the matching is done,
+// that is about two bytes per assembled base for each of the alphabets used.
+class MatchTargets {
+  public:
+    MatchTargets(const path_extend::PathContainer &contig_paths,
+                 const path_extend::ScaffoldSequenceMaker &scaffold_maker)
+            : scaffold_maker_(scaffold_maker) {
+        for (auto iter = contig_paths.begin(); iter != contig_paths.end(); ++iter) {
+            if (iter.get().Length() <= 0)
+                continue;
+            paths_.push_back(&iter.get());
+
+            if (iter.getConjugate().Length() <= 0)
+                continue;
+            paths_.push_back(&iter.getConjugate());
         }
-    } else {
-            std::string ref_shift = std::to_string(path.GetId()) + "_0";
-            matcher.match(ref_shift.c_str(), path_string.c_str());
     }
+
+    // Amino acid HMMs are matched against the three frame translations
+    void Prepare(int alphabet_type) {
+        if (digitized_.count(alphabet_type))
+            return;
+
+        Digitized &digitized = digitized_.emplace(alphabet_type, Digitized(alphabet_type)).first->second;
+        size_t frames = alphabet_type == eslAMINO ? 3 : 1;
+        digitized.seqs.reserve(frames * paths_.size());
+        for (size_t i = 0; i < frames * paths_.size(); ++i)
+            digitized.seqs.emplace_back(nullptr, esl_sq_Destroy);
+
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < paths_.size(); ++i) {
+            std::string path_string = sequence(i);
+            for (size_t shift = 0; shift < frames; ++shift) {
+                std::string ref_shift = std::to_string(paths_[i]->GetId()) + "_" + std::to_string(shift);
+                ESL_SQ *dbsq = frames == 3 ?
+                               esl_sq_CreateFrom(ref_shift.c_str(), aa::translate(path_string.c_str() + shift).c_str(), NULL, NULL, NULL) :
+                               esl_sq_CreateFrom(ref_shift.c_str(), path_string.c_str(), NULL, NULL, NULL);
+                esl_sq_Digitize(digitized.abc.get(), dbsq);
+                digitized.seqs[frames * i + shift].reset(dbsq);
+            }
+        }
+
+        size_t residues = 0;
+        for (const auto &seq : digitized.seqs)
+            residues += size_t(seq->n);
+        INFO("Digitized contigs for " << (alphabet_type == eslAMINO ? "amino acid" : "nucleotide") << " HMMs, "
+             << (double)residues / 1024.0 / 1024.0 << " Mb kept until the matching is done");
+    }
+
+    size_t size() const { return paths_.size(); }
+    const path_extend::BidirectionalPath &path(size_t i) const { return *paths_[i]; }
+    std::string sequence(size_t i) const { return scaffold_maker_.MakeSequence(*paths_[i]); }
+    adt::iterator_range<std::vector<ESLSeqPtr>::const_iterator> seqs(size_t i, int alphabet_type) const {
+        size_t frames = alphabet_type == eslAMINO ? 3 : 1;
+        auto begin = digitized_.at(alphabet_type).seqs.begin() + ptrdiff_t(frames * i);
+        return adt::make_range(begin, begin + ptrdiff_t(frames));
+    }
+
+  private:
+    struct Digitized {
+        Digitized(int alphabet_type)
+                : abc(esl_alphabet_Create(alphabet_type), esl_alphabet_Destroy) {}
+
+        std::unique_ptr<ESL_ALPHABET, void(*)(ESL_ALPHABET*)> abc;
+        std::vector<ESLSeqPtr> seqs;
+    };
+
+    const path_extend::ScaffoldSequenceMaker &scaffold_maker_;
+    std::vector<const path_extend::BidirectionalPath*> paths_;
+    std::map<int, Digitized> digitized_;
+};
+
+struct MatchResult {
+    ContigAlnInfo alns;
+    // Contig sequence for every alignment, for restricted_edges.fasta
+    std::vector<std::string> contigs;
+};
+
+static void MatchContigsInternal(hmmer::HMMMatcher &matcher, const MatchTargets &targets, size_t i,
+                                 const std::string &type, const std::string &desc,
+                                 MatchResult &res, size_t model_length,
+                                 int alphabet_type) {
+    bool isAA = alphabet_type == eslAMINO;
+    for (const auto &seq : targets.seqs(i, alphabet_type))
+        matcher.match(seq.get());
     matcher.summarize();
 
+    // The sequence is only needed for the hits, make it again instead of keeping all of them
+    std::string path_string;
     for (const auto &hit : matcher.hits()) {
         if (!hit.reported() || !hit.included())
             continue;
@@ -66,46 +146,31 @@ static void MatchContigsInternal(hmmer::HMMMatcher &matcher, const path_extend::
             seqpos.first = seqpos.first * (isAA ? 3 : 1)  + shift;
             seqpos.second = seqpos.second * (isAA ? 3 : 1)  + shift;
 
+            if (path_string.empty())
+                path_string = targets.sequence(i);
+
             std::string name(hit.name());
-#pragma omp critical
-            {
-                oss_contig << io::SingleRead(name, path_string);
-            }
             DEBUG(name);
             DEBUG("First - " << seqpos.first << ", second - " << seqpos.second);
-            res.push_back({name, type, desc,
-                           unsigned(seqpos.first), unsigned(seqpos.second),
-                           path_string.substr(seqpos.first, std::max(seqpos.second - seqpos.first, (int)path.g().k() + 1))});
+            res.alns.push_back({name, type, desc,
+                                unsigned(seqpos.first), unsigned(seqpos.second),
+                                path_string.substr(seqpos.first, std::max(seqpos.second - seqpos.first, (int)targets.path(i).g().k() + 1))});
+            res.contigs.push_back(path_string);
         }
     }
     matcher.reset_top_hits();
 }
 
-static void MatchContigs(const path_extend::PathContainer &contig_paths, const path_extend::ScaffoldSequenceMaker &scaffold_maker,
+static void MatchContigs(const MatchTargets &targets, size_t from, size_t to,
                          const hmmer::HMM &hmm, const hmmer::hmmer_cfg &cfg,
-                         ContigAlnInfo &res, io::OFastaReadStream &oss_contig) {
-    DEBUG("Total contigs: " << contig_paths.size());
+                         MatchResult &res) {
+    DEBUG("Total contigs: " << to - from);
     DEBUG("Model length - " << hmm.length());
     hmmer::HMMMatcher matcher(hmm, cfg);
-    bool isAA = hmm.abc()->type == eslAMINO;
-    for (auto iter = contig_paths.begin(); iter != contig_paths.end(); ++iter) {
-        const path_extend::BidirectionalPath &path = iter.get();
-        if (path.Length() <= 0)
-            continue;
-
-        std::string path_string = scaffold_maker.MakeSequence(path);
-        MatchContigsInternal(matcher, path, path_string,
+    for (size_t i = from; i < to; ++i) {
+        MatchContigsInternal(matcher, targets, i,
                              hmm.name(), hmm.desc() ? hmm.desc() : "",
-                             res, oss_contig, hmm.length(), isAA);
-
-        const path_extend::BidirectionalPath& conj_path = iter.getConjugate();
-        if (conj_path.Length() <= 0)
-            continue;
-
-        std::string path_string_conj = scaffold_maker.MakeSequence(conj_path);
-        MatchContigsInternal(matcher, conj_path, path_string_conj,
-                             hmm.name(), hmm.desc() ? hmm.desc() : "",
-                             res, oss_contig, hmm.length(), isAA);
+                             res, hmm.length(), hmm.abc()->type);
     }
 }
 
@@ -198,24 +263,36 @@ ContigAlnInfo DomainMatcher::MatchDomains(debruijn_graph::GraphPack &gp,
     // so it will be a bit conservative for nucleotide HMMs / sequences
     hcfg.Z = 3 * broken_scaffolds.size();
 
-#   pragma omp parallel for
-    for (size_t i = 0; i < hmms.size(); ++i) {
-        ContigAlnInfo local_res;
-        std::string name = hmms[i].name();
-#       pragma omp critical
-        {
-            INFO("Matching contigs with " << name);
-        }
-
-        MatchContigs(broken_scaffolds, scaffold_maker,
+    MatchTargets targets(broken_scaffolds, scaffold_maker);
+    for (const auto &hmm : hmms)
+        targets.Prepare(hmm.abc()->type);
+
+    // Every HMM is matched against chunks of the contigs, so that there is
+    // enough work for all the threads even for a few HMMs
+    size_t nthreads = (size_t) omp_get_max_threads();
+    size_t chunks = std::max<size_t>(1, std::min(targets.size(), (4 * nthreads + hmms.size() - 1) / std::max<size_t>(hmms.size(), 1)));
+    std::vector<MatchResult> results(hmms.size() * chunks);
+    INFO("Matching " << targets.size() << " contigs with " << hmms.size() << " HMMs in " << chunks << " chunk(s) each");
+
+#   pragma omp parallel for schedule(dynamic)
+    for (size_t tile = 0; tile < results.size(); ++tile) {
+        size_t i = tile / chunks, chunk = tile % chunks;
+        MatchContigs(targets, chunk * targets.size() / chunks, (chunk + 1) * targets.size() / chunks,
                      hmms[i], hcfg,
-                     local_res, oss_contig);
+                     results[tile]);
+    }
 
-#       pragma omp critical
-        {
-            INFO("Matches for '" << name << "': " << local_res.size());
-            res.insert(res.end(), std::make_move_iterator(local_res.begin()), std::make_move_iterator(local_res.end()));
+    for (size_t i = 0; i < hmms.size(); ++i) {
+        size_t matches = 0;
+        for (size_t chunk = 0; chunk < chunks; ++chunk) {
+            MatchResult &local_res = results[i * chunks + chunk];
+            for (size_t j = 0; j < local_res.alns.size(); ++j)
+                oss_contig << io::SingleRead(local_res.alns[j].name, local_res.contigs[j]);
+            matches += local_res.alns.size();
+            res.insert(res.end(), std::make_move_iterator(local_res.alns.begin()), std::make_move_iterator(local_res.alns.end()));
+            local_res = MatchResult();
         }
+        INFO("Matches for '" << hmms[i].name() << "': " << matches);
     }
 
     INFO("Total domain matches: " << res.size());
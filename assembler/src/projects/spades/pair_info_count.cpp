@@ -196,7 +196,13 @@ bool ShouldObtainSingleReadsPaths(size_t ilib) {
     return false;
 }
 
-bool CollectLibInformation(const GraphPack &gp,
+// All the passes over paired reads of the library map the same reads with the
+// same mapper, so the mappings are computed once and then read from the cache
+std::string PairedCacheKey(size_t ilib) {
+    return "paired_" + std::to_string(ilib);
+}
+
+bool CollectLibInformation(GraphPack &gp,
                            size_t &edgepairs,
                            size_t ilib, size_t edge_length_threshold) {
     INFO("Estimating insert size (takes a while)");
@@ -212,7 +218,8 @@ bool CollectLibInformation(const GraphPack &gp,
     auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, /*insert_size*/0,
                                                 /*include_merged*/true);
 
-    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads));
+    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads),
+                            gp.get_mutable<MappingCache>(), PairedCacheKey(ilib));
     //Check read length after lib processing since mate pairs a not used until this step
     VERIFY(reads.data().unmerged_read_length != 0);
 
@@ -320,7 +327,8 @@ void ProcessPairedReads(GraphPack &gp,
 
     auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, (size_t) data.mean_insert_size,
                                                 /*include merged*/true);
-    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads));
+    notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads),
+                            gp.get_mutable<MappingCache>(), PairedCacheKey(ilib));
 }
 
 } // namespace
@@ -395,7 +403,8 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
 
                         VERIFY(lib.data().unmerged_read_length != 0);
                         auto reads = paired_binary_readers(lib, /*followed by rc*/false, 0, /*include merged*/true);
-                        notifier.ProcessLibrary(reads, i, *ChooseProperMapper(gp, lib));
+                        notifier.ProcessLibrary(reads, i, *ChooseProperMapper(gp, lib),
+                                                gp.get_mutable<MappingCache>(), PairedCacheKey(i));
                     }
                 }
 
@@ -414,6 +423,9 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
             }
         }
     }
+
+    // Recorded paired read mappings are not needed past this stage
+    gp.get_mutable<MappingCache>().Clear();
 }
 
 } // namespace debruijn_graph
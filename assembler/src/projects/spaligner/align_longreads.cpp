@@ -14,6 +14,7 @@
 #include "io/graph/gfa_writer.hpp"
 #include "assembly_graph/core/graph.hpp"
 #include "utils/logger/log_writers.hpp"
+#include "utils/parallel/ordered_pipeline.hpp"
 #include "modules/alignment/pacbio/g_aligner.hpp"
 
 #include "mapping_printer.hpp"
@@ -104,29 +105,42 @@ class LongReadsAligner {
           cfg_(cfg),
           galigner_(g_, cfg),
           threads_(threads),
-          mapping_printer_hub_(g_, edge_namer, output_dir, cfg.output_format) {
-        aligned_reads_ = 0;
-        processed_reads_ = 0;
-    }
+          mapping_printer_hub_(g_, edge_namer, output_dir, cfg.output_format) {}
 
+    // Reads are aligned one by one by whichever thread is free, so a single
+    // long read does not hold the others. The results are written in the
+    // input order, at most read_buffer_size reads are kept in memory
     void RunAligner() {
         auto read_stream = io::FixingWrapper(io::FileReadStream(cfg_.path_to_sequences));
-        size_t n = 0;
-        size_t buffer_no = 0;
-        while (!read_stream.eof()) {
-            std::vector<io::SingleRead> read_buffer;
-            read_buffer.reserve(read_buffer_size);
-            io::SingleRead read;
-            for (size_t buf_size = 0; buf_size < read_buffer_size && !read_stream.eof(); ++buf_size) {
-                read_stream >> read;
-                read_buffer.push_back(move(read));
-            }
-            INFO("Prepared batch " << buffer_no << " of " << read_buffer.size() << " reads.");
-            AlignBatch(read_buffer);
-            ++buffer_no;
-            n += read_buffer.size();
-            INFO("Processed " << n << " reads");
-        }
+
+        size_t processed = 0, aligned = 0;
+        utils::OrderedPipeline<ReadTask>((unsigned) std::max(threads_, 1), read_buffer_size).Run(
+            [&](ReadTask &task) {
+                if (read_stream.eof())
+                    return false;
+                read_stream >> task.read;
+                return true;
+            },
+            [&](ReadTask &task) {
+                OneReadMapping res = AlignRead(task.read);
+                task.aligned = res.edge_paths.size() > 0;
+                if (task.aligned)
+                    task.output = mapping_printer_hub_.FormatMapping(res, task.read);
+            },
+            [&](const ReadTask &task) {
+                if (task.aligned) {
+                    mapping_printer_hub_.Write(task.output);
+                    aligned += 1;
+                }
+                processed += 1;
+
+                if (processed % progress_step == 0)
+                    INFO("Processed " << processed << " reads, aligned reads: " << aligned * 100 / processed <<
+                         "\% (" << aligned << " out of " << processed << ")");
+            });
+
+        INFO("Processed " << processed << " reads, aligned reads: " << (processed ? aligned * 100 / processed : 0) <<
+             "\% (" << aligned << " out of " << processed << ")");
     }
 
   private:
@@ -145,43 +159,20 @@ class LongReadsAligner {
         return current_read_mapping;
     }
 
-    void AlignBatch(const vector<io::SingleRead> &reads) {
-        size_t step = 10;
-        processed_reads_ = 0;
-        aligned_reads_ = 0;
-        #pragma omp parallel for schedule(guided, 50) num_threads(threads_)
-        for (size_t i = 0 ; i < reads.size(); ++i) {
-            OneReadMapping res = AlignRead(reads[i]);
-            if (res.edge_paths.size() > 0) {
-                mapping_printer_hub_.SaveMapping(res, reads[i]);
-            }
-            #pragma omp critical(aligner)
-            {
-                if (res.edge_paths.size() > 0) {
-                    aligned_reads_ ++;
-                }
-                processed_reads_ ++;
-                if (processed_reads_ * 100 / reads.size() >= step) {
-                    INFO("Processed \% reads: " << processed_reads_ * 100 / reads.size() <<
-                         "\%, Aligned reads: " << aligned_reads_ * 100 / processed_reads_ <<
-                         "\% (" << aligned_reads_ << " out of " << processed_reads_ << ")")
-                    step += 10;
-                }
-            }
-        }
-    }
+    struct ReadTask {
+        io::SingleRead read;
+        bool aligned = false;
+        std::vector<std::string> output;
+    };
 
     const size_t read_buffer_size = 50000;
+    const size_t progress_step = 10000;
 
     const debruijn_graph::ConjugateDeBruijnGraph &g_;
     const GAlignerConfig &cfg_;
     const sensitive_aligner::GAligner galigner_;
     const int threads_;
     MappingPrinterHub mapping_printer_hub_;
-
-    int aligned_reads_;
-    int processed_reads_;
-
 };
 
 void LoadGraph(const string &saves_path, debruijn_graph::ConjugateDeBruijnGraph &g, io::IdMapper<std::string> &id_mapper) {
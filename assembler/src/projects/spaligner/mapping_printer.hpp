@@ -24,7 +24,12 @@ class MappingPrinter {
     : g_(g), edge_namer_(edge_namer), output_dir_(output_dir)
   {}
 
-  virtual void SaveMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) = 0;
+  // Formatting is thread-safe, writing is not
+  virtual std::string FormatMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) const = 0;
+
+  void Write(const std::string &str) {
+    output_file_ << str;
+  }
 
   virtual ~MappingPrinter () {};
 
@@ -48,7 +53,7 @@ class MappingPrinterTSV: public MappingPrinter {
     output_file_.open(output_dir_ + "/alignment.tsv", std::ofstream::out);
   }
 
-  void SaveMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) override;
+  std::string FormatMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) const override;
 
   ~MappingPrinterTSV() {
     output_file_.close();
@@ -66,7 +71,7 @@ class MappingPrinterFasta: public MappingPrinter {
     output_file_.open(output_dir_ + "/alignment.fasta", std::ofstream::out);
   }
 
-  void SaveMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) override;
+  std::string FormatMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) const override;
 
   ~MappingPrinterFasta() {
     output_file_.close();
@@ -104,7 +109,7 @@ class MappingPrinterGPA : public MappingPrinter {
                             const std::vector<Range> &edgeranges,
                             int &nameIndex, const PathRange &path_range) const;
 
-  void SaveMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) override;
+  std::string FormatMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) const override;
 
   ~MappingPrinterGPA() {
     output_file_.close();
@@ -129,9 +134,19 @@ class MappingPrinterHub {
     }
   }
 
-  void SaveMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read)  {
+  std::vector<std::string> FormatMapping(const sensitive_aligner::OneReadMapping &aligned_mappings, const io::SingleRead &read) const {
+    std::vector<std::string> res;
+    res.reserve(mapping_printers_.size());
     for (auto printer : mapping_printers_) {
-      printer->SaveMapping(aligned_mappings, read);
+      res.push_back(printer->FormatMapping(aligned_mappings, read));
+    }
+    return res;
+  }
+
+  void Write(const std::vector<std::string> &formatted) {
+    VERIFY(formatted.size() == mapping_printers_.size());
+    for (size_t i = 0; i < mapping_printers_.size(); ++i) {
+      mapping_printers_[i]->Write(formatted[i]);
     }
   }
 
@@ -0,0 +1,104 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include "adt/concurrent_dsu.hpp"
+#include "assembly_graph/core/graph.hpp"
+#include "paired_info/concurrent_pair_info_buffer.hpp"
+
+#include <memory>
+
+namespace bench {
+
+using namespace debruijn_graph;
+
+static const size_t DSU_SIZE = 1 << 22;
+static const size_t DSU_UNIONS = 1 << 22;
+
+static const size_t PAIRED_EDGES = 10000;
+static const size_t PAIRED_POINTS = 1 << 20;
+
+// Unions of random elements, the same pattern as in the k-mer clustering
+SPADES_BENCHMARK(ConcurrentDSU_Unite) {
+    static std::vector<std::pair<size_t, size_t>> unions = [] {
+        std::mt19937_64 rng(seed());
+        std::vector<std::pair<size_t, size_t>> res(DSU_UNIONS);
+        for (auto &entry : res)
+            entry = { rng() % DSU_SIZE, rng() % DSU_SIZE };
+        return res;
+    }();
+
+    std::unique_ptr<dsu::ConcurrentDSU> dsu;
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        dsu = std::make_unique<dsu::ConcurrentDSU>(DSU_SIZE);
+        state.ResumeTiming();
+
+#       pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < unions.size(); ++i)
+            dsu->unite(unions[i].first, unions[i].second);
+    }
+    VERIFY(dsu->num_sets() < DSU_SIZE);
+    state.SetItemsProcessed(state.iterations() * unions.size());
+}
+
+// Graph with chain of PAIRED_EDGES edges, only edge ids matter
+struct PairedFixture {
+    PairedFixture()
+            : graph(21) {
+        std::mt19937_64 rng(seed());
+        VertexId v = graph.AddVertex();
+        for (size_t i = 0; i < PAIRED_EDGES; ++i) {
+            VertexId next = graph.AddVertex();
+            edges.push_back(graph.AddEdge(v, next, Sequence(RandomGenome(graph.k() + 100, rng))));
+            v = next;
+        }
+
+        // Power-law-like choice of the second edge mimics the paired reads
+        // hitting the neighbouring edges
+        for (size_t i = 0; i < PAIRED_POINTS; ++i) {
+            size_t first = rng() % edges.size();
+            size_t second = std::min(edges.size() - 1, first + (rng() % 16) * (rng() % 16));
+            points.push_back({ edges[first], edges[second],
+                               omnigraph::de::RawPoint(float(rng() % 1000), 1) });
+        }
+    }
+
+    static PairedFixture &get() {
+        static PairedFixture fixture;
+        return fixture;
+    }
+
+    struct Point {
+        EdgeId e1, e2;
+        omnigraph::de::RawPoint p;
+    };
+
+    Graph graph;
+    std::vector<EdgeId> edges;
+    std::vector<Point> points;
+};
+
+SPADES_BENCHMARK(ConcurrentPairedBuffer_Add) {
+    const auto &fixture = PairedFixture::get();
+    omnigraph::de::ConcurrentPairedInfoBuffer<Graph> buffer(fixture.graph);
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        buffer.clear();
+        state.ResumeTiming();
+
+        const auto &points = fixture.points;
+#       pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < points.size(); ++i)
+            buffer.Add(points[i].e1, points[i].e2, points[i].p);
+    }
+    VERIFY(buffer.size() > 0);
+    state.SetItemsProcessed(state.iterations() * fixture.points.size());
+}
+
+}
@@ -0,0 +1,188 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "bench.hpp"
+
+#include "toolchain/utils.hpp"
+#include "utils/filesystem/path_helper.hpp"
+#include "version.hpp"
+
+#include <cxxopts/cxxopts.hpp>
+
+#include <algorithm>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <regex>
+
+#include <omp.h>
+
+namespace bench {
+
+namespace {
+
+unsigned seed_ = 42;
+unsigned threads_ = 1;
+std::string workdir_ = "./tmp";
+
+struct Result {
+    std::string name;
+    size_t iterations;
+    double seconds;
+    size_t items;
+    size_t bytes;
+
+    double ns_per_iteration() const { return seconds * 1e9 / double(iterations); }
+    double items_per_second() const { return double(items) / seconds; }
+    double bytes_per_second() const { return double(bytes) / seconds; }
+};
+
+Result Measure(const Benchmark &benchmark, double min_time, size_t max_iterations) {
+    size_t iterations = 1;
+    while (true) {
+        State state(iterations);
+        benchmark.func(state);
+        if (state.seconds() >= min_time || iterations >= max_iterations)
+            return { benchmark.name, iterations, state.seconds(), state.items(), state.bytes() };
+
+        // Aim at 1.4x of the minimal time, but do not grow too fast on noisy short runs
+        double multiplier = min_time * 1.4 / std::max(state.seconds(), 1e-9);
+        multiplier = std::min(std::max(multiplier, 2.0), 10.0);
+        iterations = std::min(max_iterations, size_t(double(iterations) * multiplier));
+    }
+}
+
+std::string JsonEscape(const std::string &s) {
+    std::string res;
+    for (char c : s) {
+        if (c == '"' || c == '\\')
+            res += '\\';
+        res += c;
+    }
+    return res;
+}
+
+void WriteJson(std::ostream &os, const std::vector<Result> &results) {
+    char date[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    os << std::setprecision(10);
+    os << "{\n"
+       << "  \"context\": {\n"
+       << "    \"date\": \"" << date << "\",\n"
+       << "    \"git_revision\": \"" << JsonEscape(version::gitrev()) << "\",\n"
+       << "    \"threads\": " << threads_ << ",\n"
+       << "    \"seed\": " << seed_ << "\n"
+       << "  },\n"
+       << "  \"benchmarks\": [";
+    std::string delim = "\n";
+    for (const auto &result : results) {
+        os << delim
+           << "    {\n"
+           << "      \"name\": \"" << JsonEscape(result.name) << "\",\n"
+           << "      \"iterations\": " << result.iterations << ",\n"
+           << "      \"real_time\": " << result.ns_per_iteration() << ",\n"
+           << "      \"time_unit\": \"ns\"";
+        if (result.items)
+            os << ",\n      \"items_per_second\": " << result.items_per_second();
+        if (result.bytes)
+            os << ",\n      \"bytes_per_second\": " << result.bytes_per_second();
+        os << "\n    }";
+        delim = ",\n";
+    }
+    os << "\n  ]\n}\n";
+}
+
+void PrintResult(const Result &result) {
+    std::cout << std::left << std::setw(40) << result.name << std::right
+              << std::setw(14) << std::fixed << std::setprecision(1) << result.ns_per_iteration() << " ns"
+              << std::setw(12) << result.iterations;
+    if (result.items)
+        std::cout << std::setw(14) << std::setprecision(3) << result.items_per_second() / 1e6 << " M items/s";
+    if (result.bytes)
+        std::cout << std::setw(14) << std::setprecision(3) << result.bytes_per_second() / 1e6 << " MB/s";
+    std::cout << std::endl;
+}
+
+}
+
+std::vector<Benchmark> &registry() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+unsigned seed() { return seed_; }
+unsigned threads() { return threads_; }
+const std::string &workdir() { return workdir_; }
+
+}
+
+int main(int argc, char** argv) {
+    using namespace bench;
+
+    try {
+        std::string filter, json_fn;
+        double min_time;
+        size_t max_iterations;
+        bool list = false;
+
+        cxxopts::Options options(argv[0], " microbenchmarks of SPAdes core routines");
+        options.add_options()
+                ("f,filter", "Run only benchmarks matching the regex", cxxopts::value<std::string>(filter)->default_value(".*"))
+                ("j,json", "File to store results in JSON format", cxxopts::value<std::string>(json_fn), "file")
+                ("min-time", "Minimal measured time per benchmark, in seconds", cxxopts::value<double>(min_time)->default_value("0.5"))
+                ("max-iterations", "Maximal number of iterations per benchmark", cxxopts::value<size_t>(max_iterations)->default_value("1000000000"))
+                ("s,seed", "Random seed for the synthetic inputs", cxxopts::value<unsigned>(seed_)->default_value("42"))
+                ("t,threads", "Number of threads for the parallel benchmarks", cxxopts::value<unsigned>(threads_)->default_value("1"))
+                ("w,workdir", "Working directory (default: ./tmp)", cxxopts::value<std::string>(workdir_)->default_value("./tmp"), "dir")
+                ("l,list", "List benchmarks and exit", cxxopts::value<bool>(list))
+                ("h,help", "Print help");
+
+        options.parse(argc, argv);
+        if (options.count("help")) {
+            std::cout << options.help() << std::endl;
+            exit(0);
+        }
+
+        auto benchmarks = registry();
+        std::sort(benchmarks.begin(), benchmarks.end(),
+                  [](const Benchmark &lhs, const Benchmark &rhs) { return lhs.name < rhs.name; });
+        std::regex re(filter);
+        benchmarks.erase(std::remove_if(benchmarks.begin(), benchmarks.end(),
+                                        [&](const Benchmark &b) { return !std::regex_search(b.name, re); }),
+                         benchmarks.end());
+
+        if (list) {
+            for (const auto &b : benchmarks)
+                std::cout << b.name << std::endl;
+            exit(0);
+        }
+
+        // Synthetic input preparation might be verbose, keep only warnings
+        toolchain::create_console_logger(logging::L_WARN);
+        fs::make_dir(workdir_);
+        omp_set_num_threads(threads_);
+
+        std::vector<Result> results;
+        for (const auto &b : benchmarks) {
+            results.push_back(Measure(b, min_time, max_iterations));
+            PrintResult(results.back());
+        }
+
+        if (!json_fn.empty()) {
+            std::ofstream os(json_fn);
+            WriteJson(os, results);
+        }
+    } catch (const std::string &s) {
+        std::cerr << s;
+        return EINTR;
+    } catch (const cxxopts::OptionException &e) {
+        std::cerr << "error parsing options: " << e.what() << std::endl;
+        exit(1);
+    }
+}
@@ -0,0 +1,98 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/perf/perfcounter.hpp"
+#include "utils/verify.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+/**
+ * Tiny google-benchmark-like harness. Benchmark body does its setup, then
+ * runs the measured part in the `while (state.KeepRunning())` loop; the
+ * runner calls the body with increasing number of iterations until the
+ * measured time exceeds the requested minimum.
+ */
+class State {
+public:
+    explicit State(size_t iterations)
+            : iterations_(iterations), done_(0), seconds_(0), running_(false),
+              items_(0), bytes_(0) {}
+
+    bool KeepRunning() {
+        if (done_ == 0 && !running_)
+            ResumeTiming();
+        if (done_ < iterations_) {
+            done_ += 1;
+            return true;
+        }
+        PauseTiming();
+        return false;
+    }
+
+    void PauseTiming() {
+        if (!running_)
+            return;
+        seconds_ += timer_.time();
+        running_ = false;
+    }
+
+    void ResumeTiming() {
+        VERIFY(!running_);
+        timer_.reset();
+        running_ = true;
+    }
+
+    // Amounts of work per whole run, not per iteration
+    void SetItemsProcessed(size_t items) { items_ = items; }
+    void SetBytesProcessed(size_t bytes) { bytes_ = bytes; }
+
+    size_t iterations() const { return iterations_; }
+    double seconds() const { return seconds_; }
+    size_t items() const { return items_; }
+    size_t bytes() const { return bytes_; }
+
+private:
+    size_t iterations_;
+    size_t done_;
+    double seconds_;
+    bool running_;
+    size_t items_;
+    size_t bytes_;
+    utils::perf_counter timer_;
+};
+
+typedef std::function<void(State&)> BenchmarkFunc;
+
+struct Benchmark {
+    std::string name;
+    BenchmarkFunc func;
+};
+
+std::vector<Benchmark> &registry();
+
+struct Registrar {
+    Registrar(const char *name, BenchmarkFunc func) {
+        registry().push_back({ name, std::move(func) });
+    }
+};
+
+// Common parameters of the run, set from the command line
+unsigned seed();
+unsigned threads();
+const std::string &workdir();
+
+}
+
+#define SPADES_BENCHMARK(name)                                          \
+    static void name(bench::State &state);                              \
+    static bench::Registrar name##_registrar(#name, name);              \
+    static void name(bench::State &state)
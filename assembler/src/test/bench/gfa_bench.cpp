@@ -0,0 +1,81 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include "io/graph/gfa_reader.hpp"
+#include "io/graph/gfa_writer.hpp"
+#include "io/reads/rc_reader_wrapper.hpp"
+#include "io/reads/read_stream_vector.hpp"
+#include "io/reads/vector_reader.hpp"
+#include "modules/graph_construction.hpp"
+#include "utils/filesystem/path_helper.hpp"
+#include "utils/filesystem/temporary.hpp"
+
+#include <fstream>
+
+namespace bench {
+
+using namespace debruijn_graph;
+
+static const unsigned K = 55;
+static const size_t GENOME_LENGTH = 1000000;
+static const size_t READ_LENGTH = 150;
+static const size_t READ_COUNT = 150000;
+
+// GFA of the graph built from the reads with errors: plenty of tips and bulges
+struct GFAFixture {
+    GFAFixture()
+            : workdir(fs::tmp::make_temp_dir(bench::workdir(), "gfa_bench")) {
+        std::mt19937_64 rng(seed());
+        std::string genome = RandomGenome(GENOME_LENGTH, rng);
+        io::ReadStreamList<io::SingleRead> streams(
+            io::RCWrap<io::SingleRead>(io::VectorReadStream<io::SingleRead>(
+                SimulateReads(genome, READ_COUNT, READ_LENGTH, 1, rng))));
+
+        Graph graph(K);
+        ConstructGraph(config::debruijn_config::construction(), workdir, streams, graph);
+
+        filename = fs::append_path(workdir->dir(), "graph.gfa");
+        std::ofstream os(filename);
+        gfa::GFAWriter(graph, os).WriteSegmentsAndLinks();
+        os.close();
+
+        bytes = fs::filesize(filename);
+        segments = graph.e_size() / 2;
+    }
+
+    static GFAFixture &get() {
+        static GFAFixture fixture;
+        return fixture;
+    }
+
+    fs::TmpDir workdir;
+    std::string filename;
+    size_t bytes;
+    size_t segments;
+};
+
+SPADES_BENCHMARK(GFAReader_ToGraph) {
+    const auto &fixture = GFAFixture::get();
+    size_t edges = 0;
+    while (state.KeepRunning()) {
+        Graph graph(K);
+        gfa::GFAReader gfa(fixture.filename);
+        gfa.to_graph(graph);
+        edges += graph.e_size();
+
+        state.PauseTiming();
+        graph.clear();
+        state.ResumeTiming();
+    }
+    VERIFY(edges > 0);
+    state.SetItemsProcessed(state.iterations() * fixture.segments);
+    state.SetBytesProcessed(state.iterations() * fixture.bytes);
+}
+
+}
@@ -0,0 +1,122 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include "assembly_graph/core/compact_topology.hpp"
+#include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+
+namespace bench {
+
+using namespace debruijn_graph;
+
+static const unsigned K = 55;
+static const size_t VERTEX_COUNT = 100000;
+static const size_t EDGE_COUNT = 200000;
+static const size_t MAX_EDGE_LENGTH = 200;
+static const size_t DIJKSTRA_BOUND = 1000;
+
+// Random graph of short edges, its compact topology and the vertices to start from
+struct GraphFixture {
+    GraphFixture()
+            : graph(K) {
+        std::mt19937_64 rng(seed());
+
+        for (size_t i = 0; i < VERTEX_COUNT; ++i) {
+            VertexId v = graph.AddVertex();
+            vertices.push_back(v);
+            vertices.push_back(graph.conjugate(v));
+        }
+        for (size_t i = 0; i < EDGE_COUNT; ++i) {
+            std::string s = RandomGenome(K + 1 + rng() % MAX_EDGE_LENGTH, rng);
+            graph.AddEdge(vertices[rng() % vertices.size()], vertices[rng() % vertices.size()], Sequence(s));
+        }
+        std::shuffle(vertices.begin(), vertices.end(), rng);
+
+        topology = std::make_unique<omnigraph::CompactTopology<Graph>>(graph);
+    }
+
+    static GraphFixture &get() {
+        static GraphFixture fixture;
+        return fixture;
+    }
+
+    Graph graph;
+    std::vector<VertexId> vertices;
+    std::unique_ptr<omnigraph::CompactTopology<Graph>> topology;
+};
+
+SPADES_BENCHMARK(Graph_Traversal) {
+    const auto &fixture = GraphFixture::get();
+    const Graph &g = fixture.graph;
+    size_t checksum = 0;
+    while (state.KeepRunning()) {
+        for (VertexId v : fixture.vertices) {
+            for (EdgeId e : g.OutgoingEdges(v))
+                checksum += g.length(e) + g.EdgeEnd(e).int_id();
+        }
+    }
+    VERIFY(checksum > 0);
+    state.SetItemsProcessed(state.iterations() * fixture.vertices.size());
+}
+
+SPADES_BENCHMARK(CompactTopology_Traversal) {
+    const auto &fixture = GraphFixture::get();
+    const auto &topology = *fixture.topology;
+    size_t checksum = 0;
+    while (state.KeepRunning()) {
+        for (VertexId v : fixture.vertices) {
+            for (EdgeId e : topology.OutgoingEdges(v))
+                checksum += topology.length(e) + topology.EdgeEnd(e).int_id();
+        }
+    }
+    VERIFY(checksum > 0);
+    state.SetItemsProcessed(state.iterations() * fixture.vertices.size());
+}
+
+SPADES_BENCHMARK(CompactTopology_Rebuild) {
+    auto &fixture = GraphFixture::get();
+    while (state.KeepRunning())
+        fixture.topology->Rebuild();
+    state.SetItemsProcessed(state.iterations() * fixture.graph.e_size());
+}
+
+// Every iteration runs a single Dijkstra from the next start vertex, the
+// reached vertices are counted as the items
+template<class DijkstraFactory>
+static void RunDijkstras(State &state, const DijkstraFactory &factory) {
+    const auto &fixture = GraphFixture::get();
+    size_t checksum = 0, start = 0, reached = 0;
+    while (state.KeepRunning()) {
+        auto dijkstra = factory();
+        dijkstra.Run(fixture.vertices[start++ % fixture.vertices.size()]);
+        for (VertexId v : dijkstra.ReachedVertices()) {
+            checksum += dijkstra.GetDistance(v);
+            reached += 1;
+        }
+    }
+    VERIFY(checksum > 0);
+    state.SetItemsProcessed(reached);
+}
+
+SPADES_BENCHMARK(Graph_BoundedDijkstra) {
+    const auto &fixture = GraphFixture::get();
+    RunDijkstras(state, [&]() {
+        return omnigraph::DijkstraHelper<Graph>::CreateBoundedDijkstra(fixture.graph, DIJKSTRA_BOUND);
+    });
+}
+
+SPADES_BENCHMARK(CompactTopology_BoundedDijkstra) {
+    const auto &fixture = GraphFixture::get();
+    RunDijkstras(state, [&]() {
+        return omnigraph::DijkstraHelper<Graph>::CreateCompactBoundedDijkstra(fixture.graph, *fixture.topology,
+                                                                             DIJKSTRA_BOUND);
+    });
+}
+
+}
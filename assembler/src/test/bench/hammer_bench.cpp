@@ -0,0 +1,165 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include "projects/hammer/config_struct_hammer.hpp"
+#include "projects/hammer/globals.hpp"
+#include "projects/hammer/hamcluster.hpp"
+#include "projects/hammer/hammer_tools.hpp"
+#include "projects/hammer/kmer_cluster.hpp"
+#include "projects/hammer/kmer_data.hpp"
+
+#include "adt/concurrent_dsu.hpp"
+#include "utils/filesystem/path_helper.hpp"
+#include "utils/filesystem/temporary.hpp"
+
+#include <boost/property_tree/info_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+namespace bench {
+
+static const size_t HAMMER_GENOME_LENGTH = 200000;
+static const size_t HAMMER_READ_LENGTH = 100;
+static const size_t HAMMER_READ_COUNT = 60000;
+static const unsigned HAMMER_MAX_THREADS = 64;
+
+// Hamming clusters of the k-mers from the reads with low quality errors,
+// everything BayesHammer has on the input of the subclustering
+struct HammerFixture {
+    HammerFixture()
+            : workdir(fs::tmp::make_temp_dir(bench::workdir(), "hammer_bench")) {
+        std::mt19937_64 rng(seed());
+        std::string genome = RandomGenome(HAMMER_GENOME_LENGTH, rng);
+
+        // The dataset resolves relative paths against its own location. About
+        // one low quality substitution per read, as BayesHammer expects them.
+        std::string reads = fs::make_full_path(workdir->dir() + "/reads.fastq");
+        {
+            std::ofstream os(reads);
+            for (const auto &read : SimulateReads(genome, HAMMER_READ_COUNT, HAMMER_READ_LENGTH, 2, rng))
+                os << "@" << read.name() << "\n" << read.GetSequenceString() << "\n+\n"
+                   << read.GetPhredQualityString() << "\n";
+        }
+
+        std::string dataset = workdir->dir() + "/dataset.yaml";
+        std::ofstream(dataset) << "- type: single\n"
+                               << "  single reads: [" << reads << "]\n";
+
+        std::istringstream config(
+            "dataset " + dataset + "\n"
+            "input_working_dir " + workdir->dir() + "\n"
+            "input_trim_quality 4\n"
+            "input_qvoffset 33\n"
+            "output_dir " + workdir->dir() + "\n"
+            "general_do_everything_after_first_iteration 1\n"
+            "general_hard_memory_limit 250\n"
+            "general_max_nthreads " + std::to_string(threads()) + "\n"
+            "general_tau 1\n"
+            "general_max_iterations 1\n"
+            "general_debug 0\n"
+            "count_do 1\n"
+            "count_numfiles 16\n"
+            "count_merge_nthreads " + std::to_string(threads()) + "\n"
+            "count_split_buffer 0\n"
+            "count_filter_singletons 0\n"
+            "hamming_do 1\n"
+            "hamming_blocksize_quadratic_threshold 50\n"
+            "bayes_do 1\n"
+            "bayes_nthreads " + std::to_string(threads()) + "\n"
+            "bayes_singleton_threshold 0.995\n"
+            "bayes_nonsingleton_threshold 0.9\n"
+            "bayes_use_hamming_dist 0\n"
+            "bayes_discard_only_singletons 0\n"
+            "bayes_debug_output 0\n"
+            "bayes_hammer_mode 0\n"
+            "bayes_write_solid_kmers 0\n"
+            "bayes_write_bad_kmers 0\n"
+            "bayes_initial_refine 1\n"
+            "expand_do 0\n"
+            "expand_max_iterations 25\n"
+            "expand_nthreads " + std::to_string(threads()) + "\n"
+            "expand_write_each_iteration 0\n"
+            "expand_write_kmers_result 0\n"
+            "correct_do 0\n"
+            "correct_discard_bad 0\n"
+            "correct_use_threshold 1\n"
+            "correct_threshold 0.98\n"
+            "correct_nthreads " + std::to_string(threads()) + "\n"
+            "correct_readbuffer 100000\n"
+            "correct_stats 0\n");
+        boost::property_tree::ptree pt;
+        boost::property_tree::read_info(config, pt);
+        cfg::create_instance(pt);
+        cfg::get_writable().input_qvoffset = 33;
+        Globals::char_offset = 33;
+        Globals::InitializeQualityProbs();
+        hammer::InitializeSubKMerPositions(cfg::get().general_tau);
+
+        KMerDataCounter(cfg::get().count_numfiles).BuildKMerIndex(data);
+        dsu::ConcurrentDSU uf(data.size());
+        std::string ham_prefix = workdir->dir() + "/kmers.hamcls";
+        TauOneKMerHamClusterer().cluster(ham_prefix, data, uf);
+        clusters = workdir->dir() + "/kmers.hamming";
+        uf.extract_to_file(clusters);
+        KMerDataCounter(cfg::get().count_numfiles).FillKMerData(data);
+        kmers = data.size();
+
+        // Subclustering appends the cluster centers and marks the k-mers, so
+        // every run starts from the copy of the original data
+        snapshot = workdir->dir() + "/kmers.data";
+        std::ofstream os(snapshot, std::ios::binary);
+        data.binary_write(os);
+    }
+
+    std::unique_ptr<KMerData> Restore() const {
+        auto res = std::make_unique<KMerData>();
+        std::ifstream is(snapshot, std::ios::binary);
+        VERIFY(is.good());
+        res->binary_read(is, snapshot);
+        return res;
+    }
+
+    static HammerFixture &get() {
+        static HammerFixture fixture;
+        return fixture;
+    }
+
+    fs::TmpDir workdir;
+    KMerData data;
+    std::string clusters;
+    std::string snapshot;
+    size_t kmers;
+};
+
+// Subclustering of the same clusters, the scaling with the number of threads
+static void HammerSubclustering(State &state, unsigned nthreads) {
+    auto &fixture = HammerFixture::get();
+    std::unique_ptr<KMerData> data;
+    while (state.KeepRunning()) {
+        state.PauseTiming();
+        data = fixture.Restore();
+        state.ResumeTiming();
+
+        // Keep the cluster files around for the next iteration
+        KMerClustering(*data, nthreads, fixture.workdir->dir(), /* debug */ true).process(fixture.clusters);
+    }
+    state.SetItemsProcessed(state.iterations() * fixture.kmers);
+}
+
+static const bool kmer_clustering_registered = [] {
+    for (unsigned nthreads = 1; nthreads <= HAMMER_MAX_THREADS; nthreads *= 2)
+        registry().push_back({ "KMerClustering/" + std::to_string(nthreads),
+                               [nthreads](State &state) { HammerSubclustering(state, nthreads); } });
+    return true;
+}();
+
+}
@@ -0,0 +1,126 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include "io/reads/rc_reader_wrapper.hpp"
+#include "io/reads/read_stream_vector.hpp"
+#include "io/reads/vector_reader.hpp"
+#include "modules/alignment/edge_index.hpp"
+#include "modules/alignment/sequence_mapper.hpp"
+#include "modules/graph_construction.hpp"
+#include "pipeline/graph_pack.hpp"
+#include "utils/filesystem/temporary.hpp"
+#include "utils/kmer_mph/kmer_index_builder.hpp"
+#include "utils/kmer_mph/kmer_splitters.hpp"
+#include "utils/ph_map/perfect_hash_map_builder.hpp"
+#include "utils/ph_map/storing_traits.hpp"
+
+namespace bench {
+
+using namespace debruijn_graph;
+
+static const unsigned K = 55;
+static const size_t GENOME_LENGTH = 500000;
+static const size_t READ_LENGTH = 150;
+static const size_t READ_COUNT = 100000;
+static const size_t QUERY_COUNT = 20000;
+
+typedef io::VectorReadStream<io::SingleRead> RawStream;
+
+// Graph and indices over the error-free reads of the random genome
+struct IndexFixture {
+    typedef utils::PerfectHashMap<RtSeq, uint32_t, kmers::kmer_index_traits<RtSeq>, utils::DefaultStoring> KMerMap;
+
+    IndexFixture()
+            : workdir(fs::tmp::make_temp_dir(bench::workdir(), "index_bench")),
+              gp(K, workdir->dir(), 0),
+              kmer_map(K) {
+        std::mt19937_64 rng(seed());
+        std::string genome = RandomGenome(GENOME_LENGTH, rng);
+        auto reads = SimulateReads(genome, READ_COUNT, READ_LENGTH, 0, rng);
+        queries = SimulateReads(genome, QUERY_COUNT, READ_LENGTH, 3, rng);
+
+        io::ReadStreamList<io::SingleRead> streams(io::RCWrap<io::SingleRead>(RawStream(reads)));
+        auto &graph = gp.get_mutable<Graph>();
+        auto &index = gp.get_mutable<EdgeIndex<Graph>>();
+        ConstructGraphWithIndex(config::debruijn_config::construction(), workdir, streams, graph, index);
+        gp.get_mutable<KmerMapper<Graph>>().Attach();
+
+        typedef utils::DeBruijnReadKMerSplitter<io::SingleRead,
+                                                utils::StoringTypeFilter<utils::SimpleStoring>> Splitter;
+        kmers::KMerDiskCounter<RtSeq> counter(workdir, Splitter(workdir, K, streams));
+        utils::PerfectHashMapBuilder().BuildIndex(kmer_map, counter, 16, threads());
+
+        // Both the present and the absent k-mers are looked up
+        for (const auto &query : queries) {
+            const Sequence &s = query.sequence();
+            RtSeq kmer = s.start<RtSeq>(K) >> 'A';
+            for (size_t i = K - 1; i < s.size(); ++i) {
+                kmer <<= s[i];
+                kmers.push_back(kmer);
+            }
+        }
+    }
+
+    static IndexFixture &get() {
+        static IndexFixture fixture;
+        return fixture;
+    }
+
+    fs::TmpDir workdir;
+    GraphPack gp;
+    KMerMap kmer_map;
+    std::vector<io::SingleRead> queries;
+    std::vector<RtSeq> kmers;
+};
+
+SPADES_BENCHMARK(KMerIndex_SeqIdx) {
+    const auto &fixture = IndexFixture::get();
+    const auto &kmer_map = fixture.kmer_map;
+    size_t checksum = 0;
+    while (state.KeepRunning()) {
+        for (const RtSeq &kmer : fixture.kmers)
+            checksum += kmer_map.ConstructKWH(kmer).idx();
+    }
+    VERIFY(checksum != 42);
+    state.SetItemsProcessed(state.iterations() * fixture.kmers.size());
+}
+
+SPADES_BENCHMARK(KMerIndex_SeqIdxBatched) {
+    const auto &fixture = IndexFixture::get();
+    const auto &kmer_map = fixture.kmer_map;
+    std::vector<IndexFixture::KMerMap::KeyWithHash> kwhs;
+    size_t checksum = 0;
+    while (state.KeepRunning()) {
+        kmer_map.ConstructKWH(fixture.kmers.data(), fixture.kmers.size(), kwhs);
+        for (const auto &kwh : kwhs)
+            checksum += kwh.idx();
+    }
+    VERIFY(checksum != 42);
+    state.SetItemsProcessed(state.iterations() * fixture.kmers.size());
+}
+
+static void MapSequences(State &state, bool batched_lookup) {
+    auto &fixture = IndexFixture::get();
+    const auto &gp = fixture.gp;
+    BasicSequenceMapper<Graph, EdgeIndex<Graph>> mapper(gp.get<Graph>(), gp.get<EdgeIndex<Graph>>(),
+                                                        gp.get<KmerMapper<Graph>>(), true, batched_lookup);
+    size_t mapped = 0;
+    while (state.KeepRunning()) {
+        for (const auto &query : fixture.queries)
+            mapped += mapper.MapSequence(query.sequence()).size();
+    }
+    VERIFY(mapped > 0);
+    state.SetItemsProcessed(state.iterations() * fixture.queries.size());
+    state.SetBytesProcessed(state.iterations() * fixture.queries.size() * READ_LENGTH);
+}
+
+SPADES_BENCHMARK(BasicSequenceMapper_MapSequence) { MapSequences(state, false); }
+SPADES_BENCHMARK(BasicSequenceMapper_MapSequenceBatched) { MapSequences(state, true); }
+
+}
@@ -0,0 +1,97 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "bench.hpp"
+#include "synthetic.hpp"
+
+#include "sequence/canonical_kmer_roller.hpp"
+#include "sequence/rtseq.hpp"
+#include "sequence/sequence.hpp"
+
+namespace bench {
+
+static const size_t GENOME_LENGTH = 1 << 20;
+
+static const Sequence &Genome() {
+    static Sequence genome = [] {
+        std::mt19937_64 rng(seed());
+        return Sequence(RandomGenome(GENOME_LENGTH, rng));
+    }();
+    return genome;
+}
+
+// Rolls the k-mer along the whole genome, the way all the k-mer iterations do
+static void RtSeqShiftLeft(State &state, unsigned k) {
+    const Sequence &genome = Genome();
+    size_t checksum = 0;
+    while (state.KeepRunning()) {
+        RtSeq kmer = genome.start<RtSeq>(k);
+        for (size_t i = k; i < genome.size(); ++i) {
+            kmer <<= genome[i];
+            checksum += kmer.data()[0];
+        }
+    }
+    VERIFY(checksum != 42);
+    state.SetItemsProcessed(state.iterations() * (genome.size() - k));
+}
+
+static void RtSeqShiftRight(State &state, unsigned k) {
+    const Sequence &genome = Genome();
+    size_t checksum = 0;
+    while (state.KeepRunning()) {
+        RtSeq kmer = genome.start<RtSeq>(k);
+        for (size_t i = k; i < genome.size(); ++i) {
+            kmer >>= genome[i];
+            checksum += kmer.data()[0];
+        }
+    }
+    VERIFY(checksum != 42);
+    state.SetItemsProcessed(state.iterations() * (genome.size() - k));
+}
+
+// Canonical k-mer of every position: rolling the both strands and picking the minimal one
+static void RtSeqCanonical(State &state, unsigned k) {
+    const Sequence &genome = Genome();
+    size_t checksum = 0;
+    while (state.KeepRunning()) {
+        RtSeq kmer = genome.start<RtSeq>(k);
+        for (size_t i = k; i < genome.size(); ++i) {
+            kmer <<= genome[i];
+            RtSeq canonical = kmer.IsMinimal() ? kmer : !kmer;
+            checksum += canonical.data()[0];
+        }
+    }
+    VERIFY(checksum != 42);
+    state.SetItemsProcessed(state.iterations() * (genome.size() - k));
+}
+
+// The same with the reverse complement rolled along with the k-mer
+static void RtSeqCanonicalRoller(State &state, unsigned k) {
+    const Sequence &genome = Genome();
+    size_t checksum = 0;
+    while (state.KeepRunning()) {
+        CanonicalKMerRoller<RtSeq> kmer(genome.start<RtSeq>(k));
+        for (size_t i = k; i < genome.size(); ++i) {
+            kmer <<= genome[i];
+            checksum += kmer.canonical().data()[0];
+        }
+    }
+    VERIFY(checksum != 42);
+    state.SetItemsProcessed(state.iterations() * (genome.size() - k));
+}
+
+SPADES_BENCHMARK(RtSeqShiftLeft_K21) { RtSeqShiftLeft(state, 21); }
+SPADES_BENCHMARK(RtSeqShiftLeft_K55) { RtSeqShiftLeft(state, 55); }
+SPADES_BENCHMARK(RtSeqShiftLeft_K127) { RtSeqShiftLeft(state, 127); }
+SPADES_BENCHMARK(RtSeqShiftRight_K55) { RtSeqShiftRight(state, 55); }
+SPADES_BENCHMARK(RtSeqCanonical_K21) { RtSeqCanonical(state, 21); }
+SPADES_BENCHMARK(RtSeqCanonical_K55) { RtSeqCanonical(state, 55); }
+SPADES_BENCHMARK(RtSeqCanonical_K127) { RtSeqCanonical(state, 127); }
+SPADES_BENCHMARK(RtSeqCanonicalRoller_K21) { RtSeqCanonicalRoller(state, 21); }
+SPADES_BENCHMARK(RtSeqCanonicalRoller_K55) { RtSeqCanonicalRoller(state, 55); }
+SPADES_BENCHMARK(RtSeqCanonicalRoller_K127) { RtSeqCanonicalRoller(state, 127); }
+
+}
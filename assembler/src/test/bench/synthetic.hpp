@@ -0,0 +1,56 @@
+//***************************************************************************
+//* Copyright (c) 2020 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "bench.hpp"
+
+#include "io/reads/single_read.hpp"
+#include "sequence/nucl.hpp"
+#include "sequence/sequence_tools.hpp"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+inline std::string RandomGenome(size_t length, std::mt19937_64 &rng) {
+    std::string genome(length, 'A');
+    for (char &c : genome)
+        c = nucl((char)(rng() % 4));
+    return genome;
+}
+
+static const char SIMULATED_GOOD_QUALITY = 40;
+static const char SIMULATED_ERROR_QUALITY = 2;
+
+// Reads sampled uniformly from both strands with up to `max_errors` substitutions.
+// Substituted positions get low quality, the rest of the read is of high quality.
+inline std::vector<io::SingleRead> SimulateReads(const std::string &genome, size_t count,
+                                                 size_t read_length, size_t max_errors,
+                                                 std::mt19937_64 &rng) {
+    std::vector<io::SingleRead> reads;
+    reads.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string read = genome.substr(rng() % (genome.size() - read_length + 1), read_length);
+        std::string qual(read.size(), SIMULATED_GOOD_QUALITY);
+        for (size_t j = 0, errors = (max_errors ? rng() % (max_errors + 1) : 0); j < errors; ++j) {
+            size_t pos = rng() % read.size();
+            read[pos] = nucl((char)(rng() % 4));
+            qual[pos] = SIMULATED_ERROR_QUALITY;
+        }
+        if (rng() % 2) {
+            read = ReverseComplement(read);
+            std::reverse(qual.begin(), qual.end());
+        }
+        reads.emplace_back("read_" + std::to_string(i), read, qual);
+    }
+    return reads;
+}
+
+}
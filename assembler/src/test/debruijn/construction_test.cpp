@@ -8,18 +8,29 @@
 #include "io/reads/vector_reader.hpp"
 #include "io/reads/read_stream_vector.hpp"
 #include "io/reads/rc_reader_wrapper.hpp"
+#include "io/reads/coverage_filtering_read_wrapper.hpp"
 #include "utils/filesystem/path_helper.hpp"
 #include "utils/filesystem/temporary.hpp"
 #include "pipeline/graph_pack.hpp" // FIXME: get rid of it
 #include "modules/graph_construction.hpp"
 #include "modules/alignment/edge_index.hpp"
+#include "modules/alignment/sequence_mapper.hpp"
+#include "modules/alignment/sequence_mapper_notifier.hpp"
+#include "utils/kmer_mph/kmer_index_builder.hpp"
+#include "utils/kmer_mph/kmer_splitters.hpp"
+#include "utils/kmer_counting.hpp"
+#include "utils/ph_map/storing_traits.hpp"
+#include "io/binary/binary.hpp"
 
 #include "test_utils.hpp"
 #include "tmp_folder_fixture.hpp"
 
+#include <memory>
 #include <vector>
 #include <set>
 #include <string>
+#include <random>
+#include <sstream>
 
 #include <gtest/gtest.h>
 
@@ -106,3 +117,416 @@ TEST_F( GraphConstruction, SimpleTestEarlyPairedInfo ) {
 
     AssertGraph(3, paired_reads, 5, 6, edges, coverage_info, edge_pair_info);
 }
+
+static std::string RandomGenome(std::mt19937 &rng, size_t size) {
+    std::string res;
+    for (size_t i = 0; i < size; ++i)
+        res += nucl((char)(rng() % 4));
+    return res;
+}
+
+// Reads of the given length starting at the random positions of the genome
+static std::vector<std::string> RandomReads(std::mt19937 &rng, const std::string &genome,
+                                            size_t count, size_t length) {
+    std::vector<std::string> res;
+    for (size_t i = 0; i < count; ++i)
+        res.push_back(genome.substr(rng() % (genome.size() - length), length));
+    return res;
+}
+
+static std::vector<std::vector<RtSeq>> CountKMers(kmers::KMerCounter<RtSeq> &counter, unsigned buckets) {
+    auto storage = counter.Count(buckets, 1);
+    std::vector<std::vector<RtSeq>> res(storage.num_buckets());
+    for (size_t i = 0; i < storage.num_buckets(); ++i)
+        for (auto it = storage.bucket_begin(i); it != storage.bucket_end(i); ++it)
+            res[i].emplace_back(counter.k(), it->first);
+
+    return res;
+}
+
+TEST_F( GraphConstruction, InMemoryKMerCounting ) {
+    typedef io::VectorReadStream<io::SingleRead> RawStream;
+    typedef utils::DeBruijnReadKMerSplitter<io::SingleRead,
+                                            utils::StoringTypeFilter<utils::SimpleStoring>> Splitter;
+    const unsigned k = 21, buckets = 2;
+
+    std::mt19937 rng(42);
+    std::string genome = RandomGenome(rng, 20000);
+    std::vector<std::string> reads = RandomReads(rng, genome, 2000, 100);
+
+    io::ReadStreamList<io::SingleRead> streams(io::RCWrap<io::SingleRead>(RawStream(MakeReads(reads))));
+    auto workdir = fs::tmp::make_temp_dir(tmp_folder(), "tests");
+
+    kmers::KMerDiskCounter<RtSeq> disk_counter(workdir, Splitter(workdir, k, streams));
+    auto etalon = CountKMers(disk_counter, buckets);
+
+    kmers::KMerMemoryCounter<RtSeq> memory_counter(workdir, Splitter(workdir, k, streams));
+    EXPECT_EQ(etalon, CountKMers(memory_counter, buckets));
+
+    // Tiny memory budget forces the spill to disk
+    kmers::KMerMemoryCounter<RtSeq> spilling_counter(workdir, Splitter(workdir, k, streams), 1);
+    EXPECT_EQ(etalon, CountKMers(spilling_counter, buckets));
+
+    // Small splitting buffers produce many runs to be merged in memory
+    kmers::KMerMemoryCounter<RtSeq> merging_counter(workdir, Splitter(workdir, k, streams, 1));
+    EXPECT_EQ(etalon, CountKMers(merging_counter, buckets));
+}
+
+TEST_F( GraphConstruction, CoverageFiltering ) {
+    typedef io::VectorReadStream<io::SingleReadSeq> RawStream;
+    const unsigned k = 22, thr = 2;
+
+    std::mt19937 rng(42);
+    std::string genome = RandomGenome(rng, 5000);
+
+    // ~8x coverage of the genome and the reads with unique k-mers
+    std::vector<io::SingleReadSeq> genomic, random;
+    for (const auto &read : RandomReads(rng, genome, 400, 100))
+        genomic.emplace_back(Sequence(read));
+    for (size_t i = 0; i < 40; ++i)
+        random.emplace_back(Sequence(RandomGenome(rng, 100)));
+
+    io::ReadStreamList<io::SingleReadSeq> streams;
+    streams.push_back(RawStream(genomic));
+    streams.push_back(RawStream(random));
+
+    rolling_hash::SymmetricCyclicHash<rolling_hash::NDNASeqHash> hasher(k);
+    size_t kmers = utils::EstimateCardinalityFromSample(k, streams, hasher, genomic.size() + random.size(), 100);
+    EXPECT_GT(kmers, 5000u);
+
+    // Deliberately small CQF, it has to grow
+    qf::cqf cqf(100);
+    size_t slots = cqf.slots();
+    utils::FillCoverageHistogram(cqf, k, hasher, streams, thr, utils::StoringTypeFilter<utils::SimpleStoring>(), 100);
+    EXPECT_GT(cqf.slots(), slots);
+    // Grew past the remainder bits it started with, so it has been rebuilt
+    EXPECT_GT(cqf.hash_bits(), 8u + qf::cqf::DEFAULT_REMAINDER_BITS);
+    EXPECT_GE(cqf.remainder_bits(), utils::MIN_CQF_REMAINDER_BITS);
+
+    streams = io::CovFilteringWrap(std::move(streams), k, hasher, cqf, thr);
+    std::vector<Sequence> passed;
+    for (size_t pass = 0; pass < 2; ++pass) {
+        streams.reset();
+        std::vector<Sequence> current;
+        for (auto &stream : streams) {
+            io::SingleReadSeq read;
+            while (!stream.eof()) {
+                stream >> read;
+                current.push_back(read.sequence());
+            }
+        }
+        if (pass) {
+            EXPECT_EQ(passed, current);
+        }
+        passed = current;
+    }
+
+    size_t random_passed = 0;
+    for (const auto &read : random)
+        random_passed += std::count(passed.begin(), passed.end(), read.sequence());
+    EXPECT_EQ(0u, random_passed);
+    EXPECT_GT(passed.size(), genomic.size() * 9 / 10);
+}
+
+static void BuildExtensionIndex(utils::DeBruijnExtensionIndex<> &ext, const std::vector<std::string> &reads,
+                                const std::string &tmpdir) {
+    typedef io::VectorReadStream<io::SingleRead> RawStream;
+    auto workdir = fs::tmp::make_temp_dir(tmpdir, "tests");
+    io::ReadStreamList<io::SingleRead> streams(io::RCWrap<io::SingleRead>(RawStream(MakeReads(reads))));
+    utils::DeBruijnExtensionIndexBuilder().BuildExtensionIndexFromStream(workdir, ext, streams);
+}
+
+TEST_F( GraphConstruction, StreamingConstruction ) {
+    const unsigned k = 21;
+
+    std::mt19937 rng(42);
+    // Repeats make the junctions, the perfect loop and the palindrome make
+    // the loop and the self-conjugate edges
+    std::string repeat = RandomGenome(rng, 100), unit = RandomGenome(rng, 60), half = RandomGenome(rng, 40);
+    std::string genome = RandomGenome(rng, 2000) + repeat + RandomGenome(rng, 2000) + repeat + RandomGenome(rng, 2000);
+    std::vector<std::string> reads;
+    for (size_t pos = 0; pos + 100 <= genome.size(); pos += 50)
+        reads.push_back(genome.substr(pos, 100));
+    reads.push_back(unit + unit + unit);
+    reads.push_back(half + ReverseComplement(half));
+
+    Graph streamed(k), condensed(k);
+    {
+        utils::DeBruijnExtensionIndex<> ext(k);
+        BuildExtensionIndex(ext, reads, tmp_folder());
+        DeBruijnGraphExtentionConstructor<Graph>(streamed, ext).ConstructGraph(true);
+    }
+    {
+        utils::DeBruijnExtensionIndex<> ext(k);
+        BuildExtensionIndex(ext, reads, tmp_folder());
+        auto sequences = UnbranchingPathExtractor(ext, k).ExtractUnbranchingPathsAndLoops(16);
+        FastGraphFromSequencesConstructor<Graph>(k, ext).ConstructGraph(condensed, sequences);
+    }
+
+    // Both ways place the paths in the same order, so even the ids coincide
+    EXPECT_EQ(condensed.e_size(), streamed.e_size());
+    EXPECT_EQ(condensed.size(), streamed.size());
+    size_t self_conjugate = 0, loops = 0;
+    for (EdgeId e : streamed.edges()) {
+        ASSERT_TRUE(condensed.contains(e));
+        EXPECT_EQ(condensed.EdgeNucls(e), streamed.EdgeNucls(e));
+        EXPECT_EQ(condensed.EdgeStart(e), streamed.EdgeStart(e));
+        EXPECT_EQ(condensed.EdgeEnd(e), streamed.EdgeEnd(e));
+        self_conjugate += (streamed.conjugate(e) == e);
+        loops += (streamed.EdgeStart(e) == streamed.EdgeEnd(e));
+    }
+    EXPECT_GT(self_conjugate, 0u);
+    EXPECT_GT(loops, 0u);
+}
+
+// Graph pack with the graph and the edge index constructed from the reads
+class GraphFromReads : public ::testing::Test, public TmpFolderFixture {
+protected:
+    static const size_t K = 21;
+
+    void Construct(const std::vector<std::string> &reads, size_t lib_count = 0) {
+        typedef io::VectorReadStream<io::SingleRead> RawStream;
+        gp_ = std::make_unique<GraphPack>(K, tmp_folder(), lib_count);
+        workdir_ = fs::tmp::make_temp_dir(gp_->workdir(), "tests");
+        streams_ = io::ReadStreamList<io::SingleRead>(io::RCWrap<io::SingleRead>(RawStream(MakeReads(reads))));
+        ConstructGraphWithIndex(config::debruijn_config::construction(), workdir_, streams_,
+                                graph(), index());
+    }
+
+    GraphPack &gp() { return *gp_; }
+    Graph &graph() { return gp_->get_mutable<Graph>(); }
+    EdgeIndex<Graph> &index() { return gp_->get_mutable<EdgeIndex<Graph>>(); }
+
+    std::unique_ptr<GraphPack> gp_;
+    fs::TmpDir workdir_;
+    io::ReadStreamList<io::SingleRead> streams_;
+};
+
+class SequenceMapping : public GraphFromReads {};
+
+TEST_F( SequenceMapping, Batched ) {
+    std::mt19937 rng(42);
+    std::string genome = RandomGenome(rng, 5000);
+    Construct(RandomReads(rng, genome, 500, 100));
+    auto &graph = this->graph();
+    auto &index = this->index();
+
+    auto &kmer_mapper = gp().get_mutable<KmerMapper<Graph>>();
+    kmer_mapper.Attach();
+    BasicSequenceMapper<Graph, EdgeIndex<Graph>> plain(graph, index, kmer_mapper, true, false);
+    BasicSequenceMapper<Graph, EdgeIndex<Graph>> batched(graph, index, kmer_mapper, true, true);
+
+    for (size_t i = 0; i < 1000; ++i) {
+        // Sprinkle the reads with errors to exercise the missing k-mer windows
+        std::string read = genome.substr(rng() % (genome.size() - 150), 150);
+        for (size_t j = 0, errors = rng() % 5; j < errors; ++j)
+            read[rng() % read.size()] = nucl((char)(rng() % 4));
+        if (i % 10 == 0)
+            read.replace(rng() % 100, 40, std::string(40, 'A'));
+
+        auto etalon = plain.MapSequence(Sequence(read));
+        auto path = batched.MapSequence(Sequence(read));
+        ASSERT_EQ(etalon.size(), path.size());
+        for (size_t j = 0; j < etalon.size(); ++j) {
+            EXPECT_EQ(etalon[j].first, path[j].first);
+            EXPECT_EQ(etalon[j].second.initial_range, path[j].second.initial_range);
+            EXPECT_EQ(etalon[j].second.mapped_range, path[j].second.mapped_range);
+        }
+    }
+}
+
+// Every k-mer of the graph should be found exactly where it is
+static void CheckEdgeIndex(const Graph &g, const EdgeIndex<Graph> &index) {
+    for (auto it = g.ConstEdgeBegin(); !it.IsEnd(); ++it) {
+        EdgeId e = *it;
+        const Sequence &nucls = g.EdgeNucls(e);
+        for (size_t i = 0; i + index.k() <= nucls.size(); ++i) {
+            auto pos = index.get(nucls.Subseq(i, i + index.k()).start<RtSeq>(index.k()));
+            EXPECT_EQ(e, pos.first);
+            EXPECT_EQ(i, pos.second);
+        }
+    }
+}
+
+// Replaces the edge with the one having a nucleotide in the middle changed.
+// The edge is deleted first, as the graph modifications do
+static EdgeId MutateEdge(Graph &g, EdgeId e, size_t pos) {
+    std::string nucls = g.EdgeNucls(e).str();
+    nucls[pos] = nucl(char((dignucl(nucls[pos]) + 1) % 4));
+    VertexId start = g.EdgeStart(e), end = g.EdgeEnd(e);
+    g.DeleteEdge(e);
+    return g.AddEdge(start, end, Sequence(nucls));
+}
+
+// The graph is built from the reads tiling the genome, so its edges are long
+class IncrementalEdgeIndex : public GraphFromReads {
+protected:
+    void SetUp() override {
+        std::mt19937 rng(42);
+        std::string genome = RandomGenome(rng, 5000);
+        std::vector<std::string> reads;
+        for (size_t i = 0; i + 100 <= genome.size(); i += 50)
+            reads.push_back(genome.substr(i, 100));
+        Construct(reads);
+    }
+
+    EdgeId LongestEdge() {
+        EdgeId e = *graph().ConstEdgeBegin();
+        for (auto it = graph().ConstEdgeBegin(); !it.IsEnd(); ++it) {
+            if (graph().length(*it) > graph().length(e))
+                e = *it;
+        }
+        return e;
+    }
+};
+
+TEST_F( IncrementalEdgeIndex, Update ) {
+    auto &graph = this->graph();
+    auto &index = this->index();
+    CheckEdgeIndex(graph, index);
+
+    EdgeId e = LongestEdge();
+    ASSERT_GT(graph.length(e), 4 * K);
+    RtSeq removed = graph.EdgeNucls(e).Subseq(graph.length(e) / 2, graph.length(e) / 2 + K + 1).start<RtSeq>(K + 1);
+
+    // The k-mers of the new edges are not in the MPHF, they go to the
+    // overflow table
+    e = MutateEdge(graph, e, graph.length(e) / 2 + K);
+    CheckEdgeIndex(graph, index);
+    EXPECT_FALSE(index.contains(removed));
+
+    index.DeferUpdates();
+    EXPECT_TRUE(graph.AllHandlersThreadSafe());
+    e = MutateEdge(graph, e, graph.length(e) / 3);
+    e = MutateEdge(graph, e, graph.length(e) / 3 + K);
+    EXPECT_FALSE(index.contains(graph.EdgeNucls(e).start<RtSeq>(K + 1)));
+    index.Update();
+    EXPECT_FALSE(index.IsDeferred());
+    CheckEdgeIndex(graph, index);
+
+    // The index survives the serialization along with the overflow table
+    std::stringstream ss;
+    io::binary::BinOStream os(ss);
+    os << index;
+    EdgeIndex<Graph> loaded(graph, workdir_->dir());
+    io::binary::BinIStream is(ss);
+    is >> loaded;
+    CheckEdgeIndex(graph, loaded);
+}
+
+// Every k-mer of the graph should be found by the index exactly as by the etalon one
+static void CompareEdgeIndices(const Graph &g, const EdgeIndex<Graph> &index, const EdgeIndex<Graph> &etalon) {
+    for (auto it = g.ConstEdgeBegin(); !it.IsEnd(); ++it) {
+        const Sequence &nucls = g.EdgeNucls(*it);
+        for (size_t i = 0; i + index.k() <= nucls.size(); ++i) {
+            RtSeq kmer = nucls.Subseq(i, i + index.k()).start<RtSeq>(index.k());
+            EXPECT_EQ(etalon.get(kmer), index.get(kmer));
+        }
+    }
+}
+
+TEST_F( IncrementalEdgeIndex, Duplicates ) {
+    auto &graph = this->graph();
+    auto &index = this->index();
+
+    EdgeId e = LongestEdge();
+    ASSERT_GT(graph.length(e), 4 * K);
+
+    // Edges parallel to e differing in a single nucleotide share most of its
+    // k-mers, which become ambiguous no matter in which order they are added
+    auto AddMutated = [&](size_t pos) {
+        std::string nucls = graph.EdgeNucls(e).str();
+        nucls[pos] = nucl(char((dignucl(nucls[pos]) + 1) % 4));
+        graph.AddEdge(graph.EdgeStart(e), graph.EdgeEnd(e), Sequence(nucls));
+    };
+
+    index.DeferUpdates();
+    AddMutated(graph.length(e) / 3);
+    index.Update();
+    {
+        EdgeIndex<Graph> etalon(graph, workdir_->dir());
+        etalon.Refill();
+        CompareEdgeIndices(graph, index, etalon);
+    }
+
+    AddMutated(2 * graph.length(e) / 3);
+    {
+        EdgeIndex<Graph> etalon(graph, workdir_->dir());
+        etalon.Refill();
+        CompareEdgeIndices(graph, index, etalon);
+    }
+    EXPECT_EQ(EdgeIndex<Graph>::NOT_FOUND, index.get(graph.EdgeNucls(e).start<RtSeq>(K + 1)).second);
+}
+
+class PathCollector : public SequenceMapperListener {
+public:
+    void ProcessSingleRead(size_t, const io::SingleRead&, const MappingPath<EdgeId>& read) override {
+        paths.push_back(read);
+    }
+
+    std::vector<MappingPath<EdgeId>> paths;
+};
+
+class ReadMappingCache : public GraphFromReads {};
+
+TEST_F( ReadMappingCache, RecordAndReplay ) {
+    std::mt19937 rng(42);
+    std::string genome = RandomGenome(rng, 5000);
+    std::vector<std::string> reads = RandomReads(rng, genome, 500, 100);
+    for (auto &read : reads)
+        read[rng() % read.size()] = nucl((char)(rng() % 4));
+    Construct(reads, 1);
+    auto &gp = this->gp();
+    auto &graph = this->graph();
+    auto &streams = streams_;
+    gp.get_mutable<KmerMapper<Graph>>().Attach();
+    auto &cache = gp.get_mutable<MappingCache>();
+    auto mapper = MapperInstance(gp);
+    EXPECT_FALSE(cache.ready("reads", streams.size()));
+
+    PathCollector etalon, recorded, replayed;
+    {
+        SequenceMapperNotifier notifier(gp, 1);
+        notifier.Subscribe(0, &etalon);
+        notifier.ProcessLibrary(streams, 0, *mapper);
+    }
+    {
+        SequenceMapperNotifier notifier(gp, 1);
+        notifier.Subscribe(0, &recorded);
+        notifier.ProcessLibrary(streams, 0, *mapper, cache, "reads");
+    }
+    EXPECT_TRUE(cache.ready("reads", streams.size()));
+    {
+        SequenceMapperNotifier notifier(gp, 1);
+        notifier.Subscribe(0, &replayed);
+        notifier.ProcessLibrary(streams, 0, *mapper, cache, "reads");
+    }
+
+    ASSERT_EQ(etalon.paths.size(), recorded.paths.size());
+    ASSERT_EQ(etalon.paths.size(), replayed.paths.size());
+    for (size_t i = 0; i < etalon.paths.size(); ++i) {
+        const auto &path = replayed.paths[i];
+        ASSERT_EQ(etalon.paths[i].size(), path.size());
+        ASSERT_EQ(etalon.paths[i].size(), recorded.paths[i].size());
+        for (size_t j = 0; j < path.size(); ++j) {
+            EXPECT_EQ(etalon.paths[i][j].first, path[j].first);
+            EXPECT_EQ(etalon.paths[i][j].second.initial_range, path[j].second.initial_range);
+            EXPECT_EQ(etalon.paths[i][j].second.mapped_range, path[j].second.mapped_range);
+        }
+    }
+
+    // Cleared cache records the mappings anew
+    cache.Clear();
+    EXPECT_FALSE(cache.ready("reads", streams.size()));
+    {
+        PathCollector collector;
+        SequenceMapperNotifier notifier(gp, 1);
+        notifier.Subscribe(0, &collector);
+        notifier.ProcessLibrary(streams, 0, *mapper, cache, "reads");
+    }
+    EXPECT_TRUE(cache.ready("reads", streams.size()));
+
+    // Any graph modification drops the cached mappings
+    graph.DeleteEdge(*graph.ConstEdgeBegin());
+    EXPECT_FALSE(cache.ready("reads", streams.size()));
+}
@@ -5,6 +5,10 @@
 //***************************************************************************
 
 #include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/core/compact_topology.hpp"
+#include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+
+#include "random_graph.hpp"
 
 #include <vector>
 #include <set>
@@ -106,3 +110,48 @@ TEST( GraphCore, SelfRCEdgeMerge ) {
     EXPECT_EQ(1u, g.OutgoingEdgeCount(v1));
     EXPECT_EQ(Sequence("AACGCTATTCACGTGAATAGCGTT"), g.EdgeNucls(g.GetUniqueOutgoingEdge(v1)));
 }
+
+static void CheckCompactTopology(const Graph &g, const omnigraph::CompactTopology<Graph> &topology) {
+    EXPECT_TRUE(topology.actual());
+    for (EdgeId e : g.edges()) {
+        EXPECT_EQ(g.EdgeStart(e), topology.EdgeStart(e));
+        EXPECT_EQ(g.EdgeEnd(e), topology.EdgeEnd(e));
+        EXPECT_EQ(g.length(e), topology.length(e));
+    }
+    for (VertexId v : g) {
+        std::vector<EdgeId> out(g.out_begin(v), g.out_end(v)), in;
+        for (EdgeId e : g.IncomingEdges(v))
+            in.push_back(e);
+        auto compact_out = topology.OutgoingEdges(v), compact_in = topology.IncomingEdges(v);
+        EXPECT_EQ(out, std::vector<EdgeId>(compact_out.begin(), compact_out.end()));
+        EXPECT_EQ(in, std::vector<EdgeId>(compact_in.begin(), compact_in.end()));
+        EXPECT_EQ(g.OutgoingEdgeCount(v), topology.OutgoingEdgeCount(v));
+        EXPECT_EQ(g.IncomingEdgeCount(v), topology.IncomingEdgeCount(v));
+    }
+}
+
+TEST( GraphCore, CompactTopology ) {
+    Graph g(11);
+    RandomGraph<Graph>(g, /*max_size*/100).Generate(/*iterations*/1000);
+
+    omnigraph::CompactTopology<Graph> topology(g);
+    CheckCompactTopology(g, topology);
+
+    typedef omnigraph::DijkstraHelper<Graph> DijkstraHelper;
+    for (VertexId v : g) {
+        auto dijkstra = DijkstraHelper::CreateBoundedDijkstra(g, 1000);
+        auto compact_dijkstra = DijkstraHelper::CreateCompactBoundedDijkstra(g, topology, 1000);
+        dijkstra.Run(v);
+        compact_dijkstra.Run(v);
+        auto reached = dijkstra.ReachedVertices(), compact_reached = compact_dijkstra.ReachedVertices();
+        EXPECT_EQ(std::set<VertexId>(reached.begin(), reached.end()),
+                  std::set<VertexId>(compact_reached.begin(), compact_reached.end()));
+        for (VertexId u : reached)
+            EXPECT_EQ(dijkstra.GetDistance(u), compact_dijkstra.GetDistance(u));
+    }
+
+    createGraph(g, 3);
+    EXPECT_FALSE(topology.actual());
+    topology.Rebuild();
+    CheckCompactTopology(g, topology);
+}
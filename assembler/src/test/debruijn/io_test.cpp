@@ -10,8 +10,17 @@
 #include "io/binary/graph.hpp"
 #include "io/binary/kmer_mapper.hpp"
 #include "io/binary/paired_index.hpp"
+#include "io/reads/binary_converter.hpp"
+#include "io/reads/binary_streams.hpp"
+#include "io/reads/fasta_fastq_gz_parser.hpp"
+#include "io/reads/inflating_reader.hpp"
+#include "io/reads/vector_reader.hpp"
+#include "tmp_folder_fixture.hpp"
 
 #include <gtest/gtest.h>
+#include <zlib.h>
+
+#include <fstream>
 
 using namespace debruijn_graph;
 
@@ -109,3 +118,204 @@ TEST(Io, KmerMapper) {
 
     CompareContainers(kmer_mapper, new_mapper);
 }
+
+static void CheckBinaryReadStreams(io::BinaryReadChunk::Codec codec) {
+    TmpFolderFixture fixture("tmp");
+    std::string single_prefix = fs::append_path(fixture.tmp_folder(), "single");
+    std::string paired_prefix = fs::append_path(fixture.tmp_folder(), "paired");
+
+    // Several chunks with the last one incomplete, lengths around the word boundaries,
+    // some of the sequences are views not starting at the word boundary. The reads
+    // come from a tandem repeat, so that the chunks are actually compressible.
+    std::string repeat;
+    for (Sequence unit = RandomSequence(12); repeat.size() < 300; )
+        repeat += unit.str();
+
+    std::vector<io::SingleReadSeq> singles;
+    std::vector<io::PairedReadSeq> paireds;
+    for (size_t i = 0; i < 1234; ++i) {
+        Sequence seq(repeat.substr(rand() % 12, rand() % 200 + 40));
+        singles.emplace_back(seq.Subseq(rand() % 2 ? 0 : rand() % 39),
+                             io::SequenceOffsetT(rand() % 10), io::SequenceOffsetT(rand() % 10));
+        if (i % 2)
+            paireds.emplace_back(singles[i - 1], singles[i], 0);
+    }
+
+    {
+        io::ReadStream<io::SingleReadSeq> stream{io::VectorReadStream<io::SingleReadSeq>(singles)};
+        io::BinaryWriter(single_prefix, codec).ToBinary(stream);
+    }
+    {
+        // The second reads are stored reverse complemented
+        io::ReadStream<io::PairedReadSeq> stream{io::VectorReadStream<io::PairedReadSeq>(paireds)};
+        io::BinaryWriter(paired_prefix, codec).ToBinary(stream, io::LibraryOrientation::FR);
+    }
+
+    if (codec == io::BinaryReadChunk::Codec::Deflate) {
+        // Make sure the chunks were deflated rather than fell back to packing
+        std::string packed_prefix = fs::append_path(fixture.tmp_folder(), "packed");
+        io::ReadStream<io::SingleReadSeq> stream{io::VectorReadStream<io::SingleReadSeq>(singles)};
+        io::BinaryWriter(packed_prefix, io::BinaryReadChunk::Codec::Packed).ToBinary(stream);
+        EXPECT_LT(fs::filesize(single_prefix + ".seq"), fs::filesize(packed_prefix + ".seq"));
+    }
+
+    for (size_t portions : { 1, 3, 20 }) {
+        size_t read = 0;
+        for (size_t portion = 0; portion < portions; ++portion) {
+            io::BinaryFileSingleStream stream(single_prefix, portions, portion);
+            // The second pass should give the same reads
+            for (size_t pass = 0; pass < 2; ++pass) {
+                stream.reset();
+                for (size_t i = read; !stream.eof(); ++i) {
+                    io::SingleReadSeq r;
+                    stream >> r;
+                    ASSERT_LT(i, singles.size());
+                    EXPECT_EQ(singles[i].sequence(), r.sequence());
+                    EXPECT_EQ(singles[i].GetLeftOffset(), r.GetLeftOffset());
+                    EXPECT_EQ(singles[i].GetRightOffset(), r.GetRightOffset());
+                    if (pass == 1)
+                        ++read;
+                }
+            }
+        }
+        EXPECT_EQ(singles.size(), read);
+
+        read = 0;
+        for (size_t portion = 0; portion < portions; ++portion) {
+            io::BinaryFilePairedStream stream(paired_prefix, 42, portions, portion);
+            while (!stream.eof()) {
+                io::PairedReadSeq r;
+                stream >> r;
+                ASSERT_LT(read, paireds.size());
+                EXPECT_EQ(paireds[read].first().sequence(), r.first().sequence());
+                EXPECT_EQ(!paireds[read].second().sequence(), r.second().sequence());
+                EXPECT_EQ(paireds[read].second().GetLeftOffset(), r.second().GetRightOffset());
+                EXPECT_EQ(42u, r.orig_insert_size());
+                ++read;
+            }
+        }
+        EXPECT_EQ(paireds.size(), read);
+    }
+}
+
+TEST(Io, BinaryReadStreams) {
+    CheckBinaryReadStreams(io::BinaryReadChunk::Codec::Packed);
+}
+
+TEST(Io, BinaryReadStreamsDeflate) {
+    CheckBinaryReadStreams(io::BinaryReadChunk::Codec::Deflate);
+}
+
+static const size_t BGZF_BLOCK = 0xff00;
+
+// Writes the data as bgzip does: independently deflated blocks with
+// the compressed size in the "BC" extra subfield, followed by an empty EOF block
+static void WriteBGZF(const std::string &filename, const std::string &data) {
+    std::ofstream os(filename, std::ios::binary);
+    for (size_t pos = 0; ; pos += BGZF_BLOCK) {
+        size_t size = pos < data.size() ? std::min(BGZF_BLOCK, data.size() - pos) : 0;
+        std::vector<unsigned char> out(BGZF_BLOCK + 1024);
+
+        z_stream zs;
+        memset(&zs, 0, sizeof(zs));
+        ASSERT_EQ(Z_OK, deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY));
+        zs.next_in = (unsigned char*)(data.data() + pos);
+        zs.avail_in = unsigned(size);
+        zs.next_out = out.data();
+        zs.avail_out = unsigned(out.size());
+        ASSERT_EQ(Z_STREAM_END, deflate(&zs, Z_FINISH));
+        size_t compressed = zs.total_out;
+        deflateEnd(&zs);
+
+        size_t block_size = 18 + compressed + 8;
+        uint32_t crc = uint32_t(crc32(0L, (const unsigned char*)data.data() + pos, unsigned(size)));
+        unsigned char header[18] = { 0x1f, 0x8b, 8, 4, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0,
+                                     (unsigned char)((block_size - 1) & 0xff), (unsigned char)((block_size - 1) >> 8) };
+        unsigned char trailer[8];
+        for (size_t i = 0; i < 4; ++i) {
+            trailer[i] = (unsigned char)(crc >> (8 * i));
+            trailer[4 + i] = (unsigned char)(size >> (8 * i));
+        }
+        os.write((const char*)header, sizeof(header));
+        os.write((const char*)out.data(), compressed);
+        os.write((const char*)trailer, sizeof(trailer));
+
+        if (size == 0)
+            break;
+    }
+}
+
+static std::string ReadInflated(const std::string &filename, unsigned nthreads) {
+    io::InflatingReader reader(filename, nthreads);
+    EXPECT_TRUE(reader.is_open());
+    std::string res;
+    char buf[12345];
+    int read;
+    while ((read = reader.read(buf, sizeof(buf))) > 0)
+        res.append(buf, size_t(read));
+    EXPECT_EQ(0, read);
+    return res;
+}
+
+TEST(Io, InflatingReader) {
+    TmpFolderFixture fixture("tmp");
+    std::string plain = fs::append_path(fixture.tmp_folder(), "reads.fastq");
+    std::string gzip = fs::append_path(fixture.tmp_folder(), "reads.fastq.gz");
+    std::string bgzf = fs::append_path(fixture.tmp_folder(), "reads.bgzf.fastq.gz");
+
+    // Several megabytes, so that there are many BGZF blocks and batches
+    const size_t READS = 20000;
+    std::string data;
+    for (size_t i = 0; i < READS; ++i) {
+        std::string seq = RandomSequence(rand() % 150 + 50).str();
+        data += "@read" + std::to_string(i) + "\n" + seq + "\n+\n" + std::string(seq.size(), 'I') + "\n";
+    }
+
+    {
+        std::ofstream os(plain, std::ios::binary);
+        os << data;
+    }
+    {
+        gzFile gz = gzopen(gzip.c_str(), "w");
+        ASSERT_EQ(int(data.size()), gzwrite(gz, data.data(), unsigned(data.size())));
+        gzclose(gz);
+    }
+    WriteBGZF(bgzf, data);
+
+    for (const auto &filename : { plain, gzip, bgzf }) {
+        for (unsigned nthreads : { 0, 1, 4 }) {
+            EXPECT_EQ(data, ReadInflated(filename, nthreads)) << filename << " " << nthreads;
+
+            io::FileReadFlags flags;
+            flags.inflate_threads = nthreads & 0xFFFF;
+            io::FastaFastqGzParser parser(filename, flags);
+            size_t reads = 0;
+            for (; !parser.eof(); ++reads) {
+                io::SingleRead r;
+                parser >> r;
+                EXPECT_EQ("read" + std::to_string(reads), r.name());
+            }
+            EXPECT_EQ(READS, reads);
+        }
+    }
+
+    EXPECT_FALSE(io::InflatingReader(fs::append_path(fixture.tmp_folder(), "missing.gz"), 4).is_open());
+}
+
+TEST(Io, InflatingReaderBGZFBatches) {
+    TmpFolderFixture fixture("tmp");
+
+    // Exactly 64·N full blocks leave the EOF block alone in the last batch,
+    // and an empty file consists of the EOF block only
+    for (size_t blocks : { 0, 64, 128 }) {
+        std::string data;
+        while (data.size() < blocks * BGZF_BLOCK)
+            data += RandomSequence(100).str() + "\n";
+        data.resize(blocks * BGZF_BLOCK);
+
+        std::string bgzf = fs::append_path(fixture.tmp_folder(), "blocks" + std::to_string(blocks) + ".gz");
+        WriteBGZF(bgzf, data);
+        for (unsigned nthreads : { 0, 1, 4 })
+            EXPECT_EQ(data, ReadInflated(bgzf, nthreads)) << blocks << " " << nthreads;
+    }
+}
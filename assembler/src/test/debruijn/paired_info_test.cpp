@@ -6,6 +6,7 @@
 
 #include "random_graph.hpp"
 
+#include "paired_info/distance_estimation.hpp"
 #include "paired_info/index_point.hpp"
 #include "paired_info/paired_info_helpers.hpp"
 //#include "io/binary/paired_index.hpp"
@@ -458,3 +459,49 @@ TEST(PairedInfo, RandomSymmetry) {
         }
     }
 }
+
+static std::vector<size_t> DirectGraphDistances(const debruijn_graph::Graph &graph,
+                                                EdgeId e1, EdgeId e2,
+                                                size_t insert_size, size_t read_length, size_t delta) {
+    size_t upper = omnigraph::PairInfoPathLengthUpperBound(graph.k(), insert_size, double(delta));
+    size_t lower = omnigraph::PairInfoPathLengthLowerBound(graph.k(), graph.length(e1), graph.length(e2),
+                                                           int(insert_size - 2 * read_length), double(delta));
+    omnigraph::DistancesLengthsCallback<debruijn_graph::Graph> callback(graph);
+    omnigraph::ProcessPaths(graph, lower, upper, graph.EdgeEnd(e1), graph.EdgeStart(e2), callback);
+    std::vector<size_t> result = callback.distances();
+    for (size_t &length : result)
+        length += graph.length(e1);
+    if (e1 == e2)
+        result.push_back(0);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+TEST(PairedInfo, CachedGraphDistances) {
+    const size_t insert_size = 1500, read_length = 100, delta = 100;
+    debruijn_graph::Graph graph(55);
+    debruijn_graph::RandomGraph<debruijn_graph::Graph>(graph, /*max_size*/50).Generate(/*iterations*/400);
+    GraphDistanceFinder finder(graph, insert_size, read_length, delta, /*cache_size*/ 64);
+
+    auto check = [&]() {
+        size_t nonempty = 0;
+        for (EdgeId e1 : graph.edges())
+            for (EdgeId e2 : graph.edges()) {
+                auto expected = DirectGraphDistances(graph, e1, e2, insert_size, read_length, delta);
+                // The second call is answered from the cache
+                EXPECT_EQ(expected, finder.GetGraphDistancesLengths(e1, e2));
+                EXPECT_EQ(expected, finder.GetGraphDistancesLengths(e1, e2));
+                nonempty += !expected.empty();
+            }
+        return nonempty;
+    };
+
+    EXPECT_LT(graph.e_size(), check());
+
+    // Any modification of the graph drops the cached lengths
+    std::vector<EdgeId> edges(graph.edges().begin(), graph.edges().end());
+    for (size_t i = 0; i < edges.size(); i += 3)
+        if (graph.contains(edges[i]))
+            graph.DeleteEdge(edges[i]);
+    check();
+}
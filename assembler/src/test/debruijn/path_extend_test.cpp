@@ -5,13 +5,18 @@
 //***************************************************************************
 
 
+#include "modules/path_extend/path_extender.hpp"
 #include "modules/path_extend/path_visualizer.hpp"
 #include "modules/path_extend/pe_utils.hpp"
+#include "modules/alignment/long_read_storage.hpp"
+#include "paired_info/paired_info.hpp"
 
 #include "graphio.hpp"
 
 #include <gtest/gtest.h>
 
+#include <random>
+
 using namespace path_extend;
 using namespace debruijn_graph;
 
@@ -755,3 +760,184 @@ TEST( PathExtend, BidirectionalPathLoopDetector ) {
     EXPECT_EQ(path1->Size(), 12);
     EXPECT_EQ(path1->Back(), e7);
 }
+
+namespace {
+
+// Extends the path with the first outgoing edge not covered by other paths
+class UncoveredEdgeExtender : public PathExtender {
+public:
+    UncoveredEdgeExtender(const Graph &g, const GraphCoverageMap &cover_map)
+            : PathExtender(g), cover_map_(cover_map) {}
+
+    bool MakeGrowStep(BidirectionalPath& path, PathContainer*) override {
+        if (path.Empty() || path.Size() > 10)
+            return false;
+
+        for (EdgeId e : g_.OutgoingEdges(g_.EdgeEnd(path.Back()))) {
+            if (cover_map_.IsCovered(e) || path.FindFirst(e) != -1)
+                continue;
+            path.PushBack(e);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    const GraphCoverageMap &cover_map_;
+};
+
+template<class ExtendersFactory>
+std::vector<std::vector<EdgeId>> GrowSeeds(const Graph &g, size_t threads, ExtendersFactory make_extenders) {
+    PathContainer seeds;
+    for (EdgeId e : g.edges()) {
+        if (e <= g.conjugate(e))
+            seeds.CreatePair(g, e);
+    }
+    seeds.SortByLength();
+
+    ScaffoldingUniqueEdgeStorage unique_storage;
+    GraphCoverageMap cover_map(g);
+    UsedUniqueStorage used_storage(unique_storage, g);
+
+    CompositeExtender extender(g, cover_map, used_storage, make_extenders(cover_map, used_storage));
+    extender.UseThreads(threads, make_extenders);
+
+    PathContainer result;
+    extender.GrowAll(seeds, result);
+
+    std::vector<std::vector<EdgeId>> paths;
+    for (size_t i = 0; i < result.size(); ++i) {
+        paths.emplace_back(result.Get(i).begin(), result.Get(i).end());
+        paths.emplace_back(result.GetConjugate(i).begin(), result.GetConjugate(i).end());
+    }
+    return paths;
+}
+
+}
+
+TEST( PathExtend, ParallelSeedGrowth ) {
+    Graph g(13);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/path_extend/distance_estimation", g));
+
+    auto make_extenders = [&](const GraphCoverageMap &map, UsedUniqueStorage &) {
+        return CompositeExtender::Extenders{std::make_shared<UncoveredEdgeExtender>(g, map)};
+    };
+
+    auto serial = GrowSeeds(g, 1, make_extenders);
+    EXPECT_FALSE(serial.empty());
+    EXPECT_EQ(serial, GrowSeeds(g, 4, make_extenders));
+    EXPECT_EQ(serial, GrowSeeds(g, 7, make_extenders));
+}
+
+TEST( PathExtend, ParallelSeedGrowthPairedInfo ) {
+    Graph g(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/ecoli_400k/distance_estimation", g));
+    std::vector<EdgeId> edges(g.edges().begin(), g.edges().end());
+    std::sort(edges.begin(), edges.end());
+
+    // Paired info of a random walk over the graph, as if it was the genome
+    const size_t IS = 300, IS_MIN = 200, IS_MAX = 400;
+    std::vector<std::pair<EdgeId, size_t>> genome;
+    std::mt19937 rng(42);
+    EdgeId e = edges[rng() % edges.size()];
+    for (size_t pos = 0; genome.size() < 300; ) {
+        genome.emplace_back(e, pos);
+        pos += g.length(e);
+        VertexId v = g.EdgeEnd(e);
+        if (g.OutgoingEdgeCount(v) == 0)
+            v = g.EdgeStart(edges[rng() % edges.size()]);
+        e = *std::next(g.out_begin(v), rng() % g.OutgoingEdgeCount(v));
+    }
+
+    std::map<int, size_t> is_distribution;
+    for (size_t is = IS_MIN; is <= IS_MAX; ++is)
+        is_distribution[int(is)] = 1;
+    omnigraph::de::PairedInfoIndexT<Graph> index(g);
+    auto lib = std::make_shared<PairedInfoLibraryWithIndex<decltype(index)>>(g, 100, IS, IS_MIN, IS_MAX, 10.,
+                                                                             index, false, is_distribution);
+    // Every pair of edges close enough in the walk gets all the ideal paired info
+    for (size_t i = 0; i < genome.size(); ++i) {
+        EdgeId e1 = genome[i].first;
+        size_t end = genome[i].second + g.length(e1) + IS_MAX;
+        for (size_t j = i + 1; j < genome.size() && genome[j].second < end; ++j) {
+            EdgeId e2 = genome[j].first;
+            int d = int(genome[j].second - genome[i].second);
+            double weight = lib->IdealPairedInfo(e1, e2, d);
+            if (e1 != e2 && math::gr(weight, 0.))
+                index.Add(e1, e2, omnigraph::de::Point(float(d), float(weight), 0));
+        }
+    }
+
+    omnigraph::FlankingCoverage<Graph> flanking_cov(g, 50);
+    auto make_extenders = [&](const GraphCoverageMap &map, UsedUniqueStorage &used_storage) {
+        auto wc = std::make_shared<PathCoverWeightCounter>(g, lib, /*normalize weight*/ true, /*single threshold*/ 0.5);
+        auto ec = std::make_shared<SimpleExtensionChooser>(g, wc, /*weight threshold*/ 0.5, /*priority*/ 1.5);
+        return CompositeExtender::Extenders{
+            std::make_shared<SimpleExtender>(g, flanking_cov, map, used_storage, ec,
+                                             /*investigate short loops*/ false,
+                                             /*use short loop cov resolver*/ false, IS, 0.5)};
+    };
+
+    auto serial = GrowSeeds(g, 1, make_extenders);
+    ASSERT_FALSE(serial.empty());
+    EXPECT_TRUE(std::any_of(serial.begin(), serial.end(),
+                            [](const std::vector<EdgeId> &path) { return path.size() > 2; }));
+    EXPECT_EQ(serial, GrowSeeds(g, 4, make_extenders));
+    EXPECT_EQ(serial, GrowSeeds(g, 7, make_extenders));
+}
+
+TEST( PathExtend, LongReadPathStorage ) {
+    Graph g(13);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/path_extend/distance_estimation", g));
+    std::vector<EdgeId> edges(g.edges().begin(), g.edges().end());
+    ASSERT_GE(edges.size(), 4);
+    std::sort(edges.begin(), edges.end());
+    EdgeId a = edges[0], b = edges[1], c = edges[2], d = edges[3];
+
+    PathStorage<Graph> storage(g);
+    storage.AddPath({b, c}, 1);
+    storage.AddPath({a, b, c}, 2);
+    storage.AddPath({b, c}, 3);
+    storage.AddPath({a, d}, 1);
+    storage.AddPath({}, 1);
+    EXPECT_EQ(storage.size(), 3);
+
+    std::vector<PathInfo<Graph>> paths;
+    storage.SaveAllPaths(paths);
+    ASSERT_EQ(paths.size(), 3);
+    EXPECT_EQ(paths[0].path(), std::vector<EdgeId>({a, b, c}));
+    EXPECT_EQ(paths[0].weight(), 2);
+    EXPECT_EQ(paths[1].path(), std::vector<EdgeId>({a, d}));
+    EXPECT_EQ(paths[2].path(), std::vector<EdgeId>({b, c}));
+    EXPECT_EQ(paths[2].weight(), 4);
+
+    std::stringstream ss;
+    storage.BinWrite(ss);
+    PathStorage<Graph> loaded(g);
+    loaded.BinRead(ss);
+    std::vector<PathInfo<Graph>> loaded_paths;
+    loaded.SaveAllPaths(loaded_paths);
+    ASSERT_EQ(loaded_paths.size(), paths.size());
+    for (size_t i = 0; i < paths.size(); ++i) {
+        EXPECT_EQ(loaded_paths[i].path(), paths[i].path());
+        EXPECT_EQ(loaded_paths[i].weight(), paths[i].weight());
+    }
+
+    // {a, b, b}, {a, b} and {b, b}, nothing collides yet
+    PathStorage<Graph> copy(storage);
+    copy.ReplaceEdges({{c, b}, {d, b}});
+    EXPECT_EQ(copy.size(), 3);
+    // {a, b} and {b, b} both become {a, a}, the first one is kept
+    copy.ReplaceEdges({{b, a}});
+    paths.clear();
+    copy.SaveAllPaths(paths);
+    ASSERT_EQ(paths.size(), 2);
+    EXPECT_EQ(paths[0].path(), std::vector<EdgeId>({a, a}));
+    EXPECT_EQ(paths[0].weight(), 1);
+    EXPECT_EQ(paths[1].path(), std::vector<EdgeId>({a, a, a}));
+    EXPECT_EQ(paths[1].weight(), 2);
+
+    copy.AddPath({a, a}, 5);
+    EXPECT_EQ(copy.size(), 2);
+    EXPECT_EQ(storage.size(), 3);
+}
@@ -214,6 +214,34 @@ TEST_F( Simplification,  IterECTest ) {
     EXPECT_EQ(16, g.size());
 }
 
+TEST_F( Simplification,  BatchedTipClipperTest ) {
+    Graph g(55), batched_g(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/tips/graph", g));
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/tips/graph", batched_g));
+
+    DefaultClipTips(g);
+    auto info = standard_simplif_relevant_info();
+    info.set_apply_batch_size(2);
+    debruijn::simplification::TipClipperInstance(batched_g, standard_tc_config(), info)->Run();
+
+    EXPECT_EQ(g.size(), batched_g.size());
+    EXPECT_EQ(g.e_size(), batched_g.e_size());
+}
+
+TEST_F( Simplification,  BatchedECTest ) {
+    Graph g(55);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/topology_ec/iter_unique_path", g));
+
+    debruijn_config::simplification::erroneous_connections_remover ec_config;
+    ec_config.condition = "{ icb 7000 , ec_lb 20 }";
+    auto info = standard_simplif_relevant_info();
+    info.set_apply_batch_size(3);
+
+    debruijn::simplification::ECRemoverInstance(g, ec_config, info)->Run();
+
+    EXPECT_EQ(16, g.size());
+}
+
 TEST_F( Simplification,  IterUniquePath ) {
     Graph g(55);
     ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/topology_ec/iter_unique_path", g));
@@ -4,9 +4,12 @@
 //* See file LICENSE for details.
 //***************************************************************************
 
+#include "sequence/canonical_kmer_roller.hpp"
 #include "sequence/rtseq.hpp"
 #include "sequence/sequence.hpp"
 #include "sequence/nucl.hpp"
+#include "sequence/sequence_tools.hpp"
+#include <random>
 #include <string>
 #include <gtest/gtest.h>
 
@@ -700,3 +703,91 @@ TEST( RtSeq, FirstLast ) {
     EXPECT_EQ(3, s2.first());
     EXPECT_EQ(3, s2.last());
 }
+
+// Checks the word kernels against the plain string operations
+template<class Seq>
+static void CheckKernels(size_t k, std::mt19937 &rng) {
+    std::string s(k, 'A');
+    for (char &c : s)
+        c = nucl(char(rng() % 4));
+
+    Seq seq(k, s.c_str());
+    std::string rc = ReverseComplement(s);
+    EXPECT_EQ(rc, (!seq).str());
+    EXPECT_EQ(seq, !!seq);
+    EXPECT_EQ(s <= rc, seq.IsMinimal());
+    EXPECT_TRUE(seq.IsMinimal() || (!seq).IsMinimal());
+    EXPECT_EQ(seq.FastRC(), !seq);
+
+    char c = char(rng() % 4);
+    Seq left = seq;
+    left <<= c;
+    EXPECT_EQ(s.substr(1) + nucl(c), left.str());
+    EXPECT_EQ(left, seq << c);
+
+    Seq right = seq;
+    right >>= c;
+    EXPECT_EQ(nucl(c) + s.substr(0, k - 1), right.str());
+    EXPECT_EQ(right, seq >> c);
+    // Nucleotides after the end should stay zero
+    EXPECT_EQ(Seq(k, right.str().c_str()), right);
+    EXPECT_EQ(right.GetHash(), Seq(k, right.str().c_str()).GetHash());
+}
+
+TEST( RtSeq, KernelsEquivalence ) {
+    std::mt19937 rng(42);
+    for (size_t k = 1; k < RtSeq::max_size; ++k)
+        for (size_t i = 0; i < 20; ++i)
+            CheckKernels<RtSeq>(k, rng);
+
+    for (size_t k = 1; k <= 32; ++k)
+        for (size_t i = 0; i < 20; ++i)
+            CheckKernels<RuntimeSeq<32>>(k, rng);
+
+    for (size_t k = 1; k <= 64; ++k)
+        for (size_t i = 0; i < 20; ++i)
+            CheckKernels<RuntimeSeq<64>>(k, rng);
+
+    // Longer than the unrolled kernels
+    for (size_t k = 120; k <= 256; ++k)
+        for (size_t i = 0; i < 5; ++i)
+            CheckKernels<RuntimeSeq<256>>(k, rng);
+
+    for (size_t k = 1; k <= 64; ++k)
+        for (size_t i = 0; i < 20; ++i)
+            CheckKernels<RuntimeSeq<64, uint32_t>>(k, rng);
+}
+
+TEST( RtSeq, IsMinimalPalindrome ) {
+    RtSeq s(4, "ACGT");
+    EXPECT_TRUE(s.IsMinimal());
+    EXPECT_EQ(s, !s);
+    RtSeq s2(64, "ACGTACGTACACGTACGTACACGTACGTACACGTGTACGTACGTGTACGTACGTGTACGTACGT");
+    EXPECT_EQ(s2, !s2);
+    EXPECT_TRUE(s2.IsMinimal());
+}
+
+TEST( RtSeq, CanonicalKMerRoller ) {
+    std::mt19937 rng(42);
+    for (size_t k = 1; k < RtSeq::max_size; ++k) {
+        std::string s(300, 'A');
+        for (char &c : s)
+            c = nucl((char)(rng() % 4));
+        // Low complexity part to hit the equal prefixes of both strands
+        for (size_t i = 100; i < 200; ++i)
+            s[i] = nucl((char)(i % 2 ? 0 : 3));
+
+        CanonicalKMerRoller<RtSeq> roller(RtSeq(k, s.substr(0, k)));
+        for (size_t i = k; ; ++i) {
+            RtSeq kmer(k, s.substr(i - k, k));
+            ASSERT_EQ(kmer, roller.forward());
+            ASSERT_EQ(!kmer, roller.reverse_complement());
+            ASSERT_EQ(kmer.IsMinimal(), roller.IsMinimal());
+            ASSERT_EQ(kmer.IsMinimal() ? kmer : !kmer, roller.canonical());
+            ASSERT_EQ(roller.GetHash(), CanonicalKMerRoller<RtSeq>(!kmer).GetHash());
+            if (i == s.size())
+                break;
+            roller <<= s[i];
+        }
+    }
+}
@@ -4,6 +4,7 @@
 //* See file LICENSE for details.
 //***************************************************************************
 
+#include "sequence/canonical_kmer_roller.hpp"
 #include "sequence/seq.hpp"
 #include "sequence/sequence.hpp"
 #include "sequence/nucl.hpp"
@@ -159,3 +160,19 @@ TEST( Seq, TestFirstLast ) {
     EXPECT_EQ(3, s2.first());
     EXPECT_EQ(3, s2.last());
 }
+
+TEST( Seq, CanonicalKMerRoller ) {
+    std::string s = "ACGTTGCATTTACGGACGTACGTACGTCCCGATAGCTAGCTTTTTTAAAAAGCGCGCGATATATCGT";
+    CanonicalKMerRoller<Seq<21>> roller(Seq<21>(s.substr(0, 21).c_str()));
+    for (size_t i = 21; ; ++i) {
+        Seq<21> kmer(s.substr(i - 21, 21).c_str());
+        EXPECT_EQ(kmer, roller.forward());
+        EXPECT_EQ(!kmer, roller.reverse_complement());
+        std::string str = kmer.str(), rc = (!kmer).str();
+        EXPECT_EQ(str <= rc, roller.IsMinimal());
+        EXPECT_EQ(str <= rc ? kmer : !kmer, roller.canonical());
+        if (i == s.size())
+            break;
+        roller <<= s[i];
+    }
+}